@@ -2,123 +2,297 @@
 
 #include "command.h"
 #include "irdevice.h"
+#include "irrawcode.h"
+#include "irschedule.h"
 #include <stdio.h>
 
-int Command::count_ = 0;
+//  Both lanes full, as many replies waiting, plus the command being sent, its repeat
+//  copy and a pending ir_get
+#define COMMAND_POOL_SIZE   (2 * (COMMAND_QUEUE_DEPTH + COMMAND_HIGH_DEPTH) + 3)
 
-Command::Command(WEB *web, ClientHandle client, const JSONMap &msgmap, const RemoteFile::Button *button)
-    :web_(web), client_(client), button_(0), duration_(0.0), repeat_(0), row_(0)
+std::atomic<int> Command::count_(0);
+
+union Command::PoolSlot
+{
+    alignas(Command) uint8_t data[sizeof(Command)];
+};
+
+Command::PoolSlot Command::pool_[COMMAND_POOL_SIZE];
+queue_t Command::pool_free_;
+bool Command::pool_init_ = false;
+std::atomic<int> Command::pool_peak_(0);
+std::atomic<uint32_t> Command::pool_allocs_(0);
+std::atomic<uint32_t> Command::pool_failures_(0);
+
+void Command::initPool()
+{
+    if (!pool_init_)
+    {
+        queue_init(&pool_free_, sizeof(PoolSlot *), COMMAND_POOL_SIZE);
+        for (int ii = 0; ii < COMMAND_POOL_SIZE; ii++)
+        {
+            PoolSlot *slot = &pool_[ii];
+            queue_try_add(&pool_free_, &slot);
+        }
+        pool_init_ = true;
+    }
+}
+
+void *Command::operator new(size_t size) noexcept
+{
+    PoolSlot *slot = nullptr;
+    if (pool_init_ && queue_try_remove(&pool_free_, &slot))
+    {
+        ++pool_allocs_;
+        //  Both cores allocate and free records
+        int in_use = COMMAND_POOL_SIZE - queue_get_level(&pool_free_);
+        int peak = pool_peak_;
+        while (in_use > peak && !pool_peak_.compare_exchange_weak(peak, in_use));
+    }
+    else
+    {
+        slot = nullptr;
+        ++pool_failures_;
+    }
+    return slot;
+}
+
+void Command::operator delete(void *ptr)
+{
+    PoolSlot *slot = static_cast<PoolSlot *>(ptr);
+    if (slot >= &pool_[0] && slot < &pool_[COMMAND_POOL_SIZE])
+    {
+        queue_try_add(&pool_free_, &slot);
+    }
+}
+
+void Command::poolStats(PoolStats &stats)
+{
+    stats.capacity = COMMAND_POOL_SIZE;
+    stats.in_use = pool_init_ ? COMMAND_POOL_SIZE - queue_get_level(&pool_free_) : 0;
+    stats.peak = pool_peak_;
+    stats.allocs = pool_allocs_;
+    stats.failures = pool_failures_;
+}
+
+Command::Command(WEB *web, ClientHandle client, const JSONMap &msgmap, const RemoteFile *file, const RemoteFile::Button *button)
+    :web_(web), client_(client), action_(CMD_NONE), button_(0), duration_(0.0), repeat_(0), row_(0), times_(1), estimate_(0),
+     file_(nullptr), has_step_(false), reply_len_(0)
 {
-    url_ = msgmap.strValue("path", "");
+    strncpy(url_, msgmap.strValue("path", ""), sizeof(url_) - 1);
+    url_[sizeof(url_) - 1] = 0;
+    reply_[0] = 0;
+
     const char *func = msgmap.strValue("func");
     if (func && strcmp(func, "btnVal") == 0)
     {
-        action_ = msgmap.strValue("action", "");
+        const char *action = msgmap.strValue("action", "");
+        for (int act = CMD_CLICK; act <= CMD_CANCEL; act++)
+        {
+            if (strcmp(action, actionName(static_cast<Action>(act))) == 0)
+            {
+                action_ = static_cast<Action>(act);
+            }
+        }
         duration_ = msgmap.realValue("duration");
 
-        if (button)
+        if (button && file)
         {
-            label_ = button->label()[0] == '@' ? button->label() + 1 : button->label();
+            file_ = file;
+            file_->pin();
             button_ = button->position();
-            redirect_ = button->redirect();
             repeat_ = button->repeat();
-            for (auto it = button->actions().cbegin(); it != button->actions().cend(); ++it)
+            label_ = button->label();
+            redirect_ = button->redirect();
+            if (button->plan().size() == button->actions().size())
+            {
+                plan_ = button->plan();
+            }
+            else
             {
-                steps_.emplace_back(*it);
+                //  Edited since the file loaded
+                for (auto it = button->actions().cbegin(); it != button->actions().cend(); ++it)
+                {
+                    plan_.add(it->type(), it->address(), it->value(), it->delay());
+                }
             }
         }
     }
     else if (func && strcmp(func, "test_send") == 0)
     {
-        action_ = "test_send";
+        action_ = CMD_TEST_SEND;
         const char *type = msgmap.strValue("type");
-        if (type && IR_Device::validProtocol(type))
+        if (type && (IR_Device::validProtocol(type) || IR_RawCode::valid(type)))
         {
-            steps_.emplace_back(type, msgmap.intValue("address"), msgmap.intValue("value"), 0);
+            step_ = Step(type, msgmap.intValue("address"), msgmap.intValue("value"), 0);
+            has_step_ = true;
         }
     }
     else if (func && strcmp(func, "ir_get") == 0)
     {
-        action_ = "ir_get";
+        action_ = CMD_IR_GET;
         row_ = msgmap.intValue("ir_get");
     }
+    else if (func && strcmp(func, "sniff") == 0)
+    {
+        action_ = CMD_SNIFF;
+        row_ = msgmap.intValue("sniff");
+    }
 
     ++count_;
     //printf("Command count: %d (new)  %p\n", count_, this);
 }
 
 Command::Command(const Command &other)
+    : web_(other.web_), client_(other.client_), action_(other.action_), button_(other.button_),
+      duration_(other.duration_), repeat_(other.repeat_), row_(other.row_), times_(other.times_),
+      estimate_(other.estimate_), file_(other.file_), label_(other.label_), redirect_(other.redirect_),
+      plan_(other.plan_), step_(other.step_), has_step_(other.has_step_), reply_len_(other.reply_len_)
 {
-    web_ = other.web_;
-    client_ = other.client_;
-    button_ = other.button_;
-    action_ = other.action_;
-    url_ = other.url_;
-    duration_ = other.duration_;
-    redirect_ = other.redirect_;
-    repeat_ = other.repeat_;
-    steps_ = other.steps_;
-    row_ = other.row_;
-    reply_ = other.reply_;
+    memcpy(url_, other.url_, sizeof(url_));
+    memcpy(reply_, other.reply_, sizeof(reply_));
+    if (file_)
+    {
+        file_->pin();
+    }
     ++count_;
     //printf("Command count: %d (copy) %p\n", count_, this);
 }
 
 Command::~Command()
 {
+    if (file_)
+    {
+        file_->unpin();
+    }
     --count_;
     //printf("Command count: %d (des)  %p\n", count_, this);
 }
 
+const char *Command::actionName(Action action)
+{
+    static const char *names[] = {"", "click", "press", "release", "cancel", "test_send", "ir_get", "sniff"};
+    return names[action];
+}
+
+void Command::getPlan(IRPlan &plan) const
+{
+    if (has_step_)
+    {
+        plan.clear();
+        plan.add(step_.type().c_str(), step_.address(), step_.value(), step_.delay());
+    }
+    else
+    {
+        plan = plan_;
+    }
+}
+
+void Command::setEstimate(IRPlan &plan)
+{
+    getPlan(plan);
+    estimate_ = IRSchedule::duration(plan, plan.size());
+}
+
 void Command::setStep(const std::string &type, uint16_t address, uint16_t value)
 {
-    steps_.clear();
-    steps_.emplace_back(type, address, value, 0);
+    step_ = Step(type, address, value, 0);
+    has_step_ = true;
+}
+
+void Command::addReply(const char *key, const char *value)
+{
+    //  Leave room for the closing brace; drop the entry if it does not fit
+    int len = reply_len_;
+    int max = sizeof(reply_) - 2;
+    len += snprintf(reply_ + len, max > len ? max - len : 0, "%s\"%s\":\"", len == 0 ? "{" : ",", key);
+    for (const char *cp = value; *cp && len < max; ++cp)
+    {
+        if (*cp == '"' || *cp == '\\')
+        {
+            reply_[len++] = '\\';
+            reply_[len++] = *cp;
+        }
+        else if (static_cast<uint8_t>(*cp) < ' ')
+        {
+            len += snprintf(reply_ + len, max - len, "\\u%04x", *cp);
+        }
+        else
+        {
+            reply_[len++] = *cp;
+        }
+    }
+    if (len < max)
+    {
+        reply_[len++] = '"';
+        reply_len_ = len;
+    }
+    reply_[reply_len_] = 0;
 }
 
-void Command::setReply(const std::string &action, bool use_redirect)
+void Command::setReply(const char *action, bool use_redirect)
 {
-    reply_.clear();
-    reply_["button"] = std::to_string(button_);
-    reply_["label"] = label_;
-    reply_["action"] = action;
-    reply_["url"] = url_;
+    reply_len_ = 0;
+    const char *label = label_.c_str();
+    if (*label == '@') ++label;
+    char num[12];
 
-    if (action_ == "ir_get")
+    if (action_ == CMD_IR_GET)
     {
-        reply_["func"] = "ir_resp";
-        reply_["ir_resp"] = std::to_string(row_);
-        if (steps_.size() == 1)
+        addReply("func", "ir_resp");
+        snprintf(num, sizeof(num), "%d", row_);
+        addReply("ir_resp", num);
+        if (has_step_)
+        {
+            addReply("type", step_.type().c_str());
+            snprintf(num, sizeof(num), "%d", step_.address());
+            addReply("address", num);
+            snprintf(num, sizeof(num), "%d", step_.value());
+            addReply("value", num);
+            snprintf(num, sizeof(num), "%d", step_.delay());
+            addReply("delay", num);
+        }
+        else
         {
-            reply_["type"] = steps_.front().type();
-            reply_["address"] = std::to_string(steps_.front().address());
-            reply_["value"] = std::to_string(steps_.front().value());
-            reply_["delay"] = std::to_string(steps_.front().delay());
+            addReply("type", "");
         }
     }
-    else if (action_ == "test_send")
+    else if (action_ == CMD_TEST_SEND)
+    {
+        addReply("func", "send_resp");
+    }
+    else if (action_ == CMD_SNIFF)
     {
-        reply_["func"] = "send_resp";
+        addReply("func", "sniff_resp");
     }
     else
     {
-        reply_["func"] = "btn_resp";
+        addReply("func", "btn_resp");
         if (use_redirect)
         {
-            reply_["redirect"] = make_redirect(url_, redirect_);
+            const char *redir = redirect();
+            addReply("redirect", *redir ? make_redirect(url_, redir).c_str() : "");
         }
     }
+
+    snprintf(num, sizeof(num), "%d", button_);
+    addReply("button", num);
+    addReply("label", label);
+    addReply("action", action);
+    addReply("url", url_);
 }
 
-void Command::setReplyValue(const std::string &key, const std::string &value)
+void Command::setReplyValue(const char *key, int value)
 {
-    reply_[key] = value;
+    char num[12];
+    snprintf(num, sizeof(num), "%d", value);
+    addReply(key, num);
 }
 
 std::string Command::reply() const
 {
-    std::string ret;
-    JSONMap::fromMap(reply_, ret);
+    std::string ret(reply_, reply_len_);
+    ret += '}';
     return ret;
 }
 
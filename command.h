@@ -4,11 +4,18 @@
 #define COMMAND_H
 
 #include "remotefile.h"
+#include "irplan.h"
 #include "jsonmap.h"
 #include "web.h"
+#include <atomic>
 #include <string>
-#include <vector>
 #include <stdint.h>
+#include <string.h>
+#include <pico/util/queue.h>
+
+#define COMMAND_QUEUE_DEPTH 8               // Depth of the normal command lane
+#define COMMAND_HIGH_DEPTH  4               // Depth of the high priority command lane
+#define COMMAND_REPLY_DEPTH 16              // Depth of the reply queue (both lanes)
 
 class Command
 {
@@ -39,52 +46,141 @@ public:
         void setDelay(uint16_t delay) { delay_ = delay; }
     };
 
+    enum Action
+    {
+        CMD_NONE,                           // Unrecognized
+        CMD_CLICK,                          // Button click
+        CMD_PRESS,                          // Button press (start repeat)
+        CMD_RELEASE,                        // Button release (end repeat)
+        CMD_CANCEL,                         // Cancel repeat
+        CMD_TEST_SEND,                      // Send single IR message
+        CMD_IR_GET,                         // Receive IR message
+        CMD_SNIFF                           // Start or stop sniffing
+    };
+
+    struct PoolStats
+    {
+        int             capacity;           // Records in pool
+        int             in_use;             // Records currently allocated
+        int             peak;               // Most records allocated at once
+        uint32_t        allocs;             // Allocation count
+        uint32_t        failures;           // Allocations refused (pool exhausted)
+    };
+
+    static const int    MAX_URL = 128;      // Maximum URL path length
+    static const int    MAX_REPLY = 384;    // Maximum reply length
+
 private:
     WEB                 *web_;              // Pointer to web object
     ClientHandle        client_;            // Handle to web client
 
+    Action              action_;            // Command action
     int                 button_;            // Button position
-    std::string         label_;             // Button label (w/o leading @)
-    std::string         action_;            // Command action
-    std::string         url_;               // Original URL
+    char                url_[MAX_URL];      // Original URL
     double              duration_;          // Button hold duration
-
-    std::string         redirect_;          // Redirection after command
     int                 repeat_;            // Delay before beginning repetition
-    std::vector<Step>   steps_;             // Command steps
-
-    int                 row_;               // Action row number
+    int                 row_;               // Action row number (1 to sniff for CMD_SNIFF)
+    int                 times_;             // Times to send the steps (merged clicks)
+    uint32_t            estimate_;          // Estimated time of one send (msec)
+
+    const RemoteFile    *file_;             // Action file holding the button (pinned)
+    std::string         label_;             // Button label
+    std::string         redirect_;          // Button redirect
+    IRPlan              plan_;              // Button steps
+    Step                step_;              // Single step (test_send, ir_get)
+    bool                has_step_;          // step_ is set
+
+    char                reply_[MAX_REPLY];  // Reply JSON
+    int                 reply_len_;         // Reply length (less closing brace)
+
+    static std::atomic<int> count_;         // Instance count
+
+    union PoolSlot;
+    static PoolSlot     pool_[];            // Command record pool
+    static queue_t      pool_free_;         // Free pool records
+    static bool         pool_init_;         // Pool initialized
+    static std::atomic<int> pool_peak_;     // Most records in use
+    static std::atomic<uint32_t> pool_allocs_;      // Allocation count
+    static std::atomic<uint32_t> pool_failures_;    // Allocations refused
 
-    JSONMap::JMAP       reply_;             // Reply
-
-    static int          count_;             // Instance count
-    
     Command();
 
+    void addReply(const char *key, const char *value);
+
 public:
-    Command(WEB *web, ClientHandle client, const JSONMap &msgmap, const RemoteFile::Button *button);
+    Command(WEB *web, ClientHandle client, const JSONMap &msgmap, const RemoteFile *file, const RemoteFile::Button *button);
     Command(const Command &other);
     ~Command();
 
+    /**
+     * @brief   Allocate command records from a fixed pool
+     * 
+     * @details The pool holds enough records to fill both queues plus those
+     *          held by the IR processor. There is no heap fallback: when the
+     *          pool is exhausted new returns null and the caller must refuse
+     *          the request.
+     */
+    static void *operator new(size_t size) noexcept;
+    static void operator delete(void *ptr);
+    static void initPool();
+    static void poolStats(PoolStats &stats);
+    static int count() { return count_; }
+
     WEB *web() const { return web_; }
     ClientHandle client() const { return client_; }
     int button() const { return button_; }
-    const std::string &action() const { return action_; }
-    const std::string &url() const { return url_; }
+    Action action() const { return action_; }
+    const char *actionName() const { return actionName(action_); }
+    const char *url() const { return url_; }
     const double duration() const { return duration_; }
-    const std::string &redirect() const { return redirect_; }
+    const char *redirect() const { return redirect_.c_str(); }
     int repeat() const { return repeat_; }
-    const std::vector<Step> &steps() { return steps_; }
+    int times() const { return times_; }
+    int row() const { return row_; }
+    void addTime() { ++times_; }
+
+    /**
+     * @brief   Estimate the send time
+     * 
+     * @details From the protocol frame times and delays of the steps, menu
+     *          actions expanded without moving the menus. Call on the web
+     *          core before the command is queued.
+     * 
+     * @param   plan    Work plan (reused to save allocations)
+     */
+    void setEstimate(IRPlan &plan);
+
+    /**
+     * @brief   Get the estimated send time of all merged clicks
+     * 
+     * @return  Time (msec)
+     */
+    uint32_t estimate() const { return estimate_ * times_; }
+
+    /**
+     * @brief   Get the compiled steps to send
+     * 
+     * @details The button's steps are copied with its label and redirect
+     *          when the command is made on the web core, so the IR core
+     *          never reads the action file, which the web side may edit or
+     *          reload meanwhile. The command still pins the file, so the
+     *          page it came from stays cached while it is queued or running.
+     * 
+     * @param   plan    Receives the steps
+     */
+    void getPlan(IRPlan &plan) const;
     void setStep(const std::string &type, uint16_t address, uint16_t value);
-    std::string reply() const;
 
+    std::string reply() const;
     void setRepeat(int repeat) { repeat_ = repeat; }
-    void setReply(const std::string &action, bool use_redirect=true);
-    void setReplyValue(const std::string &key, const std::string &value);
+    void setReply(const char *action, bool use_redirect=true);
+    void setReplyValue(const char *key, int value);
 
+    static const char *actionName(Action action);
     static std::string make_redirect(const std::string &base, const std::string &redirect);
 
-    bool operator ==(const Command &other) const {return url_ == other.url_ && action_ == other.action_ && button_ == other.button_;}
+    bool operator ==(const Command &other) const
+        { return action_ == other.action_ && button_ == other.button_ && strcmp(url_, other.url_) == 0; }
 };
 
 #endif
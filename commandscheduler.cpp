@@ -0,0 +1,158 @@
+//                  *****  CommandScheduler class implementation  *****
+
+#include "commandscheduler.h"
+#include <string.h>
+
+CommandScheduler::CommandScheduler() : next_(0), tick_(0), waiting_(0)
+{
+    for (int ii = 0; ii < SCHEDULER_CLIENTS; ii++)
+    {
+        memset(&slots_[ii].stats, 0, sizeof(slots_[ii].stats));
+        slots_[ii].used = 0;
+        slots_[ii].credit = 0;
+    }
+}
+
+CommandScheduler::~CommandScheduler()
+{
+    for (int ii = 0; ii < SCHEDULER_CLIENTS; ii++)
+    {
+        for (auto it = slots_[ii].queue.begin(); it != slots_[ii].queue.end(); ++it)
+        {
+            delete it->cmd;
+        }
+    }
+}
+
+int CommandScheduler::slot(ClientHandle client)
+{
+    int ret = -1;
+    for (int ii = 0; ii < SCHEDULER_CLIENTS; ii++)
+    {
+        if (slots_[ii].stats.client == client && slots_[ii].used != 0)
+        {
+            return ii;
+        }
+        //  Reuse the least recently used idle slot
+        if (slots_[ii].queue.empty() && (ret < 0 || slots_[ii].used < slots_[ret].used))
+        {
+            ret = ii;
+        }
+    }
+
+    if (ret >= 0)
+    {
+        memset(&slots_[ret].stats, 0, sizeof(slots_[ret].stats));
+        slots_[ret].stats.client = client;
+        slots_[ret].credit = 0;
+    }
+    return ret;
+}
+
+bool CommandScheduler::add(Command *cmd)
+{
+    int ss = slot(cmd->client());
+    if (ss < 0)
+    {
+        return false;
+    }
+
+    Slot &sl = slots_[ss];
+    sl.used = ++tick_;
+    if (cmd->action() == Command::CMD_CLICK)
+    {
+        for (auto it = sl.queue.begin(); it != sl.queue.end(); ++it)
+        {
+            if (*it->cmd == *cmd && it->cmd->times() < SCHEDULER_COALESCE)
+            {
+                if (sl.stats.backlog_ms + cmd->estimate() > SCHEDULER_BACKLOG_MS)
+                {
+                    ++sl.stats.refused;
+                    return false;
+                }
+                it->cmd->addTime();
+                sl.stats.backlog_ms += cmd->estimate();
+                ++sl.stats.coalesced;
+                delete cmd;
+                return true;
+            }
+        }
+    }
+
+    //  A client with nothing waiting is always accepted, however long the command
+    if (!sl.queue.empty() && sl.stats.backlog_ms + cmd->estimate() > SCHEDULER_BACKLOG_MS)
+    {
+        ++sl.stats.refused;
+        return false;
+    }
+
+    sl.queue.push_back({cmd, get_absolute_time()});
+    sl.stats.backlog_ms += cmd->estimate();
+    ++waiting_;
+    ++sl.stats.queued;
+    sl.stats.depth = sl.queue.size();
+    if (sl.stats.depth > sl.stats.peak)
+    {
+        sl.stats.peak = sl.stats.depth;
+    }
+    return true;
+}
+
+Command *CommandScheduler::next()
+{
+    Command *ret = nullptr;
+    while (waiting_ > 0 && !ret)
+    {
+        Slot &sl = slots_[next_];
+        if (!sl.queue.empty() && sl.credit >= sl.queue.front().cmd->estimate())
+        {
+            Entry &entry = sl.queue.front();
+            ret = entry.cmd;
+            uint32_t wait = absolute_time_diff_us(entry.queued, get_absolute_time()) / 1000;
+            sl.queue.pop_front();
+            --waiting_;
+
+            sl.credit -= ret->estimate();
+            sl.stats.backlog_ms -= ret->estimate();
+            sl.stats.depth = sl.queue.size();
+            ++sl.stats.served;
+            sl.stats.wait_ms += wait;
+            if (wait > sl.stats.max_wait_ms)
+            {
+                sl.stats.max_wait_ms = wait;
+            }
+        }
+        else
+        {
+            //  Turn passes to the next client with commands waiting; credit
+            //  is not carried by an idle client
+            if (sl.queue.empty())
+            {
+                sl.credit = 0;
+            }
+            next_ = (next_ + 1) % SCHEDULER_CLIENTS;
+            if (!slots_[next_].queue.empty())
+            {
+                slots_[next_].credit += SCHEDULER_QUANTUM_MS;
+            }
+        }
+    }
+    if (ret && slots_[next_].queue.empty())
+    {
+        slots_[next_].credit = 0;
+    }
+    return ret;
+}
+
+int CommandScheduler::getStats(ClientStats *stats, int max) const
+{
+    int ret = 0;
+    for (int ii = 0; ii < SCHEDULER_CLIENTS && ret < max; ii++)
+    {
+        if (slots_[ii].used != 0)
+        {
+            stats[ret++] = slots_[ii].stats;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,114 @@
+//                  *****  CommandScheduler class  *****
+
+#ifndef COMMANDSCHEDULER_H
+#define COMMANDSCHEDULER_H
+
+#include "command.h"
+#include "web.h"
+#include <deque>
+#include <stdint.h>
+#include <pico/time.h>
+
+#ifndef SCHEDULER_CLIENTS
+#define SCHEDULER_CLIENTS   8               // Clients with a queue at one time
+#endif
+#ifndef SCHEDULER_COALESCE
+#define SCHEDULER_COALESCE  8               // Most clicks merged into one send
+#endif
+#ifndef SCHEDULER_QUANTUM_MS
+#define SCHEDULER_QUANTUM_MS 250            // Send time granted a client each turn (msec)
+#endif
+#ifndef SCHEDULER_BACKLOG_MS
+#define SCHEDULER_BACKLOG_MS 30000          // Most estimated send time queued per client (msec)
+#endif
+
+/**
+ * @brief   Fair scheduler for normal lane commands
+ * 
+ * @details Each client has its own FIFO and the clients take turns by
+ *          estimated send time (deficit round robin): each turn grants a
+ *          client a quantum of time, and it is served while its credit
+ *          covers the estimate of its next command, so a long macro waits
+ *          for credit while other clients' short commands go out. A
+ *          command is refused when the client already has more than the
+ *          backlog limit of send time waiting. A click identical to one
+ *          still queued for the same client is merged into it, raising its
+ *          send count, rather than queued as another full sequence.
+ * 
+ *          Used on the IR core only. Client slots are fixed so that the
+ *          statistics can be read from the web core while commands flow.
+ */
+class CommandScheduler
+{
+public:
+    struct ClientStats
+    {
+        ClientHandle    client;             // Client handle (0 if slot unused)
+        uint32_t        depth;              // Commands waiting
+        uint32_t        peak;               // Most commands waiting
+        uint32_t        queued;             // Commands queued
+        uint32_t        coalesced;          // Commands merged into a queued one
+        uint32_t        served;             // Commands taken
+        uint32_t        wait_ms;            // Total wait of commands taken (msec)
+        uint32_t        max_wait_ms;        // Longest wait (msec)
+        uint32_t        backlog_ms;         // Estimated send time waiting (msec)
+        uint32_t        refused;            // Commands refused (backlog full)
+    };
+
+private:
+    struct Entry
+    {
+        Command         *cmd;               // Queued command
+        absolute_time_t queued;             // Time queued
+    };
+
+    struct Slot
+    {
+        ClientStats     stats;              // Client statistics
+        std::deque<Entry> queue;            // Waiting commands
+        uint32_t        used;               // Last use tick
+        uint32_t        credit;             // Send time credit (msec)
+    };
+    Slot                slots_[SCHEDULER_CLIENTS];  // Client slots
+    int                 next_;              // Slot to serve next
+    uint32_t            tick_;              // Use counter
+    int                 waiting_;           // Commands waiting, all clients
+
+    int slot(ClientHandle client);
+
+public:
+    CommandScheduler();
+    ~CommandScheduler();
+
+    /**
+     * @brief   Queue a command
+     * 
+     * @param   cmd     Command (owned by the scheduler if accepted)
+     * 
+     * @return  false if there is no free client slot or the client's
+     *          backlog is full
+     */
+    bool add(Command *cmd);
+
+    /**
+     * @brief   Take the next command, round robin across clients by
+     *          estimated send time
+     * 
+     * @return  Command (now owned by the caller) or null if none waiting
+     */
+    Command *next();
+
+    bool empty() const { return waiting_ == 0; }
+
+    /**
+     * @brief   Copy the client statistics
+     * 
+     * @param   stats   Array to receive the used slots
+     * @param   max     Size of array
+     * 
+     * @return  Number of clients copied
+     */
+    int getStats(ClientStats *stats, int max) const;
+};
+
+#endif
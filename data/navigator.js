@@ -25,6 +25,7 @@ document.addEventListener("DOMContentLoaded", () =>
             '<button type="button" dest="/backup">Backup</button><br>' +
             '<button type="button" dest="/test">IR Test</button><br>' +
             '<button type="button" dest="/log">Log</button><br>' +
+            '<button type="button" dest="/diag">Diagnostics</button><br>' +
             '</div>';
         h1.insertAdjacentHTML('beforebegin', html);
 
@@ -21,7 +21,7 @@ function load_ir(row)
     }
     else if (nam || lbl)
     {
-        ntc.innerHTML = "Click button on remote";
+        ntc.innerHTML = "Click button on remote two or three times";
         let msg = '{"func": "ir_get", "ir_get": ' + row + ', "path": "' + document.location.pathname + '"}'
         console.log(msg);
         sendToWS(msg);
@@ -71,7 +71,7 @@ function process_ws_message(evt)
         else
         {
             let ntc = document.getElementById("irget");
-            ntc.innerHTML = "Did not read a known code";
+            ntc.innerHTML = msg.action == "busy" ? "Already reading a code, try again" : "Did not read a known code";
         }
     }
     catch(e)
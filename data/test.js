@@ -2,14 +2,25 @@
 
 document.addEventListener('DOMContentLoaded', function()
 {
+    document.addEventListener('ws_state', ws_state_change);
     document.addEventListener('ws_message', process_ws_message);
     openWS();
 });
 
+function ws_state_change(evt)
+{
+    if (evt.detail.obj['open'])
+    {
+        let msg = '{"func": "sniff_log", "path": "' + document.location.pathname + '"}';
+        console.log(msg);
+        sendToWS(msg);
+    }
+}
+
 function load_ir()
 {
     let ntc = document.getElementById("ntc");
-    ntc.innerHTML = "Click button on remote";
+    ntc.innerHTML = "Click button on remote two or three times";
     let msg = '{"func": "ir_get", "ir_get": "0", "path": "' + document.location.pathname + '"}'
     console.log(msg);
     sendToWS(msg);
@@ -35,6 +46,58 @@ function send_ir()
     }
 }
 
+function set_sniff()
+{
+    let on = document.getElementById("sniff").checked ? "1" : "0";
+    let msg = '{"func":"sniff", "sniff":"' + on + '", "path": "' + document.location.pathname + '"}'
+    console.log(msg);
+    sendToWS(msg);
+}
+
+function set_type(type)
+{
+    let ele = document.getElementById("typ");
+    if (!Array.from(ele.options).some(opt => opt.value == type))
+    {
+        //  Raw code: not one of the protocols
+        ele.add(new Option(type.substring(0, 12) + "...", type));
+    }
+    ele.value = type;
+}
+
+function use_frame(type, address, value)
+{
+    set_type(type);
+    document.getElementById("add").value = address;
+    document.getElementById("val").value = value;
+}
+
+function show_frames(msg)
+{
+    document.getElementById("sniff").checked = msg.sniff == "1";
+    let body = document.getElementById("frames");
+    body.innerHTML = "";
+    for (let frame of msg.frames.slice().reverse())
+    {
+        let row = body.insertRow();
+        let when = frame.time != 0 ? new Date(frame.time * 1000).toLocaleTimeString()
+                                   : (frame.age / 1000).toFixed(1) + "s ago";
+        let type = frame.type == "" ? "?" : (frame.type.length > 12 ? frame.type.substring(0, 12) + "..." : frame.type);
+        for (let text of [frame.seq, when, type, frame.address, frame.value, frame.repeats])
+        {
+            row.insertCell().textContent = text;
+        }
+        if (frame.type != "")
+        {
+            let btn = document.createElement("button");
+            btn.type = "button";
+            btn.textContent = "Use";
+            btn.onclick = ()=>{use_frame(frame.type, frame.address, frame.value);};
+            row.insertCell().appendChild(btn);
+        }
+    }
+}
+
 function process_ws_message(evt)
 {
     try
@@ -45,16 +108,23 @@ function process_ws_message(evt)
         let func = msg.func;
         if (func == 'ir_resp' && msg.type != "")
         {
-            let ele = document.getElementById("typ");
-            ele.value = msg.type;
+            set_type(msg.type);
 
-            ele = document.getElementById("add");
+            let ele = document.getElementById("add");
             ele.value = msg.address;
 
             ele = document.getElementById("val");
             ele.value = msg.value;
 
-            ntc.innerHTML = "&nbsp";
+            ntc.innerHTML = msg.confidence !== undefined ? "Confidence " + msg.confidence + "%" : "&nbsp";
+        }
+        else if (func == "sniff_log")
+        {
+            show_frames(msg);
+        }
+        else if (func == "sniff_resp")
+        {
+            document.getElementById("sniff").checked = msg.sniff == "1";
         }
         else if (func == "send_resp")
         {
@@ -63,7 +133,7 @@ function process_ws_message(evt)
         }
         else
         {
-            ntc.innerHTML = "Did not read a known code";
+            ntc.innerHTML = msg.action == "busy" ? "Already reading a code, try again" : "Did not read a known code";
         }
     }
     catch(e)
@@ -68,6 +68,10 @@ function process_ws_message(evt)
             }
         }
     }
+    else if (func == "time_resp")
+    {
+        showLED("progress", parseInt(obj.duration));
+    }
 }
 
 function processPointerEvent(event)
@@ -101,6 +105,8 @@ function processPointerEvent(event)
                     click_timer = undefined;
                     action = "click";
                     showLED("on");
+                    sendToWS('{"func": "btn_time", "btn_time": "' + ele.value +
+                              '", "path": "' + document.location.pathname + '" }');
                 }
                 
                 sendToWS('{"func": "btnVal", "btnVal": "' + ele.value +
@@ -154,7 +160,7 @@ function stop_repeat()
     }
 }
 
-function showLED(state)
+function showLED(state, msec)
 {
     led = document.getElementById("led")
     if (isWSOpen())
@@ -164,6 +170,15 @@ function showLED(state)
             led.innerHTML = "<svg viewbox='0 0 25 25' width='25' height='25' xmlns='http://www.w3.org/2000/svg'>" +
                             "<circle cx='12' cy='12' r='12' fill='red' stroke='white' stroke-width='3' /></svg>"
         }
+        else if (state == "progress")
+        {
+            led.innerHTML = "<svg viewbox='0 0 25 25' width='25' height='25' xmlns='http://www.w3.org/2000/svg'>" +
+                            "<circle cx='12' cy='12' r='12' fill='red' stroke='white' stroke-width='3' />" +
+                            "<circle cx='12' cy='12' r='10.5' fill='none' stroke='orange' stroke-width='3' " +
+                            "pathLength='100' stroke-dasharray='100' stroke-dashoffset='100' transform='rotate(-90 12 12)'>" +
+                            "<animate attributeName='stroke-dashoffset' from='100' to='0' dur='" + msec +
+                            "ms' fill='freeze' /></circle></svg>"
+        }
         else if (state == "busy")
         {
             led.innerHTML = "<svg viewbox='0 0 25 25' width='25' height='25' xmlns='http://www.w3.org/2000/svg'>" +
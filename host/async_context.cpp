@@ -0,0 +1,205 @@
+//                  *****  Host async context implementation  *****
+
+#include "pico/async_context.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct host_async_context
+{
+    std::recursive_mutex                        lock;
+    std::mutex                                  wake_lock;
+    std::condition_variable                     wake;
+    bool                                        woken = false;
+    std::vector<async_at_time_worker_t *>       at_time;
+    std::vector<async_when_pending_worker_t *>  when_pending;
+    std::thread                                 thread;
+    bool                                        stop = false;
+
+    void run(async_context_t *context);
+    void kick();
+};
+
+static thread_local async_context_t *current_context = nullptr;
+
+void host_async_context::run(async_context_t *context)
+{
+    current_context = context;
+    std::unique_lock<std::recursive_mutex> guard(lock);
+    while (!stop)
+    {
+        bool worked = false;
+        absolute_time_t now = get_absolute_time();
+        for (auto it = at_time.begin(); it != at_time.end(); ++it)
+        {
+            async_at_time_worker_t *worker = *it;
+            if (absolute_time_diff_us(now, worker->next_time) <= 0)
+            {
+                at_time.erase(it);
+                worker->do_work(context, worker);
+                worked = true;
+                break;
+            }
+        }
+
+        for (size_t ii = 0; ii < when_pending.size(); ii++)
+        {
+            async_when_pending_worker_t *worker = when_pending.at(ii);
+            if (worker->work_pending)
+            {
+                worker->work_pending = false;
+                worker->do_work(context, worker);
+                worked = true;
+            }
+        }
+
+        if (!worked)
+        {
+            absolute_time_t next = now + 100000;
+            for (auto it = at_time.cbegin(); it != at_time.cend(); ++it)
+            {
+                next = std::min(next, (*it)->next_time);
+            }
+            guard.unlock();
+            {
+                std::unique_lock<std::mutex> wait(wake_lock);
+                wake.wait_for(wait, std::chrono::microseconds(absolute_time_diff_us(now, next)), [this]() { return woken; });
+                woken = false;
+            }
+            guard.lock();
+        }
+    }
+}
+
+//  The wake lock is never held while taking another lock, so any thread
+//  holding any context lock can wake any context
+void host_async_context::kick()
+{
+    std::lock_guard<std::mutex> guard(wake_lock);
+    woken = true;
+    wake.notify_all();
+}
+
+bool host_async_context_init(async_context_t *context)
+{
+    context->impl = new host_async_context();
+    context->impl->thread = std::thread([context]() { context->impl->run(context); });
+    current_context = context;
+    return true;
+}
+
+async_context_t *host_async_context_create()
+{
+    async_context_t *context = new async_context_t();
+    host_async_context_init(context);
+    return context;
+}
+
+async_context_t *host_async_context_current()
+{
+    return current_context;
+}
+
+void host_async_context_delete(async_context_t *context)
+{
+    if (context)
+    {
+        {
+            std::lock_guard<std::recursive_mutex> guard(context->impl->lock);
+            context->impl->stop = true;
+            context->impl->kick();
+        }
+        context->impl->thread.join();
+        delete context->impl;
+        delete context;
+    }
+}
+
+bool async_context_add_at_time_worker(async_context_t *context, async_at_time_worker_t *worker)
+{
+    std::lock_guard<std::recursive_mutex> guard(context->impl->lock);
+    if (std::find(context->impl->at_time.cbegin(), context->impl->at_time.cend(), worker) == context->impl->at_time.cend())
+    {
+        context->impl->at_time.push_back(worker);
+    }
+    context->impl->kick();
+    return true;
+}
+
+bool async_context_add_at_time_worker_at(async_context_t *context, async_at_time_worker_t *worker, absolute_time_t at)
+{
+    worker->next_time = at;
+    return async_context_add_at_time_worker(context, worker);
+}
+
+bool async_context_add_at_time_worker_in_ms(async_context_t *context, async_at_time_worker_t *worker, uint32_t ms)
+{
+    return async_context_add_at_time_worker_at(context, worker, make_timeout_time_ms(ms));
+}
+
+bool async_context_remove_at_time_worker(async_context_t *context, async_at_time_worker_t *worker)
+{
+    std::lock_guard<std::recursive_mutex> guard(context->impl->lock);
+    auto it = std::find(context->impl->at_time.begin(), context->impl->at_time.end(), worker);
+    bool ret = it != context->impl->at_time.end();
+    if (ret)
+    {
+        context->impl->at_time.erase(it);
+    }
+    return ret;
+}
+
+bool async_context_add_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker)
+{
+    std::lock_guard<std::recursive_mutex> guard(context->impl->lock);
+    worker->work_pending = false;
+    context->impl->when_pending.push_back(worker);
+    return true;
+}
+
+bool async_context_remove_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker)
+{
+    std::lock_guard<std::recursive_mutex> guard(context->impl->lock);
+    auto it = std::find(context->impl->when_pending.begin(), context->impl->when_pending.end(), worker);
+    bool ret = it != context->impl->when_pending.end();
+    if (ret)
+    {
+        context->impl->when_pending.erase(it);
+    }
+    return ret;
+}
+
+void async_context_set_work_pending(async_context_t *context, async_when_pending_worker_t *worker)
+{
+    //  As on the board this does not take the context lock, so it may be
+    //  called from another core while holding that core's lock
+    worker->work_pending = true;
+    context->impl->kick();
+}
+
+void async_context_acquire_lock_blocking(async_context_t *context)
+{
+    context->impl->lock.lock();
+}
+
+void async_context_release_lock(async_context_t *context)
+{
+    context->impl->lock.unlock();
+}
+
+void async_context_wait_for_work_until(async_context_t *context, absolute_time_t until)
+{
+    absolute_time_t now = get_absolute_time();
+    if (now < until)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(until - now));
+    }
+}
+
+void async_context_wait_for_work_ms(async_context_t *context, uint32_t ms)
+{
+    async_context_wait_for_work_until(context, make_timeout_time_ms(ms));
+}
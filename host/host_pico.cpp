@@ -0,0 +1,144 @@
+//                  *****  Host stand-ins for Pico SDK services  *****
+
+#include "pico/stdlib.h"
+#include "pico/cyw43_arch.h"
+#include "pico/util/queue.h"
+#include "pico/multicore.h"
+#include "web_set_time.h"
+#include <chrono>
+#include <mutex>
+#include <string.h>
+#include <thread>
+
+static const std::chrono::steady_clock::time_point boot_time = std::chrono::steady_clock::now();
+
+absolute_time_t get_absolute_time()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - boot_time).count();
+}
+
+void sleep_us(uint64_t us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void sleep_ms(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+bool stdio_init_all()
+{
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    return true;
+}
+
+
+//  *****  cyw43_arch  *****
+
+static async_context_t *arch_context = nullptr;
+
+int cyw43_arch_init()
+{
+    if (!arch_context)
+    {
+        arch_context = host_async_context_create();
+    }
+    return 0;
+}
+
+void cyw43_arch_deinit()
+{
+    host_async_context_delete(arch_context);
+    arch_context = nullptr;
+}
+
+async_context_t *cyw43_arch_async_context()
+{
+    cyw43_arch_init();
+    return arch_context;
+}
+
+void set_time_set_cb(void (*cb)())
+{
+    if (cb)
+    {
+        cb();
+    }
+}
+
+
+//  *****  multicore  *****
+
+void multicore_launch_core1(void (*entry)(void))
+{
+    std::thread(entry).detach();
+}
+
+
+//  *****  queue  *****
+
+static std::mutex queue_lock;
+
+void queue_init(queue_t *q, uint element_size, uint element_count)
+{
+    q->data = new uint8_t[element_size * (element_count + 1)];
+    q->wptr = 0;
+    q->rptr = 0;
+    q->element_size = element_size;
+    q->element_count = element_count;
+}
+
+void queue_free(queue_t *q)
+{
+    delete [] q->data;
+    q->data = nullptr;
+}
+
+static uint16_t inc_index(queue_t *q, uint16_t index)
+{
+    return ++index > q->element_count ? 0 : index;
+}
+
+uint queue_get_level(queue_t *q)
+{
+    std::lock_guard<std::mutex> lock(queue_lock);
+    int level = q->wptr - q->rptr;
+    return level < 0 ? level + q->element_count + 1 : level;
+}
+
+bool queue_try_add(queue_t *q, const void *data)
+{
+    std::lock_guard<std::mutex> lock(queue_lock);
+    uint16_t next = inc_index(q, q->wptr);
+    bool ret = next != q->rptr;
+    if (ret)
+    {
+        memcpy(q->data + q->wptr * q->element_size, data, q->element_size);
+        q->wptr = next;
+    }
+    return ret;
+}
+
+bool queue_try_remove(queue_t *q, void *data)
+{
+    std::lock_guard<std::mutex> lock(queue_lock);
+    bool ret = q->rptr != q->wptr;
+    if (ret)
+    {
+        memcpy(data, q->data + q->rptr * q->element_size, q->element_size);
+        q->rptr = inc_index(q, q->rptr);
+    }
+    return ret;
+}
+
+bool queue_try_peek(queue_t *q, void *data)
+{
+    std::lock_guard<std::mutex> lock(queue_lock);
+    bool ret = q->rptr != q->wptr;
+    if (ret)
+    {
+        memcpy(data, q->data + q->rptr * q->element_size, q->element_size);
+    }
+    return ret;
+}
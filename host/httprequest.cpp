@@ -0,0 +1,158 @@
+//                  *****  Host HTTPRequest implementation  *****
+
+#include "httprequest.h"
+#include "txt.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+HTTPRequest::HTTPRequest(const std::string &request)
+{
+    std::size_t eol = request.find("\r\n");
+    std::string line = request.substr(0, eol);
+    std::size_t i1 = line.find(' ');
+    std::size_t i2 = line.find(' ', i1 + 1);
+    type_ = line.substr(0, i1);
+    url_ = i1 != std::string::npos ? line.substr(i1 + 1, i2 - i1 - 1) : "/";
+
+    std::size_t eoh = request.find("\r\n\r\n");
+    std::size_t pos = eol;
+    while (pos != std::string::npos && pos < eoh)
+    {
+        pos += 2;
+        std::size_t next = request.find("\r\n", pos);
+        std::string hdr = request.substr(pos, next - pos);
+        std::size_t colon = hdr.find(':');
+        if (colon != std::string::npos)
+        {
+            std::string name = hdr.substr(0, colon);
+            for (auto it = name.begin(); it != name.end(); ++it) *it = tolower(*it);
+            std::size_t vs = hdr.find_first_not_of(' ', colon + 1);
+            headers_[name] = vs != std::string::npos ? hdr.substr(vs) : "";
+        }
+        pos = next;
+    }
+
+    if (eoh != std::string::npos)
+    {
+        parsePost(request.substr(eoh + 4));
+    }
+}
+
+std::string HTTPRequest::decode(const std::string &str)
+{
+    std::string ret;
+    for (std::size_t ii = 0; ii < str.length(); ii++)
+    {
+        char ch = str.at(ii);
+        if (ch == '+')
+        {
+            ch = ' ';
+        }
+        else if (ch == '%' && ii + 2 < str.length())
+        {
+            ch = static_cast<char>(strtol(str.substr(ii + 1, 2).c_str(), nullptr, 16));
+            ii += 2;
+        }
+        ret += ch;
+    }
+    return ret;
+}
+
+void HTTPRequest::parsePost(const std::string &body)
+{
+    std::size_t pos = 0;
+    while (pos < body.length())
+    {
+        std::size_t amp = body.find('&', pos);
+        std::string item = body.substr(pos, amp == std::string::npos ? amp : amp - pos);
+        std::size_t eq = item.find('=');
+        post_.emplace_back(decode(item.substr(0, eq)), eq != std::string::npos ? decode(item.substr(eq + 1)) : "");
+        pos = amp == std::string::npos ? body.length() : amp + 1;
+    }
+}
+
+std::string HTTPRequest::path() const
+{
+    return url_.substr(0, url_.find('?'));
+}
+
+std::string HTTPRequest::root() const
+{
+    std::string ret = path();
+    while (ret.length() > 1 && ret.back() == '/') ret.pop_back();
+    return ret;
+}
+
+std::string HTTPRequest::query(const char *key) const
+{
+    std::size_t i1 = url_.find('?');
+    std::string name(key);
+    while (i1 != std::string::npos)
+    {
+        ++i1;
+        std::size_t i2 = url_.find('&', i1);
+        std::string item = url_.substr(i1, i2 == std::string::npos ? i2 : i2 - i1);
+        std::size_t eq = item.find('=');
+        if (item.substr(0, eq) == name)
+        {
+            return eq != std::string::npos ? decode(item.substr(eq + 1)) : "";
+        }
+        i1 = i2;
+    }
+    return std::string();
+}
+
+std::string HTTPRequest::header(const char *name) const
+{
+    std::string key(name);
+    for (auto it = key.begin(); it != key.end(); ++it) *it = tolower(*it);
+    auto it = headers_.find(key);
+    return it != headers_.cend() ? it->second : std::string();
+}
+
+char *HTTPRequest::postValue(const char *key)
+{
+    for (auto it = post_.begin(); it != post_.end(); ++it)
+    {
+        if (it->first == key)
+        {
+            return &it->second[0];
+        }
+    }
+    return nullptr;
+}
+
+int HTTPRequest::postArray(const char *key, std::vector<const char *> &values)
+{
+    values.clear();
+    for (auto it = post_.cbegin(); it != post_.cend(); ++it)
+    {
+        if (it->first == key)
+        {
+            values.push_back(it->second.c_str());
+        }
+    }
+    return values.size();
+}
+
+void HTTPRequest::printPostData() const
+{
+    for (auto it = post_.cbegin(); it != post_.cend(); ++it)
+    {
+        printf("%s = '%s'\n", it->first.c_str(), it->second.c_str());
+    }
+}
+
+void HTTPRequest::setHTMLLengthHeader(TXT &html)
+{
+    std::size_t eoh = html.find("\r\n\r\n");
+    std::size_t cl = html.find("Content-Length:");
+    if (eoh != std::string::npos && cl != std::string::npos && cl < eoh)
+    {
+        std::size_t eol = html.find("\r\n", cl);
+        std::string len = "Content-Length: " + std::to_string(html.datasize() - eoh - 4);
+        html.replace(cl, eol - cl, len.c_str());
+    }
+}
@@ -0,0 +1,37 @@
+//                  *****  Host stand-in for Button  *****
+
+#ifndef HOST_BUTTON_H
+#define HOST_BUTTON_H
+
+#include <stdint.h>
+
+class Button
+{
+public:
+    enum ButtonAction { Button_Down, Button_Up, Button_Clicked, Button_Held };
+
+    struct ButtonEvent
+    {
+        Button          *button;
+        ButtonAction    action;
+    };
+
+private:
+    int             id_;                        // Button identifier
+    int             gpio_;                      // GPIO number
+    void            (*cb_)(struct ButtonEvent &ev, void *user_data);
+    void            *user_data_;
+
+public:
+    Button(int id, int gpio) : id_(id), gpio_(gpio), cb_(nullptr), user_data_(nullptr) {}
+
+    void setEventCallback(void (*cb)(struct ButtonEvent &ev, void *user_data), void *user_data)
+        { cb_ = cb; user_data_ = user_data; }
+
+    /**
+     * @brief   Deliver a simulated button event
+     */
+    void simulate(ButtonAction action) { ButtonEvent ev = {this, action}; if (cb_) cb_(ev, user_data_); }
+};
+
+#endif
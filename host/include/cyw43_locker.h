@@ -0,0 +1,15 @@
+//                  *****  Host stand-in for CYW43Locker  *****
+
+#ifndef HOST_CYW43_LOCKER_H
+#define HOST_CYW43_LOCKER_H
+
+#include "pico/cyw43_arch.h"
+
+class CYW43Locker
+{
+public:
+    CYW43Locker() { async_context_acquire_lock_blocking(cyw43_arch_async_context()); }
+    ~CYW43Locker() { async_context_release_lock(cyw43_arch_async_context()); }
+};
+
+#endif
@@ -0,0 +1,12 @@
+//                  *****  Host stand-in for hardware/exception.h  *****
+
+#ifndef HOST_HARDWARE_EXCEPTION_H
+#define HOST_HARDWARE_EXCEPTION_H
+
+enum exception_number { HARDFAULT_EXCEPTION = -13 };
+typedef void (*exception_handler_t)();
+
+static inline exception_handler_t exception_set_exclusive_handler(enum exception_number num, exception_handler_t handler)
+    { return nullptr; }
+
+#endif
@@ -0,0 +1,12 @@
+//                  *****  Host stand-in for hardware/watchdog.h  *****
+
+#ifndef HOST_HARDWARE_WATCHDOG_H
+#define HOST_HARDWARE_WATCHDOG_H
+
+#include <stdint.h>
+
+static inline void watchdog_enable(uint32_t delay_ms, bool pause_on_debug) {}
+static inline void watchdog_update() {}
+static inline void watchdog_disable() {}
+
+#endif
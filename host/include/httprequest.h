@@ -0,0 +1,50 @@
+//                  *****  Host stand-in for HTTPRequest  *****
+
+#ifndef HOST_HTTPREQUEST_H
+#define HOST_HTTPREQUEST_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+class TXT;
+
+class HTTPRequest
+{
+private:
+    std::string                 type_;              // Request type (GET, POST)
+    std::string                 url_;               // Full URL
+    std::map<std::string, std::string> headers_;    // Headers (lower case name)
+    std::vector<std::pair<std::string, std::string>> post_; // POST data
+    std::string                 user_data_;         // User data
+
+    static std::string decode(const std::string &str);
+    void parsePost(const std::string &body);
+
+public:
+    HTTPRequest(const std::string &request);
+
+    const std::string &type() const { return type_; }
+    const std::string &url() const { return url_; }
+    std::string path() const;
+    std::string root() const;
+    std::string query(const char *key) const;
+    std::string header(const char *name) const;
+
+    char *postValue(const char *key);
+    int postArray(const char *key, std::vector<const char *> &values);
+    void printPostData() const;
+
+    void setURL(const std::string &url) { url_ = url; }
+    void setUserData(const std::string &data) { user_data_ = data; }
+    const std::string &userData() const { return user_data_; }
+
+    /**
+     * @brief   Set Content-Length in the header of an HTML response
+     * 
+     * @param   html    Response text starting with the HTTP header
+     */
+    static void setHTMLLengthHeader(TXT &html);
+};
+
+#endif
@@ -0,0 +1,18 @@
+//                  *****  Host stand-in for IR_LED  *****
+
+#ifndef HOST_IR_LED_H
+#define HOST_IR_LED_H
+
+/**
+ * @brief   IR transmitter base
+ * 
+ * @details Only the type is used. The remote transmits through IR_PioTx,
+ *          simulated in ir_sim.cpp.
+ */
+class IR_LED
+{
+public:
+    virtual ~IR_LED() {}
+};
+
+#endif
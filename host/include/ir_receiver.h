@@ -0,0 +1,45 @@
+//                  *****  Host stand-in for IR_Receiver  *****
+
+#ifndef HOST_IR_RECEIVER_H
+#define HOST_IR_RECEIVER_H
+
+#include <pico/async_context.h>
+#include <stdint.h>
+
+class IR_Receiver
+{
+protected:
+    int             gpio_;                      // GPIO number
+    void            *user_data_;                // User data
+    uint32_t        msg_timeout_;               // Message timeout (msec)
+    uint32_t        bit_timeout_;               // Bit timeout (usec)
+    void            (*rcv_cb_)(uint64_t timestamp, uint16_t address, uint16_t value, IR_Receiver *obj);
+    bool            (*tmo_cb_)(bool msg, uint32_t n_pulse, uint32_t const *pulses, IR_Receiver *obj);
+
+public:
+    IR_Receiver(int gpio)
+     : gpio_(gpio), user_data_(nullptr), msg_timeout_(0), bit_timeout_(0), rcv_cb_(nullptr), tmo_cb_(nullptr) {}
+    virtual ~IR_Receiver() {}
+
+    void set_user_data(void *user_data) { user_data_ = user_data; }
+    void *user_data() const { return user_data_; }
+    void set_message_timeout(uint32_t msec) { msg_timeout_ = msec; }
+    void set_bit_timeout(uint32_t usec) { bit_timeout_ = usec; }
+    void set_rcv_callback(void (*cb)(uint64_t timestamp, uint16_t address, uint16_t value, IR_Receiver *obj)) { rcv_cb_ = cb; }
+    void set_tmo_callback(bool (*cb)(bool msg, uint32_t n_pulse, uint32_t const *pulses, IR_Receiver *obj)) { tmo_cb_ = cb; }
+};
+
+/**
+ * @brief   Decode helper shared by the protocol receivers
+ * 
+ * @details Pulses are alternating mark and space durations in usec
+ *          starting with the leader mark.
+ */
+namespace IR_Decode
+{
+    bool near(uint32_t actual, uint32_t expected);
+    bool pulseDistance(uint32_t const *pulses, uint32_t n_pulse, uint32_t lead_mark, uint32_t lead_space,
+                       uint32_t mark, uint32_t zero, uint32_t one, int nbits, uint32_t &bits);
+}
+
+#endif
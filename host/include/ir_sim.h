@@ -0,0 +1,52 @@
+//                  *****  Host IR simulation controls  *****
+
+#ifndef HOST_IR_SIM_H
+#define HOST_IR_SIM_H
+
+#include "irpiotx.h"
+#include <vector>
+#include <stdint.h>
+
+/**
+ * @brief   Set the simulated transmit time scale
+ * 
+ * @details A pulse program completes after its time multiplied by scale
+ *          (0 completes at once)
+ */
+void ir_sim_set_time_scale(double scale);
+
+/**
+ * @brief   Get the counters of the simulated transmitter
+ * 
+ * @return  false if no transmitter has been built
+ */
+bool ir_sim_tx_stats(IR_PioTx::Stats &stats);
+
+/**
+ * @brief   Take the simulated IR output
+ * 
+ * @details The start time of each frame sent since the last call. A frame
+ *          starts with the first mark of a program or a mark after a space
+ *          of at least IR_SIM_FRAME_GAP. Programs are taken to run exactly
+ *          to time, as the PIO does, from the moment they are sent.
+ * 
+ * @param   frames  Receives the frame start times (usec since boot)
+ */
+void ir_sim_take_output(std::vector<uint64_t> &frames);
+
+/**
+ * @brief   Show a frame to the sniffing receiver
+ * 
+ * @details The edges of the frame are added to the IR_GpioRx ring, timed
+ *          so that the frame ends now
+ * 
+ * @param   times   Marks and spaces (mark first)
+ * @param   n_times Number of marks and spaces
+ * 
+ * @return  false if no receiver is enabled
+ */
+bool ir_sim_sniff(const uint32_t *times, uint32_t n_times);
+
+#define IR_SIM_FRAME_GAP    8000        // Shortest space between frames (usec)
+
+#endif
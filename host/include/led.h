@@ -0,0 +1,25 @@
+//                  *****  Host stand-in for LED  *****
+
+#ifndef HOST_LED_H
+#define HOST_LED_H
+
+#include <stdint.h>
+
+class LED
+{
+private:
+    int             gpio_;                      // GPIO number
+    uint32_t        period_;                    // Flash period (msec)
+    uint32_t        pattern_;                   // Flash pattern
+    int             bits_;                      // Bits in pattern
+
+public:
+    LED(int gpio) : gpio_(gpio), period_(0), pattern_(0), bits_(0) {}
+
+    void setFlashPeriod(uint32_t period) { period_ = period; }
+    void setFlashPattern(uint32_t pattern, int bits) { pattern_ = pattern; bits_ = bits; }
+
+    uint32_t flashPattern() const { return pattern_; }
+};
+
+#endif
@@ -0,0 +1,26 @@
+//                  *****  Host stand-in for lfs.h  *****
+
+#ifndef HOST_LFS_H
+#define HOST_LFS_H
+
+#include <stdint.h>
+
+typedef uint32_t lfs_size_t;
+typedef uint32_t lfs_off_t;
+typedef uint32_t lfs_block_t;
+
+enum lfs_error
+{
+    LFS_ERR_OK  = 0,
+    LFS_ERR_IO  = -5,
+};
+
+struct lfs_config
+{
+    int     offset;
+    int     size;
+    int     (*prog)(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size);
+    int     (*erase)(const struct lfs_config *c, lfs_block_t block);
+};
+
+#endif
@@ -0,0 +1,23 @@
+//                  *****  Host stand-in for pico-filesystem  *****
+
+#ifndef HOST_PFS_H
+#define HOST_PFS_H
+
+#include "lfs.h"
+
+/**
+ * @brief   Host flash file system
+ * 
+ * @details The "flash" is a directory on the host (REMOTE_HOST_FS or
+ *          ./remote_fs). Mounting makes it the working directory and
+ *          maps absolute paths given to opendir onto it.
+ */
+struct pfs_pfs;
+
+int ffs_pico_createcfg(struct lfs_config *cfg, int offset, int size);
+struct pfs_pfs *pfs_ffs_create(const struct lfs_config *cfg);
+int pfs_mount(struct pfs_pfs *pfs, const char *name);
+
+const char *host_fs_root();
+
+#endif
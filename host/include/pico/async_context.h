@@ -0,0 +1,66 @@
+//                  *****  Host stand-in for pico/async_context.h  *****
+
+#ifndef HOST_PICO_ASYNC_CONTEXT_H
+#define HOST_PICO_ASYNC_CONTEXT_H
+
+#include "pico/time.h"
+#include <stdint.h>
+
+/**
+ * @brief   Host async context
+ * 
+ * @details Workers are run on a single background thread, the way the
+ *          threadsafe_background cyw43 context runs them from a low
+ *          priority interrupt on the board. The context lock is recursive
+ *          and is held while a worker runs.
+ */
+typedef struct async_context
+{
+    struct host_async_context   *impl;      // Worker thread and lists
+} async_context_t;
+
+typedef struct async_work_on_timeout
+{
+    struct async_work_on_timeout *next;
+    void (*do_work)(async_context_t *context, struct async_work_on_timeout *worker);
+    absolute_time_t next_time;
+    void *user_data;
+} async_at_time_worker_t;
+
+typedef struct async_when_pending_worker
+{
+    struct async_when_pending_worker *next;
+    void (*do_work)(async_context_t *context, struct async_when_pending_worker *worker);
+    bool work_pending;
+    void *user_data;
+} async_when_pending_worker_t;
+
+async_context_t *host_async_context_create();
+void host_async_context_delete(async_context_t *context);
+bool host_async_context_init(async_context_t *context);
+
+/**
+ * @brief   Context created on the calling thread ("core")
+ * 
+ * @details Stand-in drivers use it the way the board drivers use the alarm
+ *          and GPIO interrupts of the core that created them.
+ * 
+ * @return  Context or nullptr if none was created on this thread
+ */
+async_context_t *host_async_context_current();
+
+bool async_context_add_at_time_worker(async_context_t *context, async_at_time_worker_t *worker);
+bool async_context_add_at_time_worker_at(async_context_t *context, async_at_time_worker_t *worker, absolute_time_t at);
+bool async_context_add_at_time_worker_in_ms(async_context_t *context, async_at_time_worker_t *worker, uint32_t ms);
+bool async_context_remove_at_time_worker(async_context_t *context, async_at_time_worker_t *worker);
+
+bool async_context_add_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker);
+bool async_context_remove_when_pending_worker(async_context_t *context, async_when_pending_worker_t *worker);
+void async_context_set_work_pending(async_context_t *context, async_when_pending_worker_t *worker);
+
+void async_context_acquire_lock_blocking(async_context_t *context);
+void async_context_release_lock(async_context_t *context);
+void async_context_wait_for_work_until(async_context_t *context, absolute_time_t until);
+void async_context_wait_for_work_ms(async_context_t *context, uint32_t ms);
+
+#endif
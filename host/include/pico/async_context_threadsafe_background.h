@@ -0,0 +1,18 @@
+//                  *****  Host stand-in for pico/async_context_threadsafe_background.h  *****
+
+#ifndef HOST_PICO_ASYNC_CONTEXT_THREADSAFE_BACKGROUND_H
+#define HOST_PICO_ASYNC_CONTEXT_THREADSAFE_BACKGROUND_H
+
+#include "pico/async_context.h"
+
+typedef struct async_context_threadsafe_background
+{
+    async_context_t     core;
+} async_context_threadsafe_background_t;
+
+static inline bool async_context_threadsafe_background_init_with_defaults(async_context_threadsafe_background_t *self)
+{
+    return host_async_context_init(&self->core);
+}
+
+#endif
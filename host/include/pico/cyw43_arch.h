@@ -0,0 +1,13 @@
+//                  *****  Host stand-in for pico/cyw43_arch.h  *****
+
+#ifndef HOST_PICO_CYW43_ARCH_H
+#define HOST_PICO_CYW43_ARCH_H
+
+#include "pico/stdlib.h"
+#include "pico/async_context.h"
+
+int cyw43_arch_init();
+void cyw43_arch_deinit();
+async_context_t *cyw43_arch_async_context();
+
+#endif
@@ -0,0 +1,23 @@
+//                  *****  Host stand-in for pico/flash.h  *****
+
+#ifndef HOST_PICO_FLASH_H
+#define HOST_PICO_FLASH_H
+
+#include <stdint.h>
+
+#ifndef PICO_OK
+#define PICO_OK 0
+#endif
+
+static inline bool flash_safe_execute_core_init() { return true; }
+
+/**
+ * @brief   Run a flash operation (nothing to park on the host)
+ */
+static inline int flash_safe_execute(void (*func)(void *), void *param, uint32_t timeout_ms)
+{
+    func(param);
+    return PICO_OK;
+}
+
+#endif
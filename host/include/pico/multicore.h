@@ -0,0 +1,16 @@
+//                  *****  Host stand-in for pico/multicore.h  *****
+
+#ifndef HOST_PICO_MULTICORE_H
+#define HOST_PICO_MULTICORE_H
+
+/**
+ * @brief   Run a function as core 1 (a detached thread)
+ */
+void multicore_launch_core1(void (*entry)(void));
+
+/**
+ * @brief   Check whether a core can be parked for flash writes
+ */
+static inline bool multicore_lockout_victim_is_initialized(unsigned core_num) { return true; }
+
+#endif
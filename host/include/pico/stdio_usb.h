@@ -0,0 +1,9 @@
+//                  *****  Host stand-in for pico/stdio_usb.h  *****
+
+#ifndef HOST_PICO_STDIO_USB_H
+#define HOST_PICO_STDIO_USB_H
+
+//  Report a connected console so the watchdog stays disabled on the host
+static inline bool stdio_usb_connected() { return true; }
+
+#endif
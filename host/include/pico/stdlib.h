@@ -0,0 +1,22 @@
+//                  *****  Host stand-in for pico/stdlib.h  *****
+
+#ifndef HOST_PICO_STDLIB_H
+#define HOST_PICO_STDLIB_H
+
+#include "pico/time.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#ifndef count_of
+#define count_of(a) (sizeof(a) / sizeof((a)[0]))
+#endif
+
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES   (4 * 1024 * 1024)
+#endif
+
+typedef unsigned int uint;
+
+bool stdio_init_all();
+
+#endif
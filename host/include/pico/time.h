@@ -0,0 +1,26 @@
+//                  *****  Host stand-in for pico/time.h  *****
+
+#ifndef HOST_PICO_TIME_H
+#define HOST_PICO_TIME_H
+
+#include <stdint.h>
+
+typedef uint64_t absolute_time_t;
+
+static const absolute_time_t nil_time = 0;
+
+absolute_time_t get_absolute_time();
+
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+static inline uint32_t to_ms_since_boot(absolute_time_t t) { return static_cast<uint32_t>(t / 1000); }
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us) { return t + us; }
+static inline absolute_time_t delayed_by_ms(absolute_time_t t, uint32_t ms) { return t + 1000ull * ms; }
+static inline absolute_time_t make_timeout_time_us(uint64_t us) { return delayed_by_us(get_absolute_time(), us); }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms) { return delayed_by_ms(get_absolute_time(), ms); }
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to)
+    { return static_cast<int64_t>(to - from); }
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+#endif
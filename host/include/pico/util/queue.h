@@ -0,0 +1,25 @@
+//                  *****  Host stand-in for pico/util/queue.h  *****
+
+#ifndef HOST_PICO_UTIL_QUEUE_H
+#define HOST_PICO_UTIL_QUEUE_H
+
+#include "pico/stdlib.h"
+#include <stdint.h>
+
+typedef struct
+{
+    uint8_t     *data;
+    uint16_t    wptr;
+    uint16_t    rptr;
+    uint        element_size;
+    uint        element_count;
+} queue_t;
+
+void queue_init(queue_t *q, uint element_size, uint element_count);
+void queue_free(queue_t *q);
+uint queue_get_level(queue_t *q);
+bool queue_try_add(queue_t *q, const void *data);
+bool queue_try_remove(queue_t *q, void *data);
+bool queue_try_peek(queue_t *q, void *data);
+
+#endif
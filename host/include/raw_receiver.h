@@ -0,0 +1,47 @@
+//                  *****  Host stand-in for RAW_Receiver  *****
+
+#ifndef HOST_RAW_RECEIVER_H
+#define HOST_RAW_RECEIVER_H
+
+#include "ir_receiver.h"
+
+/**
+ * @brief   Simulated raw pulse receiver
+ * 
+ * @details Captures are supplied with inject(). If none arrives within the
+ *          message timeout the timeout callback is made.
+ */
+class RAW_Receiver : public IR_Receiver
+{
+private:
+    uint32_t                *times_;            // Time buffer
+    uint32_t                max_times_;         // Buffer size
+    uint32_t                *n_times_;          // Count of times read
+    async_context_t         *ctx_;              // Async context
+    async_at_time_worker_t  tmo_worker_;        // Message timeout worker
+    async_when_pending_worker_t rcv_worker_;    // Receive worker
+
+    static RAW_Receiver     *active_;           // Receiver waiting for a message
+
+    static void timeout(async_context_t *ctx, async_at_time_worker_t *worker);
+    static void received(async_context_t *ctx, async_when_pending_worker_t *worker);
+
+public:
+    RAW_Receiver(int gpio, uint32_t n_samples);
+    ~RAW_Receiver();
+
+    void set_times(uint32_t *times, uint32_t n_times, uint32_t *count) { times_ = times; max_times_ = n_times; n_times_ = count; }
+    void start_message_timeout();
+
+    /**
+     * @brief   Deliver a capture to the listening receiver
+     * 
+     * @param   times   Mark/space durations (usec)
+     * @param   n_times Number of durations
+     * 
+     * @return  true if a receiver was listening
+     */
+    static bool inject(const uint32_t *times, uint32_t n_times);
+};
+
+#endif
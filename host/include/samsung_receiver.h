@@ -0,0 +1,15 @@
+//                  *****  Host stand-in for SAMSUNG_Receiver  *****
+
+#ifndef HOST_SAMSUNG_RECEIVER_H
+#define HOST_SAMSUNG_RECEIVER_H
+
+#include "ir_receiver.h"
+
+class SAMSUNG_Receiver : public IR_Receiver
+{
+public:
+    SAMSUNG_Receiver(int gpio) : IR_Receiver(gpio) {}
+    static bool decode(uint32_t const *pulses, uint32_t n_pulse, uint16_t &addr, uint16_t &func, uint16_t address);
+};
+
+#endif
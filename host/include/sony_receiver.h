@@ -0,0 +1,22 @@
+//                  *****  Host stand-in for Sony receivers  *****
+
+#ifndef HOST_SONY_RECEIVER_H
+#define HOST_SONY_RECEIVER_H
+
+#include "ir_receiver.h"
+
+class Sony12_Receiver : public IR_Receiver
+{
+public:
+    Sony12_Receiver(int gpio) : IR_Receiver(gpio) {}
+    static bool decode(uint32_t const *pulses, uint32_t n_pulse, uint16_t &addr, uint16_t &func, uint16_t address);
+};
+
+class Sony15_Receiver : public IR_Receiver
+{
+public:
+    Sony15_Receiver(int gpio) : IR_Receiver(gpio) {}
+    static bool decode(uint32_t const *pulses, uint32_t n_pulse, uint16_t &addr, uint16_t &func, uint16_t address);
+};
+
+#endif
@@ -0,0 +1,125 @@
+//                  *****  Host stand-in for WEB  *****
+
+#ifndef HOST_WEB_H
+#define HOST_WEB_H
+
+#include "httprequest.h"
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+
+typedef uint16_t u16_t;
+typedef uint32_t ClientHandle;
+typedef std::map<std::string, int> WiFiScanData;    // SSID -> RSSI
+
+class Logger;
+
+/**
+ * @brief   Simulated web transport
+ * 
+ * @details Requests are injected with sim_http / sim_message and run under
+ *          the async context lock, as lwIP callbacks would be. Anything the
+ *          application sends is captured per client.
+ */
+class WEB
+{
+public:
+    enum NoticeState { STA_INITIALIZING = 1, STA_CONNECTED, STA_DISCONNECTED, AP_ACTIVE, AP_INACTIVE };
+    enum SendMode { COPY, PREALL, STAT };
+
+private:
+    struct Client
+    {
+        std::string                 http;           // HTTP output
+        std::deque<std::string>     messages;       // Websocket messages sent
+    };
+
+    Logger                  *log_;
+    std::string             hostname_;
+    std::string             ssid_;
+    bool                    ap_active_;
+    bool                    http_listening_;
+    bool                    https_listening_;
+
+    bool (*tls_cb_)(WEB *web, std::string &cert, std::string &pkey, std::string &pkpass);
+    bool (*http_cb_)(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close, void *udata);
+    void *http_udata_;
+    void (*msg_cb_)(WEB *web, ClientHandle client, const std::string &msg, void *udata);
+    void *msg_udata_;
+    void (*notice_cb_)(int state, void *udata);
+    void *notice_udata_;
+
+    std::map<ClientHandle, Client>  clients_;
+    std::mutex              mutex_;
+    std::condition_variable cond_;
+
+    WEB();
+    void notice(int state) { if (notice_cb_) notice_cb_(state, notice_udata_); }
+
+public:
+    static WEB *get();
+
+    bool init();
+    void setLogger(Logger *logger) { log_ = logger; }
+    void set_tls_callback(bool (*cb)(WEB *web, std::string &cert, std::string &pkey, std::string &pkpass)) { tls_cb_ = cb; }
+    void set_http_callback(bool (*cb)(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close, void *udata), void *udata)
+        { http_cb_ = cb; http_udata_ = udata; }
+    void set_message_callback(void (*cb)(WEB *web, ClientHandle client, const std::string &msg, void *udata), void *udata)
+        { msg_cb_ = cb; msg_udata_ = udata; }
+    void set_notice_callback(void (*cb)(int state, void *udata), void *udata) { notice_cb_ = cb; notice_udata_ = udata; }
+
+    bool connect_to_wifi(const std::string &hostname, const std::string &ssid, const std::string &password);
+    bool update_wifi(const std::string &hostname, const std::string &ssid, const std::string &password);
+    void enable_ap(int minutes, const std::string &name);
+    bool is_ap_active() const { return ap_active_; }
+    bool scan_wifi(ClientHandle client, bool (*cb)(WEB *web, ClientHandle client, const WiFiScanData &data, void *udata), void *udata);
+
+    const std::string &hostname() const { return hostname_; }
+    const std::string &wifi_ssid() const { return ssid_; }
+    std::string ip_addr() const { return "127.0.0.1"; }
+
+    bool is_http_listening() const { return http_listening_; }
+    bool is_https_listening() const { return https_listening_; }
+    bool start_http() { http_listening_ = true; return true; }
+    bool stop_http() { http_listening_ = false; return true; }
+    bool start_https() { https_listening_ = tls_cb_ != nullptr; return https_listening_; }
+    bool stop_https() { https_listening_ = false; return true; }
+
+    bool send_data(ClientHandle client, const char *data, uint32_t datalen, SendMode mode = COPY);
+    bool send_message(ClientHandle client, const std::string &message);
+    void broadcast_websocket(const std::string &message);
+
+    //  *****  Host simulation  *****
+
+    /**
+     * @brief   Process an HTTP request
+     * 
+     * @param   client      Client handle
+     * @param   request     Request text (request line, headers and body)
+     * @param   response    String to receive everything sent to the client
+     * 
+     * @return  Value returned by the HTTP callback
+     */
+    bool sim_http(ClientHandle client, const std::string &request, std::string &response);
+
+    /**
+     * @brief   Process a websocket message
+     */
+    void sim_message(ClientHandle client, const std::string &message);
+
+    /**
+     * @brief   Wait for a websocket message sent to a client
+     * 
+     * @param   client      Client handle
+     * @param   message     String to receive the message
+     * @param   timeout_ms  Maximum wait (msec)
+     * 
+     * @return  true if a message was received
+     */
+    bool sim_wait_message(ClientHandle client, std::string &message, uint32_t timeout_ms);
+};
+
+#endif
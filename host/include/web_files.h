@@ -0,0 +1,34 @@
+//                  *****  Host stand-in for WEB_FILES  *****
+
+#ifndef HOST_WEB_FILES_H
+#define HOST_WEB_FILES_H
+
+#include <map>
+#include <string>
+#include <stdint.h>
+
+typedef uint16_t u16_t;
+
+/**
+ * @brief   Web resource files
+ * 
+ * @details The board build embeds data/ through web_files(). On the host the
+ *          files are read from REMOTE_HOST_DATA (default: the source data
+ *          directory) on first use and given the same HTTP header. The
+ *          gzip variants (<name>.gz) come from the build directory.
+ */
+class WEB_FILES
+{
+private:
+    std::map<std::string, std::string>  files_;     // Loaded files with header
+
+    WEB_FILES() {}
+    static const char *content_type(const std::string &name);
+
+public:
+    static WEB_FILES *get();
+
+    bool get_file(const std::string &name, const char * &data, u16_t &datalen);
+};
+
+#endif
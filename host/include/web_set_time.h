@@ -0,0 +1,9 @@
+//                  *****  Host stand-in for web_set_time.h  *****
+
+#ifndef HOST_WEB_SET_TIME_H
+#define HOST_WEB_SET_TIME_H
+
+//  Host clock is already set so the callback is made immediately
+void set_time_set_cb(void (*cb)());
+
+#endif
@@ -0,0 +1,374 @@
+//                  *****  Host IR simulation  *****
+
+#include "ir_sim.h"
+#include "nec_receiver.h"
+#include "samsung_receiver.h"
+#include "sony_receiver.h"
+#include "raw_receiver.h"
+#include "irgpiorx.h"
+#include <pico/cyw43_arch.h>
+#include <mutex>
+#include <string.h>
+
+//  Drivers run on the context of the thread (core) that creates them
+static async_context_t *core_context()
+{
+    async_context_t *ctx = host_async_context_current();
+    return ctx ? ctx : cyw43_arch_async_context();
+}
+
+
+//  *****  IR_PioTx  *****
+//
+//  The state machine is replaced by an at_time worker that fires when the
+//  program would end and raises the done worker, as the PIO interrupt does.
+
+static double ir_time_scale = 1.0;
+static async_at_time_worker_t ir_end_worker;
+static IR_PioTx *ir_tx = nullptr;
+static std::mutex ir_output_lock;
+static std::vector<uint64_t> ir_output;
+
+IR_PioTx *IR_PioTx::instance_ = nullptr;
+
+static void ir_end(async_context_t *ctx, async_at_time_worker_t *worker)
+{
+    async_context_set_work_pending(ctx, static_cast<async_when_pending_worker_t *>(worker->user_data));
+}
+
+IR_PioTx::IR_PioTx(int gpio, async_context_t *context)
+ : gpio_(gpio), ctx_(context), done_cb_(nullptr), done_data_(nullptr), busy_(false), started_(nil_time),
+   pio_(0), sm_(0), offset_(0), dma_(0)
+{
+    stats_ = {0, 0, 0, 0};
+    done_worker_ = { .do_work = done, .user_data = this };
+    async_context_add_when_pending_worker(ctx_, &done_worker_);
+    ir_end_worker = { .do_work = ir_end, .user_data = &done_worker_ };
+    instance_ = this;
+    ir_tx = this;
+}
+
+IR_PioTx::~IR_PioTx()
+{
+    async_context_remove_at_time_worker(ctx_, &ir_end_worker);
+    async_context_remove_when_pending_worker(ctx_, &done_worker_);
+    instance_ = nullptr;
+    ir_tx = nullptr;
+}
+
+int IR_PioTx::load(const IRPulses &pulses)
+{
+    return pulses.size() < IR_PIO_MAX_WORDS ? pulses.size() + 1 : -1;
+}
+
+bool IR_PioTx::send(const IRPulses &pulses)
+{
+    int nwords = busy_ ? -1 : load(pulses);
+    if (nwords < 0)
+    {
+        ++stats_.rejected;
+        return false;
+    }
+    busy_ = true;
+    started_ = get_absolute_time();
+    ++stats_.programs;
+    stats_.words += nwords - 1;
+    {
+        std::lock_guard<std::mutex> lock(ir_output_lock);
+        uint64_t at = 0;
+        bool first = true;
+        for (int ii = 0; ii < pulses.size(); ii++)
+        {
+            if (ii % 2 == 0 && pulses[ii] > 0 && (first || pulses[ii - 1] >= IR_SIM_FRAME_GAP))
+            {
+                ir_output.push_back(to_us_since_boot(started_) + static_cast<uint64_t>(at * ir_time_scale));
+                first = false;
+            }
+            at += pulses[ii];
+        }
+    }
+    uint64_t duration = static_cast<uint64_t>(pulses.duration() * ir_time_scale);
+    return async_context_add_at_time_worker_at(ctx_, &ir_end_worker, make_timeout_time_us(duration));
+}
+
+void IR_PioTx::pio_irq()
+{
+}
+
+void IR_PioTx::done(async_context_t *ctx, async_when_pending_worker_t *worker)
+{
+    IR_PioTx *self = static_cast<IR_PioTx *>(worker->user_data);
+    if (self->busy_)
+    {
+        self->busy_ = false;
+        self->stats_.busy_us += absolute_time_diff_us(self->started_, get_absolute_time());
+        if (self->done_cb_)
+        {
+            self->done_cb_(self, self->done_data_);
+        }
+    }
+}
+
+void ir_sim_set_time_scale(double scale)
+{
+    ir_time_scale = scale;
+}
+
+bool ir_sim_tx_stats(IR_PioTx::Stats &stats)
+{
+    if (ir_tx)
+    {
+        ir_tx->getStats(stats);
+    }
+    return ir_tx != nullptr;
+}
+
+void ir_sim_take_output(std::vector<uint64_t> &frames)
+{
+    std::lock_guard<std::mutex> lock(ir_output_lock);
+    frames.swap(ir_output);
+    ir_output.clear();
+}
+
+
+//  *****  Protocol decoders  *****
+
+bool IR_Decode::near(uint32_t actual, uint32_t expected)
+{
+    uint32_t tol = expected / 4;
+    return actual + tol >= expected && actual <= expected + tol;
+}
+
+bool IR_Decode::pulseDistance(uint32_t const *pulses, uint32_t n_pulse, uint32_t lead_mark, uint32_t lead_space,
+                              uint32_t mark, uint32_t zero, uint32_t one, int nbits, uint32_t &bits)
+{
+    bits = 0;
+    if (n_pulse < 2 + 2 * nbits || !near(pulses[0], lead_mark) || !near(pulses[1], lead_space))
+    {
+        return false;
+    }
+    for (int ii = 0; ii < nbits; ii++)
+    {
+        uint32_t m = pulses[2 + 2 * ii];
+        uint32_t s = pulses[3 + 2 * ii];
+        if (!near(m, mark))
+        {
+            return false;
+        }
+        if (near(s, one))
+        {
+            bits |= 1u << ii;
+        }
+        else if (!near(s, zero))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool NEC_Receiver::decode(uint32_t const *pulses, uint32_t n_pulse, uint16_t &addr, uint16_t &func, uint16_t address)
+{
+    uint32_t bits;
+    if (!IR_Decode::pulseDistance(pulses, n_pulse, 9000, 4500, 562, 562, 1687, 32, bits))
+    {
+        return false;
+    }
+    uint8_t cmd = (bits >> 16) & 0xff;
+    if (((bits >> 24) & 0xff) != (~cmd & 0xff))
+    {
+        return false;
+    }
+    uint16_t a = bits & 0xffff;
+    if ((a >> 8) == (~a & 0xff))
+    {
+        a &= 0xff;
+    }
+    addr = a;
+    func = cmd;
+    return address == 0xffff || address == addr;
+}
+
+bool SAMSUNG_Receiver::decode(uint32_t const *pulses, uint32_t n_pulse, uint16_t &addr, uint16_t &func, uint16_t address)
+{
+    uint32_t bits;
+    if (!IR_Decode::pulseDistance(pulses, n_pulse, 4500, 4500, 560, 560, 1690, 32, bits))
+    {
+        return false;
+    }
+    uint8_t cmd = (bits >> 16) & 0xff;
+    if ((bits & 0xff) != ((bits >> 8) & 0xff) || ((bits >> 24) & 0xff) != (~cmd & 0xff))
+    {
+        return false;
+    }
+    addr = bits & 0xff;
+    func = cmd;
+    return address == 0xffff || address == addr;
+}
+
+static bool sony_decode(uint32_t const *pulses, uint32_t n_pulse, int address_bits, uint16_t &addr, uint16_t &func, uint16_t address)
+{
+    int nbits = 7 + address_bits;
+    if (n_pulse < 2 + 2 * nbits - 1 || !IR_Decode::near(pulses[0], 2400) || !IR_Decode::near(pulses[1], 600))
+    {
+        return false;
+    }
+    //  Reject a longer frame so Sony12 does not claim a Sony15 message
+    if (n_pulse > 2 + 2 * nbits && pulses[2 + 2 * nbits - 1] < 2000)
+    {
+        return false;
+    }
+    uint32_t bits = 0;
+    for (int ii = 0; ii < nbits; ii++)
+    {
+        uint32_t m = pulses[2 + 2 * ii];
+        if (IR_Decode::near(m, 1200))
+        {
+            bits |= 1u << ii;
+        }
+        else if (!IR_Decode::near(m, 600))
+        {
+            return false;
+        }
+    }
+    func = bits & 0x7f;
+    addr = bits >> 7;
+    return address == 0xffff || address == addr;
+}
+
+bool Sony12_Receiver::decode(uint32_t const *pulses, uint32_t n_pulse, uint16_t &addr, uint16_t &func, uint16_t address)
+{
+    return sony_decode(pulses, n_pulse, 5, addr, func, address);
+}
+
+bool Sony15_Receiver::decode(uint32_t const *pulses, uint32_t n_pulse, uint16_t &addr, uint16_t &func, uint16_t address)
+{
+    return sony_decode(pulses, n_pulse, 8, addr, func, address);
+}
+
+
+//  *****  RAW_Receiver  *****
+
+RAW_Receiver *RAW_Receiver::active_ = nullptr;
+
+RAW_Receiver::RAW_Receiver(int gpio, uint32_t n_samples)
+ : IR_Receiver(gpio), times_(nullptr), max_times_(0), n_times_(nullptr), ctx_(core_context())
+{
+    tmo_worker_ = { .do_work = timeout, .user_data = this };
+    rcv_worker_ = { .do_work = received, .user_data = this };
+    async_context_add_when_pending_worker(ctx_, &rcv_worker_);
+}
+
+RAW_Receiver::~RAW_Receiver()
+{
+    async_context_remove_at_time_worker(ctx_, &tmo_worker_);
+    async_context_remove_when_pending_worker(ctx_, &rcv_worker_);
+    if (active_ == this)
+    {
+        active_ = nullptr;
+    }
+}
+
+void RAW_Receiver::start_message_timeout()
+{
+    active_ = this;
+    async_context_add_at_time_worker_in_ms(ctx_, &tmo_worker_, msg_timeout_);
+}
+
+bool RAW_Receiver::inject(const uint32_t *times, uint32_t n_times)
+{
+    RAW_Receiver *self = active_;
+    if (!self)
+    {
+        return false;
+    }
+    async_context_t *ctx = self->ctx_;
+    async_context_acquire_lock_blocking(ctx);
+    self = active_;
+    if (self && self->times_)
+    {
+        uint32_t nn = n_times < self->max_times_ ? n_times : self->max_times_;
+        memcpy(self->times_, times, nn * sizeof(uint32_t));
+        if (self->n_times_) *self->n_times_ = nn;
+        async_context_remove_at_time_worker(ctx, &self->tmo_worker_);
+        async_context_set_work_pending(ctx, &self->rcv_worker_);
+        active_ = nullptr;
+    }
+    async_context_release_lock(ctx);
+    return self != nullptr;
+}
+
+void RAW_Receiver::timeout(async_context_t *ctx, async_at_time_worker_t *worker)
+{
+    RAW_Receiver *self = static_cast<RAW_Receiver *>(worker->user_data);
+    if (active_ == self)
+    {
+        active_ = nullptr;
+    }
+    if (self->tmo_cb_)
+    {
+        self->tmo_cb_(true, self->n_times_ ? *self->n_times_ : 0, self->times_, self);
+    }
+}
+
+void RAW_Receiver::received(async_context_t *ctx, async_when_pending_worker_t *worker)
+{
+    RAW_Receiver *self = static_cast<RAW_Receiver *>(worker->user_data);
+    if (self->rcv_cb_)
+    {
+        self->rcv_cb_(to_us_since_boot(get_absolute_time()), 0, 0, self);
+    }
+}
+
+
+//  *****  IR_GpioRx  *****
+//
+//  There is no interrupt; ir_sim_sniff adds the edges of a frame as the
+//  handler would have, timed to end now.
+
+IR_GpioRx *IR_GpioRx::instance_ = nullptr;
+
+IR_GpioRx::IR_GpioRx(int gpio) : gpio_(gpio), enabled_(false), edges_(0), overruns_(0)
+{
+    instance_ = this;
+}
+
+IR_GpioRx::~IR_GpioRx()
+{
+    enable(false);
+    instance_ = nullptr;
+}
+
+void IR_GpioRx::enable(bool on)
+{
+    enabled_ = on;
+}
+
+void IR_GpioRx::gpio_irq()
+{
+}
+
+bool ir_sim_sniff(const uint32_t *times, uint32_t n_times)
+{
+    IR_GpioRx *rx = IR_GpioRx::get();
+    bool ret = false;
+    if (rx && rx->enabled())
+    {
+        uint32_t at = static_cast<uint32_t>(to_us_since_boot(get_absolute_time()));
+        for (uint32_t ii = 0; ii < n_times; ii++)
+        {
+            at -= times[ii];
+        }
+        for (uint32_t ii = 0; ii < n_times; ii++)
+        {
+            rx->push(at, ii % 2 == 0);
+            at += times[ii];
+        }
+        if (n_times % 2 == 1)
+        {
+            rx->push(at, false);
+        }
+        ret = true;
+    }
+    return ret;
+}
@@ -0,0 +1,60 @@
+//                  *****  Host flash file system  *****
+
+#include "pfs.h"
+#include <dirent.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string fs_root;
+
+int ffs_pico_createcfg(struct lfs_config *cfg, int offset, int size)
+{
+    cfg->offset = offset;
+    cfg->size = size;
+    cfg->prog = nullptr;
+    cfg->erase = nullptr;
+    return 0;
+}
+
+struct pfs_pfs *pfs_ffs_create(const struct lfs_config *cfg)
+{
+    return reinterpret_cast<struct pfs_pfs *>(const_cast<struct lfs_config *>(cfg));
+}
+
+int pfs_mount(struct pfs_pfs *pfs, const char *name)
+{
+    const char *dir = getenv("REMOTE_HOST_FS");
+    if (!dir || *dir == 0) dir = "remote_fs";
+    mkdir(dir, 0755);
+    char path[PATH_MAX];
+    if (!realpath(dir, path) || chdir(path) != 0)
+    {
+        printf("Failed to mount host file system %s\n", dir);
+        return -1;
+    }
+    fs_root = path;
+    return 0;
+}
+
+const char *host_fs_root()
+{
+    return fs_root.c_str();
+}
+
+//  The application lists "/" as the root of flash. Linked with --wrap=opendir
+//  so absolute paths resolve inside the mounted directory.
+extern "C" DIR *__real_opendir(const char *name);
+
+extern "C" DIR *__wrap_opendir(const char *name)
+{
+    if (!fs_root.empty() && name && name[0] == '/')
+    {
+        std::string path = fs_root + name;
+        return __real_opendir(path.c_str());
+    }
+    return __real_opendir(name);
+}
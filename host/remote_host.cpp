@@ -0,0 +1,905 @@
+//                  *****  Host-native remote  *****
+//
+//  Runs the remote sources against the host stand-ins.
+//
+//      remote_host sim             Read requests from stdin:
+//                                    GET <url>
+//                                    POST <url> <urlencoded body>
+//                                    HEADER <name>: <value>  (added to next GET/POST)
+//                                    WS <json message>
+//                                    IR <mark,space,...>  (to a learn, else the sniffer)
+//                                    WAIT <msec>
+//      remote_host bench [count]   Time the hot paths
+//      remote_host encode          Check the IR protocol encoders, the
+//                                  capture classifier, raw codes,
+//                                  learning from noisy captures and
+//                                  overlapping learns
+//      remote_host timeline        Compare planned and sent IR timing,
+//                                  step by step and batched, and the
+//                                  estimated and taken send times
+//
+//  REMOTE_HOST_FS selects the flash directory (default ./remote_fs) and
+//  REMOTE_HOST_DATA the web resource directory.
+
+#include "remote.h"
+#include "remotefile.h"
+#include "irprocessor.h"
+#include "menu.h"
+#include "config.h"
+#include "raw_receiver.h"
+#include "ir_sim.h"
+#include "irdevice.h"
+#include "irschedule.h"
+#include "irrawcode.h"
+#include "irlearner.h"
+#include "irclassifier.h"
+#include "nec_receiver.h"
+#include "samsung_receiver.h"
+#include "sony_receiver.h"
+#include "urlpattern.h"
+#include "txt.h"
+#include <pfs.h>
+#include <pico/multicore.h>
+#include <pico/async_context_threadsafe_background.h>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define SIM_CLIENT      1
+
+static IR_Processor *host_ir = nullptr;
+
+static void start_remote()
+{
+    stdio_init_all();
+
+    struct lfs_config cfg;
+    ffs_pico_createcfg(&cfg, 0, 0);
+    pfs_mount(pfs_ffs_create(&cfg), "/");
+
+    CONFIG::get()->init();
+    setenv("TZ", CONFIG::get()->timezone(), 1);
+    cyw43_arch_init();
+
+    Remote *remote = Remote::get();
+    remote->setDebug(CONFIG::get()->debug());
+    remote->cleanupFiles();
+    remote->init(INDICATOR_GPIO, BUTTON_GPIO);
+
+    //  As the firmware, the IR engine runs on "core 1" with its own context
+    multicore_launch_core1([]()
+        {
+            static async_context_threadsafe_background_t context;
+            async_context_threadsafe_background_init_with_defaults(&context);
+
+            Remote *remote = Remote::get();
+            IR_Processor *ir = new IR_Processor(remote, IR_SEND_GPIO, IR_RCV_GPIO, &context.core);
+            ir->setBusyCallback(remote->ir_busy, remote);
+            ir->setSniffCallback(remote->ir_sniffed, remote);
+            remote->setIRProcessor(ir);
+            host_ir = ir;
+            ir->run();
+        });
+}
+
+static std::string http_request(const std::string &type, const std::string &url, const std::string &body = "",
+                                const std::string &headers = "")
+{
+    return type + " " + url + " HTTP/1.1\r\nHost: webremote\r\n" + headers +
+           (body.empty() ? "" : "Content-Type: application/x-www-form-urlencoded\r\n") + "\r\n" + body;
+}
+
+static int sim()
+{
+    WEB *web = WEB::get();
+    std::string line;
+    std::string headers;
+    while (std::getline(std::cin, line))
+    {
+        std::string cmd = line.substr(0, line.find(' '));
+        std::string arg = line.length() > cmd.length() ? line.substr(cmd.length() + 1) : "";
+        if (cmd == "GET" || cmd == "POST")
+        {
+            std::string url = arg.substr(0, arg.find(' '));
+            std::string body = arg.length() > url.length() ? arg.substr(url.length() + 1) : "";
+            std::string resp;
+            bool ret = web->sim_http(SIM_CLIENT, http_request(cmd, url, body, headers), resp);
+            std::cout << resp << "\n--- " << (ret ? "true" : "false") << std::endl;
+            headers.clear();
+        }
+        else if (cmd == "HEADER")
+        {
+            headers += arg + "\r\n";
+        }
+        else if (cmd == "WS")
+        {
+            web->sim_message(SIM_CLIENT, arg);
+        }
+        else if (cmd == "IR")
+        {
+            std::vector<uint32_t> times;
+            std::istringstream in(arg);
+            std::string tok;
+            while (std::getline(in, tok, ',')) times.push_back(std::stoul(tok));
+            if (RAW_Receiver::inject(times.data(), times.size()))
+            {
+                std::cout << "IR delivered" << std::endl;
+            }
+            else
+            {
+                std::cout << (ir_sim_sniff(times.data(), times.size()) ? "IR sniffed" : "IR not listening") << std::endl;
+            }
+        }
+        else if (cmd == "WAIT")
+        {
+            std::string msg;
+            while (web->sim_wait_message(SIM_CLIENT, msg, arg.empty() ? 1000 : std::stoul(arg)))
+            {
+                std::cout << msg << std::endl;
+            }
+        }
+        else if (!cmd.empty() && cmd[0] != '#')
+        {
+            std::cout << "Unknown command: " << cmd << std::endl;
+        }
+    }
+    return 0;
+}
+
+
+//  *****  Benchmarks  *****
+
+static void bench_seed()
+{
+    Menu *menu = Menu::addMenu("bench");
+    menu->setRowsPerColumn("6,6,6,6");
+    const char *ops[] = {"open", "up", "down", "left", "right", "ok"};
+    for (int ii = 0; ii < 6; ii++)
+    {
+        menu->setIRCode(ops[ii], "NEC", 4, 0x40 + ii, 0);
+    }
+    menu->saveFile();
+
+    //  Wrapping menu, and one with a slow direction, for the navigation planner
+    menu = Menu::addMenu("benchwrap");
+    menu->setRowsPerColumn("10,10,10,10,10,10");
+    menu->setWrap(true, true);
+    for (int ii = 0; ii < 6; ii++)
+    {
+        menu->setIRCode(ops[ii], "NEC", 5, 0x40 + ii, 0);
+    }
+    menu->saveFile();
+    menu = Menu::addMenu("benchslow");
+    menu->setRowsPerColumn("4,8,8");
+    for (int ii = 0; ii < 6; ii++)
+    {
+        menu->setIRCode(ops[ii], "Sony12", 6, 0x40 + ii, strcmp(ops[ii], "right") == 0 || strcmp(ops[ii], "down") == 0 ? 300 : 0);
+    }
+    menu->saveFile();
+
+    RemoteFile rfile;
+    rfile.loadString("{\"title\": \"Bench\", \"buttons\": []}", "actions_bench.json");
+    for (int pos = 1; pos <= 40; pos++)
+    {
+        RemoteFile::Button *btn = rfile.addButton(pos, pos % 4 == 0 ? "@up" : ("Button " + std::to_string(pos)).c_str(),
+                                                  "#202020/white", "", 0);
+        btn->addAction("NEC", 4, pos, 0);
+        btn->addAction(pos % 2 == 0 ? "Sony12" : "NEC", 1, pos + 1, 0);
+        if (pos % 3 == 0)
+        {
+            btn->addAction("bench.set", 1 + pos % 4, 1 + pos % 6, 0);
+        }
+    }
+    RemoteFile::Button *btn = rfile.addButton(41, "Repeat", "#202020/white", "", 150);
+    btn->addAction("NEC", 4, 0x50, 0);
+    rfile.saveFile();
+}
+
+static void bench_run(const char *name, int count, const std::function<void()> &fn)
+{
+    fn();
+    auto start = std::chrono::steady_clock::now();
+    for (int ii = 0; ii < count; ii++)
+    {
+        fn();
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    printf("%-28s %8d %12.2f us/op %12.0f op/s\n", name, count, us / count, count * 1e6 / us);
+}
+
+//  Menu navigation as set_pos did it before the planner, for comparison:
+//  straight lines, and from an unknown position into the edge nearer by count
+
+static void legacy_axis(const Menu *menu, int from, int to, int count, const char *dec, const char *inc,
+                        int &steps, uint32_t &msec)
+{
+    if (from == -1)
+    {
+        bool low = to < count / 2;
+        int back = low ? to : count - 1 - to;
+        steps += count - 1 + back;
+        msec += menu->moveTime(low ? dec : inc, count - 1) + menu->moveTime(low ? inc : dec, back);
+    }
+    else
+    {
+        int nn = to > from ? to - from : from - to;
+        steps += nn;
+        msec += menu->moveTime(to > from ? inc : dec, nn);
+    }
+}
+
+//  Time of planned moves, taking runs of one operation together as moveTime does
+static uint32_t moves_time(const Menu *menu, const std::deque<Command::Step> &steps)
+{
+    uint32_t ret = 0;
+    for (auto it = steps.cbegin(); it != steps.cend(); )
+    {
+        auto end = it;
+        while (end != steps.cend() && end->type() == it->type() && end->address() == it->address() &&
+               end->value() == it->value())
+        {
+            ++end;
+        }
+        for (auto op = menu->commands().cbegin(); op != menu->commands().cend(); ++op)
+        {
+            if (op->second.type() == it->type() && op->second.address() == it->address() &&
+                op->second.value() == it->value())
+            {
+                ret += menu->moveTime(op->first, end - it);
+                break;
+            }
+        }
+        it = end;
+    }
+    return ret;
+}
+
+//  Every set action from an unknown position and from each entry
+static void bench_menus()
+{
+    std::set<std::string> names;
+    Menu::menuNames(names);
+    int total_legacy = 0;
+    int total_planned = 0;
+    uint64_t total_legacy_ms = 0;
+    uint64_t total_planned_ms = 0;
+    for (auto name = names.cbegin(); name != names.cend(); ++name)
+    {
+        const Menu *menu = Menu::getMenu(*name);
+        if (!menu)
+        {
+            continue;
+        }
+        std::vector<int> rows;
+        std::vector<std::string> srows;
+        TXT::split(menu->rowsPerColumn(), ",", srows);
+        for (auto it = srows.cbegin(); it != srows.cend(); ++it)
+        {
+            rows.push_back(atoi(it->c_str()));
+        }
+
+        int legacy = 0;
+        int planned = 0;
+        uint32_t legacy_ms = 0;
+        uint32_t planned_ms = 0;
+        std::deque<Command::Step> steps;
+        for (int from = -1; from < static_cast<int>(rows.size()); from++)
+        {
+            for (int from_row = 0; from_row < (from < 0 ? 1 : rows[from]); from_row++)
+            {
+                for (int col = 0; col < rows.size(); col++)
+                {
+                    for (int row = 0; row < rows[col]; row++)
+                    {
+                        Menu::Position pos;
+                        menu->resetPosition(pos);
+                        if (from >= 0)
+                        {
+                            pos.col = from;
+                            pos.colrow[from] = from_row;
+                        }
+                        legacy_axis(menu, pos.col, col, rows.size(), "left", "right", legacy, legacy_ms);
+                        legacy_axis(menu, pos.colrow[col], row, rows[col], "up", "down", legacy, legacy_ms);
+
+                        menu->getSteps(Command::Step(*name + ".set(-open-ok)", col + 1, row + 1, 0), steps, pos);
+                        planned += steps.size();
+                        planned_ms += moves_time(menu, steps);
+                    }
+                }
+            }
+        }
+        printf("menu %-12s %-5s legacy %6d steps %8lu ms, planned %6d steps %8lu ms, saved %d steps %ld ms\n",
+               name->c_str(), menu->wrapColumns() || menu->wrapRows() ? "wrap" : "",
+               legacy, static_cast<unsigned long>(legacy_ms), planned, static_cast<unsigned long>(planned_ms),
+               legacy - planned, static_cast<long>(legacy_ms) - static_cast<long>(planned_ms));
+        total_legacy += legacy;
+        total_planned += planned;
+        total_legacy_ms += legacy_ms;
+        total_planned_ms += planned_ms;
+    }
+    printf("menu navigation: %d IR steps saved of %d, %llu ms saved of %llu\n", total_legacy - total_planned, total_legacy,
+           static_cast<unsigned long long>(total_legacy_ms - total_planned_ms),
+           static_cast<unsigned long long>(total_legacy_ms));
+}
+
+//  Route table as it was before URLPattern, for comparison
+static const char *bench_regex_routes[] =
+{
+    "^/index(|\\.html)$", "^/config(|\\.html)$", "^/backup(|\\.html)$", "^/menu(|\\.html)$",
+    "^(.*)/setup(|\\.html)$", "^(.*)/setup(|\\.html)/([0-9]+)$", "^/editprompt(|\\.html)$",
+    "^/test(|\\.html)$", "^/log(|\\.html)$",
+};
+
+static const URLPattern bench_url_routes[] =
+{
+    "/index[.html]", "/config[.html]", "/backup[.html]", "/menu[.html]",
+    "*/setup[.html]", "*/setup[.html]/#", "/editprompt[.html]",
+    "/test[.html]", "/log[.html]",
+};
+
+static const char *bench_urls[] =
+{
+    "/index.html", "/menu", "/log.html", "/bench/setup", "/tv/living/setup.html/17",
+    "/bench", "/webremote.css", "/test",
+};
+
+static void bench_routes(int count)
+{
+    std::vector<std::regex> regs;
+    for (const char *route : bench_regex_routes)
+    {
+        regs.emplace_back(route, std::regex_constants::extended);
+    }
+
+    int ii = 0;
+    bench_run("route std::regex", count, [&]()
+        {
+            std::string url(bench_urls[ii++ % count_of(bench_urls)]);
+            std::smatch match;
+            for (const std::regex &reg : regs)
+            {
+                if (std::regex_match(url, match, reg)) break;
+            }
+        });
+
+    ii = 0;
+    bench_run("route URLPattern", count, [&]()
+        {
+            std::string url(bench_urls[ii++ % count_of(bench_urls)]);
+            URLPattern::Match match;
+            for (const URLPattern &route : bench_url_routes)
+            {
+                if (route.match(url, match)) break;
+            }
+        });
+}
+
+static int bench(int count)
+{
+    WEB *web = WEB::get();
+    Remote::get()->setDebug(0);
+    ir_sim_set_time_scale(0.0);
+    bench_seed();
+
+    printf("%-28s %8s %15s %15s\n", "benchmark", "count", "latency", "throughput");
+
+    bench_routes(count * 10);
+
+    std::string resp;
+    std::string get_index = http_request("GET", "/bench");
+    bench_run("http_get /bench", count, [&]() { web->sim_http(SIM_CLIENT, get_index, resp); });
+
+    size_t etag = resp.find("ETag: ");
+    std::string get_cached = http_request("GET", "/bench", "",
+        "If-None-Match: " + resp.substr(etag + 6, resp.find("\r\n", etag) - etag - 6) + "\r\n");
+    bench_run("http_get /bench (304)", count, [&]() { web->sim_http(SIM_CLIENT, get_cached, resp); });
+
+    std::string get_home = http_request("GET", "/");
+    bool home = false;
+    bench_run("http_get / and /bench", count, [&]()
+        {
+            web->sim_http(SIM_CLIENT, home ? get_home : get_index, resp);
+            home = !home;
+        });
+
+    std::string get_setup = http_request("GET", "/bench/setup/7");
+    bench_run("http_get /bench/setup/7", count, [&]() { web->sim_http(SIM_CLIENT, get_setup, resp); });
+
+    std::string get_grid = http_request("GET", "/bench/setup");
+    bench_run("http_get /bench/setup", count, [&]() { web->sim_http(SIM_CLIENT, get_grid, resp); });
+
+    std::string get_menu = http_request("GET", "/menu?menu=bench");
+    bench_run("http_get /menu?menu=bench", count, [&]() { web->sim_http(SIM_CLIENT, get_menu, resp); });
+
+    //  The stylesheet URL is fingerprinted when WEB_HASH is on
+    web->sim_http(SIM_CLIENT, get_home, resp);
+    size_t href = resp.find("/webremote.");
+    std::string css = resp.substr(href, resp.find('"', href) - href);
+    std::string get_css = http_request("GET", css);
+    bench_run("http_get /webremote.css", count, [&]() { web->sim_http(SIM_CLIENT, get_css, resp); });
+
+    std::string get_css_gz = http_request("GET", css, "", "Accept-Encoding: gzip, deflate\r\n");
+    bench_run("http_get /webremote.css gzip", count, [&]() { web->sim_http(SIM_CLIENT, get_css_gz, resp); });
+
+    RemoteFile rfile;
+    bench_run("RemoteFile::loadFile", count, [&]() { rfile.loadFile("actions_bench.json"); });
+
+    Menu *menu = Menu::getMenu("bench");
+    std::deque<Command::Step> steps;
+    int ii = 0;
+    bench_run("Menu::getSteps", count, [&]()
+        {
+            Command::Step step("bench.set", 1 + ii % 4, 1 + (ii / 4) % 6, 0);
+            menu->getSteps(step, steps);
+            ++ii;
+        });
+
+    std::string msg;
+    int btn = 0;
+    bench_run("btnVal click -> reply", count / 10 + 1, [&]()
+        {
+            btn = btn % 40 + 1;
+            web->sim_message(SIM_CLIENT, "{\"func\":\"btnVal\",\"btnVal\":\"" + std::to_string(btn) +
+                                         "\",\"action\":\"click\",\"path\":\"/bench\",\"duration\":\"0.1\"}");
+            while (web->sim_wait_message(SIM_CLIENT, msg, 2000) && msg.find("btn_resp") == std::string::npos);
+        });
+
+    //  Release of a repeating button queued behind a burst of clicks
+    int stops = count / 30 + 1;
+    double stop_us = 0.0;
+    for (int ii = 0; ii < stops; ii++)
+    {
+        web->sim_message(SIM_CLIENT, "{\"func\":\"btnVal\",\"btnVal\":\"41\",\"action\":\"press\",\"path\":\"/bench\"}");
+        while (web->sim_wait_message(SIM_CLIENT, msg, 2000) && msg.find("\"press\"") == std::string::npos);
+        for (int click = 1; click <= 6; click++)
+        {
+            web->sim_message(SIM_CLIENT, "{\"func\":\"btnVal\",\"btnVal\":\"" + std::to_string(click) +
+                                         "\",\"action\":\"click\",\"path\":\"/bench\"}");
+        }
+        auto start = std::chrono::steady_clock::now();
+        web->sim_message(SIM_CLIENT, "{\"func\":\"btnVal\",\"btnVal\":\"41\",\"action\":\"release\",\"path\":\"/bench\"}");
+        while (web->sim_wait_message(SIM_CLIENT, msg, 2000) && msg.find("\"release\"") == std::string::npos);
+        stop_us += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+        while (web->sim_wait_message(SIM_CLIENT, msg, 50));
+    }
+    printf("%-28s %8d %12.2f us/op %12.0f op/s\n", "release behind 6 clicks", stops, stop_us / stops, stops * 1e6 / stop_us);
+
+    IR_PioTx::Stats tx;
+    ir_sim_tx_stats(tx);
+    printf("IR programs: %u  marks and spaces: %u\n", tx.programs, tx.words);
+
+    bench_menus();
+    return 0;
+}
+
+
+
+//  *****  Encoder checks  *****
+
+#define M   562
+#define Z   562
+#define O   1687
+
+//  NEC 4 0x40: address 0x04 0xfb, command 0x40 0xbf, least significant bit first
+static const uint32_t encode_nec_4_40[] =
+{
+    9000, 4500,
+    M, Z, M, Z, M, O, M, Z, M, Z, M, Z, M, Z, M, Z, M, O, M, O, M, Z, M, O, M, O, M, O, M, O, M, O,
+    M, Z, M, Z, M, Z, M, Z, M, Z, M, Z, M, O, M, Z, M, O, M, O, M, O, M, O, M, O, M, O, M, Z, M, O,
+    562, 39970
+};
+
+#undef M
+#undef Z
+#undef O
+
+static const uint32_t encode_nec_repeat[] = { 9000, 2250, 562, 96188 };
+
+//  Sony12 1 21: 7 command bits then 5 address bits, in the mark widths
+static const uint32_t encode_sony12_1_21[] =
+{
+    2400, 600,
+    1200, 600, 600, 600, 1200, 600, 600, 600, 1200, 600, 600, 600, 600, 600,
+    1200, 600, 600, 600, 600, 600, 600, 600, 600, 25800
+};
+
+static int encode_checks = 0;
+static int encode_failed = 0;
+
+static void encode_check(const std::string &name, bool ok)
+{
+    ++encode_checks;
+    if (!ok) ++encode_failed;
+    printf("%-40s %s\n", name.c_str(), ok ? "ok" : "FAILED");
+}
+
+static IRPulses encode_expect(const uint32_t *times, int ntimes, uint32_t carrier, int copies = 1)
+{
+    IRPulses ret;
+    ret.setCarrier(carrier);
+    for (int cc = 0; cc < copies; cc++)
+    {
+        for (int ii = 0; ii < ntimes; ii++)
+        {
+            ii % 2 == 0 ? ret.mark(times[ii]) : ret.space(times[ii]);
+        }
+    }
+    return ret;
+}
+
+static int encode()
+{
+    typedef bool (*Decoder)(uint32_t const *, uint32_t, uint16_t &, uint16_t &, uint16_t);
+    static const struct { const char *proto; Decoder decode; uint16_t address; } decoders[] =
+    {
+        {"NEC", NEC_Receiver::decode, 0x04},
+        {"NEC", NEC_Receiver::decode, 0x1234},
+        {"Sam", SAMSUNG_Receiver::decode, 0x07},
+        {"Sony12", Sony12_Receiver::decode, 0x01},
+        {"Sony15", Sony15_Receiver::decode, 0x97},
+    };
+
+    //  Known frames
+    const IR_Encoder *nec = IR_Device::encoder(IR_Device::protocolId("NEC"));
+    const IR_Encoder *sony12 = IR_Device::encoder(IR_Device::protocolId("Sony12"));
+    IRPulses pulses;
+    nec->encode(4, 0x40, false, pulses);
+    encode_check("NEC 4 0x40 frame", pulses == encode_expect(encode_nec_4_40, count_of(encode_nec_4_40), 38000));
+    pulses.clear();
+    nec->encode(4, 0x40, true, pulses);
+    encode_check("NEC repeat frame", pulses == encode_expect(encode_nec_repeat, count_of(encode_nec_repeat), 38000));
+    pulses.clear();
+    sony12->encode(1, 21, false, pulses);
+    encode_check("Sony12 1 21 frames",
+                 pulses == encode_expect(encode_sony12_1_21, count_of(encode_sony12_1_21), 40000, 3));
+
+    //  Each protocol decodes what it encodes and fills its frame time
+    for (auto &dd : decoders)
+    {
+        const IR_Encoder *enc = IR_Device::encoder(IR_Device::protocolId(dd.proto));
+        for (uint16_t value : {0, 1, 0x2a, 0x55, 0x7f})
+        {
+            pulses.clear();
+            enc->encode(dd.address, value, false, pulses);
+            uint16_t addr = 0;
+            uint16_t func = 0;
+            bool ok = dd.decode(pulses.times(), pulses.size(), addr, func, 0xffff) &&
+                      addr == dd.address && func == value &&
+                      pulses.duration() == enc->messageTime(false) * 1000ull;
+            encode_check(std::string(dd.proto) + " " + std::to_string(dd.address) + " " +
+                         std::to_string(value) + " round trip", ok);
+        }
+    }
+
+    //  Each protocol's capture, exact or 10% slow, singles out its decoder
+    std::vector<std::string> protos;
+    std::vector<IR_Classifier::Signature> sigs(IR_Device::protocols(protos));
+    for (int proto = 0; proto < protos.size(); proto++)
+    {
+        IR_Classifier::signature(*IR_Device::encoder(proto), sigs[proto]);
+    }
+    std::vector<IR_Classifier::Match> matches;
+    for (int proto = 0; proto < protos.size(); proto++)
+    {
+        pulses.clear();
+        IR_Device::encoder(proto)->encode(1, 0x2a, false, pulses);
+        std::vector<uint32_t> capture(pulses.times(), pulses.times() + pulses.size());
+        IR_Classifier::classify(capture.data(), capture.size(), sigs, matches);
+        bool ok = IR_Classifier::decisive(matches) && matches[0].proto == proto && matches[0].confidence == 100;
+        for (auto &tt : capture)
+        {
+            tt = tt * 11 / 10;
+        }
+        IR_Classifier::classify(capture.data(), capture.size(), sigs, matches);
+        ok = ok && IR_Classifier::decisive(matches) && matches[0].proto == proto;
+        encode_check(protos[proto] + " classified", ok);
+    }
+
+    //  A truncated Sony frame could be either length, and a stranger matches nothing
+    pulses.clear();
+    sony12->encode(1, 21, false, pulses);
+    IR_Classifier::classify(pulses.times(), 15, sigs, matches);
+    encode_check("Truncated Sony ambiguous", matches.size() == 2 && !IR_Classifier::decisive(matches));
+    static const uint32_t stranger[] = {3000, 3000, 500, 500, 500, 1500, 500};
+    IR_Classifier::classify(stranger, count_of(stranger), sigs, matches);
+    encode_check("Unknown leader unmatched", matches.empty());
+
+    //  A capture no decoder takes is kept raw, in a few dozen bytes, and replays as quantized
+    pulses.clear();
+    nec->encode(4, 0x40, false, pulses);
+    std::vector<uint32_t> capture(pulses.times(), pulses.times() + 67);
+    for (int ii = 0; ii < capture.size(); ii++)
+    {
+        capture[ii] += ii % 3 == 0 ? 60 : ii % 3 == 1 ? -40 : 0;
+    }
+    std::string raw;
+    IRPulses replay;
+    uint16_t addr = 0;
+    uint16_t func = 0;
+    bool ok = IR_RawCode::encode(capture.data(), capture.size(), raw) && raw.size() <= 64 &&
+              IR_RawCode::decode(raw, replay) && replay.carrier() == IR_RAW_CARRIER * 1000 &&
+              replay.size() == capture.size() && NEC_Receiver::decode(replay.times(), replay.size(), addr, func, 0xffff) &&
+              addr == 4 && func == 0x40;
+    printf("%s (%zu bytes)\n", raw.c_str(), raw.size());
+    encode_check("NEC capture raw", ok);
+    std::string again;
+    encode_check("Raw code stable", IR_RawCode::encode(replay.times(), replay.size(), again) && again == raw);
+    static const uint32_t rc5[] = {890, 890, 890, 890, 1780, 1780, 890, 890, 890, 890, 1780, 890, 890, 1780,
+                                   890, 890, 890, 890, 890, 890, 1780, 1780, 890};
+    replay.clear();
+    ok = IR_RawCode::encode(rc5, count_of(rc5), raw) && IR_RawCode::decode(raw, replay) &&
+         replay == encode_expect(rc5, count_of(rc5), IR_RAW_CARRIER * 1000);
+    printf("%s (%zu bytes)\n", raw.c_str(), raw.size());
+    encode_check("Unknown capture raw", ok);
+    replay.clear();
+    encode_check("Bad raw codes refused",
+                 !IR_RawCode::decode("raw:38:", replay) && !IR_RawCode::decode("raw:38:900/450:", replay) &&
+                 !IR_RawCode::decode("raw:38:900/450:A*", replay) && !IR_RawCode::decode("raw:x:900/450:A", replay) &&
+                 !IR_RawCode::decode("raw:38:900,450:A", replay) && !IR_RawCode::encode(rc5, 4, raw));
+
+    //  Glitches are merged or dropped
+    uint32_t glitched[] = {9000, 4500, 560, 40, 520, 1690, 560, 560, 60};
+    encode_check("Glitches removed", IR_Learner::deglitch(glitched, count_of(glitched)) == 5 &&
+                                     glitched[2] == 1120 && glitched[3] == 1690 && glitched[4] == 560);
+
+    //  Noisy learns: one capture as read, against up to three with glitches removed
+    uint32_t seed = 1;
+    auto rnd = [&seed](uint32_t range) { seed = seed * 1103515245 + 12345; return (seed >> 8) % range; };
+    static const uint32_t lamp[] = {300, 9700, 300, 9700, 300, 9700, 300};
+    int learns = 500;
+    int single_ok = 0;
+    int multi_ok = 0;
+    uint32_t buffers[IR_LEARN_CAPTURES][IR_DEVICE_SAMPLES];
+    for (int ll = 0; ll < learns; ll++)
+    {
+        uint16_t value = rnd(256);
+        const uint32_t *captures[IR_LEARN_CAPTURES];
+        uint32_t counts[IR_LEARN_CAPTURES];
+        int n_captures = 0;
+        bool first_ok = false;
+        for (int cc = 0; cc < IR_LEARN_CAPTURES; cc++)
+        {
+            uint32_t *buf = buffers[n_captures];
+            uint32_t nn = 0;
+            if (rnd(100) < 15)
+            {
+                //  Lamp flicker read as a press
+                for (uint32_t tt : lamp) buf[nn++] = tt;
+            }
+            else
+            {
+                pulses.clear();
+                nec->encode(4, value, false, pulses);
+                for (int ii = 0; ii < 67; ii++)
+                {
+                    uint32_t tt = pulses[ii] * (88 + rnd(25)) / 100;
+                    if (ii % 2 == 1 && rnd(100) < 2)
+                    {
+                        //  Light spike in a space
+                        uint32_t at = rnd(tt - 50);
+                        buf[nn++] = at;
+                        buf[nn++] = 20 + rnd(60);
+                        tt -= at + buf[nn - 1];
+                    }
+                    buf[nn++] = tt;
+                }
+            }
+            if (cc == 0)
+            {
+                uint16_t addr = 0;
+                uint16_t func = 0;
+                first_ok = NEC_Receiver::decode(buf, nn, addr, func, 0xffff) && addr == 4 && func == value;
+            }
+            nn = IR_Learner::deglitch(buf, nn);
+            if (nn >= IR_LEARN_MIN_TIMES)
+            {
+                captures[n_captures] = buf;
+                counts[n_captures++] = nn;
+            }
+        }
+        std::string type;
+        uint16_t addr = 0;
+        uint16_t func = 0;
+        IR_Device::learn(captures, counts, n_captures, type, addr, func);
+        single_ok += first_ok ? 1 : 0;
+        multi_ok += type == "NEC" && addr == 4 && func == value ? 1 : 0;
+    }
+    printf("noisy learns: %d of %d from one capture, %d of %d from %d\n",
+           single_ok, learns, multi_ok, learns, IR_LEARN_CAPTURES);
+    encode_check("Noisy learns", multi_ok > single_ok && multi_ok >= learns * 95 / 100);
+
+    //  Unknown captures average to one raw code, an outlier is dropped
+    uint32_t unknown[IR_LEARN_CAPTURES][count_of(rc5)];
+    const uint32_t *captures[IR_LEARN_CAPTURES];
+    uint32_t counts[IR_LEARN_CAPTURES];
+    for (int cc = 0; cc < IR_LEARN_CAPTURES; cc++)
+    {
+        for (int ii = 0; ii < count_of(rc5); ii++)
+        {
+            unknown[cc][ii] = rc5[ii] + (cc == 1 ? 40 : cc == 2 ? -40 : 0);
+        }
+        captures[cc] = unknown[cc];
+        counts[cc] = count_of(rc5);
+    }
+    unknown[2][5] = 3000;
+    uint32_t averaged[count_of(rc5)];
+    int used = 0;
+    ok = IR_Learner::average(captures, counts, IR_LEARN_CAPTURES, averaged, used) == count_of(rc5) && used == 2 &&
+         averaged[0] == 910 && averaged[4] == 1800;
+    encode_check("Outlier capture dropped", ok);
+    uint16_t addr2 = 0;
+    uint16_t func2 = 0;
+    ok = IR_Device::learn(captures, counts, IR_LEARN_CAPTURES, raw, addr2, func2) == 0 && IR_RawCode::isRaw(raw.c_str());
+    encode_check("Unknown captures learned raw", ok);
+
+    //  A macro with its delays is one program, a carrier change is refused
+    pulses.clear();
+    nec->encode(4, 0x40, false, pulses);
+    pulses.space(200000);
+    nec->encode(4, 0x40, true, pulses);
+    encode_check("NEC macro program", pulses.duration() == 416000 && pulses.size() == 72);
+    encode_check("Carrier change refused", !sony12->encode(1, 21, false, pulses) && pulses.duration() == 416000);
+
+    //  An ir_get while a learn waits is refused, and both commands go back
+    //  to the pool
+    WEB *web = WEB::get();
+    while (!host_ir) sleep_ms(1);
+    std::string get_ir = "{\"func\":\"ir_get\",\"ir_get\":\"0\",\"path\":\"/test\"}";
+    std::string msg;
+    std::string replies;
+    web->sim_message(SIM_CLIENT, get_ir);
+    sleep_ms(100);
+    web->sim_message(SIM_CLIENT, get_ir);
+    while (web->sim_wait_message(SIM_CLIENT, msg, 200)) replies += msg;
+    ok = replies.find("\"action\":\"busy\"") != std::string::npos;
+    for (int press = 0; press < 2; press++)
+    {
+        ok = RAW_Receiver::inject(encode_nec_4_40, count_of(encode_nec_4_40) - 1) && ok;
+        sleep_ms(100);
+    }
+    replies.clear();
+    while (web->sim_wait_message(SIM_CLIENT, msg, 500)) replies += msg;
+    Command::PoolStats pool;
+    Command::poolStats(pool);
+    ok = ok && replies.find("\"type\":\"NEC\"") != std::string::npos && pool.in_use == 0;
+    encode_check("Overlapping learns released", ok);
+
+    printf("%d checks, %d failed\n", encode_checks, encode_failed);
+    return encode_failed != 0;
+}
+
+//  *****  Timeline simulation  *****
+
+static void timeline_seed()
+{
+    RemoteFile rfile;
+    rfile.loadString("{\"title\": \"Timeline\", \"buttons\": []}", "actions_timeline.json");
+    RemoteFile::Button *btn = rfile.addButton(1, "Repeat x4", "#202020/white", "", 0);
+    for (int ii = 0; ii < 4; ii++)
+    {
+        btn->addAction("NEC", 4, 2, 30);
+    }
+    btn = rfile.addButton(2, "Carriers", "#202020/white", "", 0);
+    btn->addAction("NEC", 4, 1, 100);
+    btn->addAction("Sony12", 1, 21, 50);
+    btn->addAction("Sony12", 1, 22, 0);
+    btn->addAction("NEC", 4, 3, 0);
+    btn = rfile.addButton(3, "Delays", "#202020/white", "", 0);
+    btn->addAction("NEC", 4, 5, 250);
+    btn->addAction("", 0, 0, 120);
+    btn->addAction("Sam", 7, 9, 40);
+    btn->addAction("NEC", 4, 6, 5);
+    btn->addAction("NEC", 4, 7, 0);
+    btn = rfile.addButton(4, "Raw", "#202020/white", "", 0);
+    IRPulses pulses;
+    std::string raw;
+    IR_Device::encoder(IR_Device::protocolId("NEC"))->encode(4, 8, false, pulses);
+    IR_RawCode::encode(pulses.times(), 67, raw);
+    btn->addAction(raw.c_str(), 0, 0, 60);
+    btn->addAction("NEC", 4, 8, 0);
+    btn->addAction(raw.c_str(), 0, 0, 0);
+    rfile.saveFile();
+}
+
+static int timeline()
+{
+    WEB *web = WEB::get();
+    Remote::get()->setDebug(0);
+    ir_sim_set_time_scale(1.0);
+    timeline_seed();
+    while (!host_ir) sleep_ms(1);
+
+    RemoteFile rfile;
+    rfile.loadFile("actions_timeline.json");
+
+    printf("%-12s %-6s %8s %14s %14s %10s %10s\n", "button", "mode", "frames", "max error", "mean error",
+           "estimate", "taken");
+    int ret = 0;
+    for (bool batch : {false, true})
+    {
+        host_ir->setBatch(batch);
+        for (int pos = 1; pos <= 4; pos++)
+        {
+            const RemoteFile::Button *btn = rfile.getButton(pos);
+            std::vector<uint64_t> planned;
+            IRSchedule::timeline(btn->plan(), btn->plan().size(), planned);
+
+            std::string msg;
+            web->sim_message(SIM_CLIENT, "{\"func\":\"btn_time\",\"btn_time\":\"" + std::to_string(pos) +
+                                         "\",\"path\":\"/timeline\"}");
+            while (web->sim_wait_message(SIM_CLIENT, msg, 5000) && msg.find("time_resp") == std::string::npos);
+            JSONMap resp(msg.c_str());
+            unsigned long estimate = resp.intValue("duration");
+
+            std::vector<uint64_t> sent;
+            ir_sim_take_output(sent);
+            absolute_time_t start = get_absolute_time();
+            web->sim_message(SIM_CLIENT, "{\"func\":\"btnVal\",\"btnVal\":\"" + std::to_string(pos) +
+                                         "\",\"action\":\"click\",\"path\":\"/timeline\"}");
+            while (web->sim_wait_message(SIM_CLIENT, msg, 5000) && msg.find("btn_resp") == std::string::npos);
+            unsigned long taken = absolute_time_diff_us(start, get_absolute_time()) / 1000;
+            ir_sim_take_output(sent);
+
+            if (sent.size() != planned.size())
+            {
+                printf("%-12s %-6s %8s planned %zu frames, sent %zu\n", btn->label(),
+                       batch ? "batch" : "step", "", planned.size(), sent.size());
+                ret = 1;
+                continue;
+            }
+            int64_t max_err = 0;
+            int64_t sum_err = 0;
+            for (size_t ii = 0; ii < sent.size(); ii++)
+            {
+                int64_t err = static_cast<int64_t>(sent[ii] - sent[0]) - static_cast<int64_t>(planned[ii]);
+                err = err < 0 ? -err : err;
+                max_err = err > max_err ? err : max_err;
+                sum_err += err;
+            }
+            printf("%-12s %-6s %8zu %11lld us %11lld us %7lu ms %7lu ms\n", btn->label(), batch ? "batch" : "step",
+                   sent.size(), static_cast<long long>(max_err), static_cast<long long>(sum_err / sent.size()),
+                   estimate, taken);
+        }
+    }
+    return ret;
+}
+
+int main(int argc, char **argv)
+{
+    std::string mode = argc > 1 ? argv[1] : "sim";
+    start_remote();
+
+    int ret = 1;
+    if (mode == "sim")
+    {
+        ret = sim();
+    }
+    else if (mode == "bench")
+    {
+        ret = bench(argc > 2 ? atoi(argv[2]) : 1000);
+    }
+    else if (mode == "encode")
+    {
+        ret = encode();
+    }
+    else if (mode == "timeline")
+    {
+        ret = timeline();
+    }
+    else
+    {
+        printf("Usage: %s [sim | bench [count] | encode | timeline]\n", argv[0]);
+    }
+
+    fflush(stdout);
+    _exit(ret);
+}
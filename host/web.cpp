@@ -0,0 +1,191 @@
+//                  *****  Host web transport implementation  *****
+
+#include "web.h"
+#include "web_files.h"
+#include "logger.h"
+#include "pico/cyw43_arch.h"
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+
+WEB::WEB()
+ : log_(nullptr), hostname_("webremote"), ap_active_(false), http_listening_(false), https_listening_(false),
+   tls_cb_(nullptr), http_cb_(nullptr), http_udata_(nullptr), msg_cb_(nullptr), msg_udata_(nullptr),
+   notice_cb_(nullptr), notice_udata_(nullptr)
+{
+}
+
+WEB *WEB::get()
+{
+    static WEB *singleton = nullptr;
+    if (!singleton) singleton = new WEB();
+    return singleton;
+}
+
+bool WEB::init()
+{
+    http_listening_ = true;
+    notice(STA_INITIALIZING);
+    return true;
+}
+
+bool WEB::connect_to_wifi(const std::string &hostname, const std::string &ssid, const std::string &password)
+{
+    hostname_ = hostname;
+    ssid_ = ssid;
+    notice(STA_CONNECTED);
+    return true;
+}
+
+bool WEB::update_wifi(const std::string &hostname, const std::string &ssid, const std::string &password)
+{
+    return connect_to_wifi(hostname, ssid, password);
+}
+
+void WEB::enable_ap(int minutes, const std::string &name)
+{
+    ap_active_ = minutes > 0;
+    notice(ap_active_ ? AP_ACTIVE : AP_INACTIVE);
+}
+
+bool WEB::scan_wifi(ClientHandle client, bool (*cb)(WEB *web, ClientHandle client, const WiFiScanData &data, void *udata), void *udata)
+{
+    WiFiScanData data;
+    if (!ssid_.empty()) data[ssid_] = -50;
+    return cb(this, client, data, udata);
+}
+
+bool WEB::send_data(ClientHandle client, const char *data, uint32_t datalen, SendMode mode)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_[client].http.append(data, datalen);
+    }
+    if (mode == PREALL)
+    {
+        free(const_cast<char *>(data));
+    }
+    return true;
+}
+
+bool WEB::send_message(ClientHandle client, const std::string &message)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    clients_[client].messages.push_back(message);
+    cond_.notify_all();
+    return true;
+}
+
+void WEB::broadcast_websocket(const std::string &message)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = clients_.begin(); it != clients_.end(); ++it)
+    {
+        it->second.messages.push_back(message);
+    }
+    cond_.notify_all();
+}
+
+bool WEB::sim_http(ClientHandle client, const std::string &request, std::string &response)
+{
+    bool ret = false;
+    HTTPRequest rqst(request);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        clients_[client].http.clear();
+    }
+    if (http_cb_)
+    {
+        bool close = true;
+        async_context_acquire_lock_blocking(cyw43_arch_async_context());
+        ret = http_cb_(this, client, rqst, close, http_udata_);
+        async_context_release_lock(cyw43_arch_async_context());
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    response.swap(clients_[client].http);
+    return ret;
+}
+
+void WEB::sim_message(ClientHandle client, const std::string &message)
+{
+    if (msg_cb_)
+    {
+        async_context_acquire_lock_blocking(cyw43_arch_async_context());
+        msg_cb_(this, client, message, msg_udata_);
+        async_context_release_lock(cyw43_arch_async_context());
+    }
+}
+
+bool WEB::sim_wait_message(ClientHandle client, std::string &message, uint32_t timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    Client &cl = clients_[client];
+    bool ret = cond_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [&cl]() { return !cl.messages.empty(); });
+    if (ret)
+    {
+        message = cl.messages.front();
+        cl.messages.pop_front();
+    }
+    return ret;
+}
+
+
+//  *****  WEB_FILES  *****
+
+WEB_FILES *WEB_FILES::get()
+{
+    static WEB_FILES *singleton = nullptr;
+    if (!singleton) singleton = new WEB_FILES();
+    return singleton;
+}
+
+const char *WEB_FILES::content_type(const std::string &name)
+{
+    static const char *types[][2] =
+        {
+            {".html", "text/html"}, {".js", "text/javascript"}, {".css", "text/css"},
+            {".json", "application/json"}, {".svg", "image/svg+xml"}, {".ico", "image/x-icon"},
+        };
+    for (size_t ii = 0; ii < sizeof(types) / sizeof(*types); ii++)
+    {
+        size_t ll = strlen(types[ii][0]);
+        if (name.length() > ll && name.compare(name.length() - ll, ll, types[ii][0]) == 0)
+        {
+            return types[ii][1];
+        }
+    }
+    return "application/octet-stream";
+}
+
+bool WEB_FILES::get_file(const std::string &name, const char * &data, u16_t &datalen)
+{
+    auto it = files_.find(name);
+    if (it == files_.end())
+    {
+        if (name.empty() || name.find("..") != std::string::npos)
+        {
+            return false;
+        }
+        const char *dir = getenv("REMOTE_HOST_DATA");
+        std::string path = std::string(dir && *dir ? dir : REMOTE_HOST_DATA_DIR) + "/" + name;
+        if (name.length() > 3 && name.compare(name.length() - 3, 3, ".gz") == 0)
+        {
+            path = std::string(REMOTE_HOST_GZ_DIR) + "/" + name;
+        }
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+        {
+            return false;
+        }
+        std::ostringstream body;
+        body << in.rdbuf();
+        std::string file = "HTTP/1.1 200 OK\r\nContent-Type: " + std::string(content_type(name)) +
+                           "\r\nContent-Length: " + std::to_string(body.str().length()) + "\r\n\r\n" + body.str();
+        it = files_.emplace(name, file).first;
+    }
+    data = it->second.c_str();
+    datalen = it->second.length();
+    return true;
+}
@@ -0,0 +1,63 @@
+//                  *****  IR_Classifier class implementation  *****
+
+#include "irclassifier.h"
+#include <algorithm>
+
+void IR_Classifier::signature(const IR_Encoder &enc, Signature &sig)
+{
+    IRPulses frame;
+    enc.encode(0, 0, false, frame);
+    sig.mark = frame.size() > 0 ? frame[0] : 0;
+    sig.space = frame.size() > 1 ? frame[1] : 0;
+    sig.pulses = 0;
+    while (sig.pulses < frame.size() && (sig.pulses % 2 == 0 || frame[sig.pulses] < IR_CLASSIFY_GAP))
+    {
+        ++sig.pulses;
+    }
+}
+
+int IR_Classifier::frameLength(const uint32_t *times, uint32_t n_times)
+{
+    int ret = 0;
+    while (ret < n_times && (ret % 2 == 0 || times[ret] < IR_CLASSIFY_GAP))
+    {
+        ++ret;
+    }
+    return ret;
+}
+
+int IR_Classifier::confidence(const Signature &sig, const uint32_t *times, uint32_t n_times)
+{
+    int ret = 0;
+    if (n_times >= 2 && sig.mark > 0 && sig.space > 0)
+    {
+        int mark_err = (times[0] > sig.mark ? times[0] - sig.mark : sig.mark - times[0]) * 100 / sig.mark;
+        int space_err = (times[1] > sig.space ? times[1] - sig.space : sig.space - times[1]) * 100 / sig.space;
+        if (mark_err <= 25 && space_err <= 25)
+        {
+            ret = 100 - mark_err - space_err;
+            if (frameLength(times, n_times) != sig.pulses)
+            {
+                ret /= 2;
+            }
+        }
+    }
+    return ret;
+}
+
+int IR_Classifier::classify(const uint32_t *times, uint32_t n_times, const std::vector<Signature> &sigs,
+                            std::vector<Match> &matches)
+{
+    matches.clear();
+    for (int ii = 0; ii < sigs.size(); ii++)
+    {
+        int conf = confidence(sigs[ii], times, n_times);
+        if (conf > 0)
+        {
+            matches.push_back({ii, conf});
+        }
+    }
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const Match &a, const Match &b) { return a.confidence > b.confidence; });
+    return matches.size();
+}
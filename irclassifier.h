@@ -0,0 +1,94 @@
+//                  *****  IR_Classifier class  *****
+
+#ifndef IR_CLASSIFIER_H
+#define IR_CLASSIFIER_H
+
+#include "irencoder.h"
+#include <vector>
+#include <stdint.h>
+
+#ifndef IR_CLASSIFY_GAP
+#define IR_CLASSIFY_GAP         6000        // Shortest space between frames (usec)
+#endif
+#ifndef IR_CLASSIFY_CONFIDENT
+#define IR_CLASSIFY_CONFIDENT   70          // Confidence to use one decoder only
+#endif
+#ifndef IR_CLASSIFY_MARGIN
+#define IR_CLASSIFY_MARGIN      20          // Lead over the next protocol to use one decoder only
+#endif
+
+/**
+ * @brief   Protocol classifier for IR captures
+ * 
+ * @details Matches the leader mark and space and the length of the first
+ *          frame of a capture against each protocol's signature, so a
+ *          capture can go straight to its decoder. The signatures come from
+ *          the protocol encoders, so a new protocol needs no table entry.
+ */
+class IR_Classifier
+{
+public:
+    struct Signature
+    {
+        uint32_t        mark;               // Leader mark (usec)
+        uint32_t        space;              // Leader space (usec)
+        int             pulses;             // Marks and spaces in one frame
+    };
+
+    struct Match
+    {
+        int             proto;              // Protocol number
+        int             confidence;         // 0 (no match) to 100
+    };
+
+    /**
+     * @brief   Get a protocol signature from an encoded frame
+     * 
+     * @param   enc     Protocol encoder
+     * @param   sig     Receives the signature
+     */
+    static void signature(const IR_Encoder &enc, Signature &sig);
+
+    /**
+     * @brief   Get the length of the first frame of a capture
+     * 
+     * @return  Marks and spaces before the first space of IR_CLASSIFY_GAP or more
+     */
+    static int frameLength(const uint32_t *times, uint32_t n_times);
+
+    /**
+     * @brief   Rate how well a capture matches a signature
+     * 
+     * @details Zero unless the leader mark and space are within the decoder
+     *          tolerance (25%), then 100 less the leader errors (%), halved
+     *          if the frame length differs
+     * 
+     * @return  Confidence (0 to 100)
+     */
+    static int confidence(const Signature &sig, const uint32_t *times, uint32_t n_times);
+
+    /**
+     * @brief   Rank the protocols for a capture
+     * 
+     * @param   times   Capture (mark first)
+     * @param   n_times Number of marks and spaces
+     * @param   sigs    Signature by protocol number
+     * @param   matches Receives the protocols with a non-zero confidence,
+     *                  most confident first
+     * 
+     * @return  Number of matches
+     */
+    static int classify(const uint32_t *times, uint32_t n_times, const std::vector<Signature> &sigs,
+                        std::vector<Match> &matches);
+
+    /**
+     * @brief   Check if a ranking singles out one protocol
+     * 
+     * @return  true if the best match is confident and clear of the next
+     */
+    static bool decisive(const std::vector<Match> &matches)
+        { return !matches.empty() && matches[0].confidence >= IR_CLASSIFY_CONFIDENT &&
+                 (matches.size() == 1 || matches[0].confidence - matches[1].confidence >= IR_CLASSIFY_MARGIN); }
+};
+
+#endif
@@ -2,64 +2,99 @@
 
 #include "irdevice.h"
 
-#include "nec_transmitter.h"
 #include "nec_receiver.h"
-#include "samsung_transmitter.h"
 #include "samsung_receiver.h"
-#include "sony_transmitter.h"
 #include "sony_receiver.h"
 #include "raw_receiver.h"
+#include "irrawcode.h"
 #include "logger.h"
+#include <iterator>
 #include <stdio.h>
 
-#define IR_DEVICE_SAMPLES   256             // Maximum samples to read
-#define IR_DEVICE_TIMEOUT   10000           // Read timeout (msec)
 #define IR_DEVICE_BITTMO    500             // Bit timeout
 
+const NEC_Encoder IR_Device::nec_;
+const SAMSUNG_Encoder IR_Device::sam_;
+const Sony_Encoder IR_Device::sony12_(5);
+const Sony_Encoder IR_Device::sony15_(8);
+
 std::map<std::string, struct IR_Device::IRMap> IR_Device::irs_ =
             {
-                {"NEC", {.tx=IR_Device::new_NEC_tx, .decode=NEC_Receiver::decode}},
-                {"Sam", {.tx=IR_Device::new_SAM_tx, .decode=SAMSUNG_Receiver::decode}},
-                {"Sony12", {.tx=IR_Device::new_Sony12_tx, .decode=Sony12_Receiver::decode}},
-                {"Sony15", {.tx=IR_Device::new_Sony15_tx, .decode=Sony15_Receiver::decode}},
+                {"NEC", {.encoder=&IR_Device::nec_, .decode=NEC_Receiver::decode}},
+                {"Sam", {.encoder=&IR_Device::sam_, .decode=SAMSUNG_Receiver::decode}},
+                {"Sony12", {.encoder=&IR_Device::sony12_, .decode=Sony12_Receiver::decode}},
+                {"Sony15", {.encoder=&IR_Device::sony15_, .decode=Sony15_Receiver::decode}},
             };
 
-IR_LED *IR_Device::new_NEC_tx(int gpio) { return new NEC_Transmitter(gpio); }
-IR_LED *IR_Device::new_SAM_tx(int gpio) { return new SAMSUNG_Transmitter(gpio); }
-IR_LED *IR_Device::new_Sony12_tx(int gpio) { return new Sony12_Transmitter(gpio); }
-IR_LED *IR_Device::new_Sony15_tx(int gpio) { return new Sony15_Transmitter(gpio); }
+uint32_t IR_Device::captures_[IR_LEARN_CAPTURES][IR_DEVICE_SAMPLES];
+uint32_t IR_Device::average_[IR_DEVICE_SAMPLES];
 
 IR_Device::IR_Device(int tx_gpio, int rx_gpio, async_context_t *asy_ctx)
-     : tx_gpio_(tx_gpio), rx_gpio_(rx_gpio), tx_ir_led_(nullptr), rx_ir_led_(nullptr),
-       asy_ctx_(asy_ctx), raw_(nullptr), times_(nullptr), n_times_(0), log_(nullptr), cb_(nullptr), user_data_(nullptr)
+     : tx_gpio_(tx_gpio), rx_gpio_(rx_gpio), tx_(nullptr), rx_ir_led_(nullptr),
+       asy_ctx_(asy_ctx), raw_(nullptr), n_captures_(0), timed_out_(false), log_(nullptr),
+       sniff_rx_(nullptr), sniffer_(nullptr), sniffing_(false), sniff_cb_(nullptr), sniff_data_(nullptr),
+       sniff_publish_(false), cb_(nullptr), user_data_(nullptr)
 {
     read_complete_ = {.do_work = read_done, .user_data = this};
+    sniff_worker_ = {.do_work = sniff_work, .user_data = this};
     async_context_add_when_pending_worker(asy_ctx, &read_complete_);
+    tx_ = new IR_PioTx(tx_gpio_, asy_ctx_);
+    signatures();
 }
 
-bool IR_Device::get_transmitter(const std::string &proto, IR_LED * &ir_led)
+const std::vector<IR_Classifier::Signature> &IR_Device::signatures()
 {
-    bool ret = true;
-    if (!ir_led || ir_led->protocol() != proto)
+    static std::vector<IR_Classifier::Signature> sigs;
+    if (sigs.empty())
     {
-        ret = false;
-        auto it = irs_.find(proto);
-        if (it != irs_.end())
+        for (auto it = irs_.cbegin(); it != irs_.cend(); ++it)
         {
-            if (ir_led)
+            IR_Classifier::Signature sig = {0, 0, 0};
+            if (it->second.encoder)
             {
-                delete ir_led;
-                ir_led = nullptr;
+                IR_Classifier::signature(*it->second.encoder, sig);
             }
-            ir_led = it->second.tx(tx_gpio_);
+            sigs.push_back(sig);
+        }
+    }
+    return sigs;
+}
 
-            if (ir_led)
-            {
-                ret = true;
-            }
+int IR_Device::protocolId(const char *proto)
+{
+    int ret = -1;
+    int id = 0;
+    for (auto it = irs_.cbegin(); ret < 0 && it != irs_.cend(); ++it, ++id)
+    {
+        if (it->first == proto)
+        {
+            ret = id;
         }
     }
+    return ret;
+}
+
+const IR_Encoder *IR_Device::encoder(int proto)
+{
+    const IR_Encoder *ret = nullptr;
+    if (proto >= 0 && proto < irs_.size())
+    {
+        auto it = irs_.cbegin();
+        std::advance(it, proto);
+        ret = it->second.encoder;
+    }
+    return ret;
+}
 
+const char *IR_Device::protocolName(int proto)
+{
+    const char *ret = "";
+    if (proto >= 0 && proto < irs_.size())
+    {
+        auto it = irs_.cbegin();
+        std::advance(it, proto);
+        ret = it->first.c_str();
+    }
     return ret;
 }
 
@@ -73,19 +108,27 @@ int IR_Device::protocols(std::vector<std::string> &protolist)
     return protolist.size();
 }
 
-void IR_Device::identify(void (*cb)(const std::string &type, uint16_t address, uint16_t value, void *data), void *data)
+void IR_Device::identify(void (*cb)(const std::string &type, uint16_t address, uint16_t value, int confidence, void *data), void *data)
 {
     cb_ = cb;
     user_data_ = data;
-    times_ = new uint32_t[IR_DEVICE_SAMPLES];
-    n_times_ = 0;
+    n_captures_ = 0;
+    learn_end_ = make_timeout_time_ms(IR_DEVICE_TIMEOUT);
+    pause_sniff(true);
+    listen(IR_DEVICE_TIMEOUT);
+}
+
+void IR_Device::listen(uint32_t timeout)
+{
+    counts_[n_captures_] = 0;
+    timed_out_ = false;
     if (raw_ == nullptr)
     {
         raw_ = new RAW_Receiver(rx_gpio_, IR_DEVICE_SAMPLES);
     }
-    raw_->set_times(times_, IR_DEVICE_SAMPLES, &n_times_);
+    raw_->set_times(captures_[n_captures_], IR_DEVICE_SAMPLES, &counts_[n_captures_]);
     raw_->set_user_data(this);
-    raw_->set_message_timeout(IR_DEVICE_TIMEOUT);
+    raw_->set_message_timeout(timeout);
     raw_->set_bit_timeout(IR_DEVICE_BITTMO);
     raw_->set_rcv_callback(ir_rcv);
     raw_->set_tmo_callback(ir_tmo);
@@ -102,6 +145,8 @@ bool IR_Device::ir_tmo(bool msg, uint32_t n_pulse, uint32_t const *pulses, IR_Re
 {
     IR_Device *self = static_cast<IR_Device *>(obj->user_data());
     if (self->log_) self->log_->print("identify: %s timeout. Read %d pulses\n", msg ? "message" : "pulse", n_pulse);
+    //  A pulse timeout ends a capture
+    self->timed_out_ = msg || n_pulse == 0;
     async_context_set_work_pending(self->asy_ctx_, &self->read_complete_);
     return false;
 }
@@ -114,43 +159,288 @@ void IR_Device::read_done(async_context_t *ctx, async_when_pending_worker_t *wor
 
 void IR_Device::read_done()
 {
+    uint32_t *times = captures_[n_captures_];
+    uint32_t &n_times = counts_[n_captures_];
     if (log_)
     {
-        log_->print_debug(1, "Read %d times:", n_times_);
-        for (uint32_t ii = 0; ii < n_times_; ii++)
+        log_->print_debug(1, "Read %d times:", n_times);
+        for (uint32_t ii = 0; ii < n_times; ii++)
         {
             if ((ii % 10) == 0) log_->print_debug(1, "\n");
-            log_->print_debug(1, " %d", times_[ii]);
+            log_->print_debug(1, " %d", times[ii]);
         }
         log_->print_debug(1, "\n");
     }
-    if (raw_)
+
+    //  Keep a capture that is more than noise, and stop when two agree
+    bool more = false;
+    if (!timed_out_)
     {
-        delete raw_;
-        raw_ = nullptr;
+        n_times = IR_Learner::deglitch(times, n_times);
+        if (n_times >= IR_LEARN_MIN_TIMES)
+        {
+            ++n_captures_;
+        }
+        else if (log_)
+        {
+            log_->print("identify: noise ignored (%d times)\n", n_times);
+        }
+
+        std::string type;
+        std::string last_type;
+        uint16_t address = 0;
+        uint16_t value = 0;
+        uint16_t last_address = 0;
+        uint16_t last_value = 0;
+        int confidence = 0;
+        bool agreed = n_captures_ >= 2 &&
+                      match(captures_[n_captures_ - 2], counts_[n_captures_ - 2], type, address, value, confidence) &&
+                      match(captures_[n_captures_ - 1], counts_[n_captures_ - 1], last_type, last_address, last_value, confidence) &&
+                      type == last_type && address == last_address && value == last_value;
+        more = n_captures_ < IR_LEARN_CAPTURES && !agreed &&
+               (n_captures_ > 0 || absolute_time_diff_us(get_absolute_time(), learn_end_) > 0);
     }
 
-    std::string type;
-    uint16_t address = 0;
-    uint16_t value = 0;
-    for (auto it = irs_.cbegin(); it != irs_.cend(); ++it)
+    if (more)
+    {
+        listen(n_captures_ > 0 ? IR_LEARN_NEXT_MS : absolute_time_diff_us(get_absolute_time(), learn_end_) / 1000);
+    }
+    else
+    {
+        if (raw_)
+        {
+            delete raw_;
+            raw_ = nullptr;
+        }
+
+        const uint32_t *captures[IR_LEARN_CAPTURES];
+        for (int cc = 0; cc < n_captures_; cc++)
+        {
+            captures[cc] = captures_[cc];
+        }
+        std::string type;
+        uint16_t address = 0;
+        uint16_t value = 0;
+        int confidence = learn(captures, counts_, n_captures_, type, address, value);
+
+        if (log_) log_->print("identify: result: '%s' %d %d confidence %d from %d captures\n",
+                              type.c_str(), address, value, confidence, n_captures_);
+
+        if (cb_)
+        {
+            cb_(type, address, value, confidence, user_data_);
+        }
+        cb_ = nullptr;
+        user_data_ = nullptr;
+        pause_sniff(false);
+    }
+}
+
+void IR_Device::sniff(bool on)
+{
+    if (on && !sniffer_)
+    {
+        sniffer_ = new IR_Sniffer();
+        sniff_rx_ = new IR_GpioRx(rx_gpio_);
+    }
+    if (on != sniffing_)
+    {
+        sniffing_ = on;
+        pause_sniff(raw_ != nullptr);
+        sniff_publish_ = sniffer_ != nullptr;
+        publish_sniff();
+    }
+}
+
+void IR_Device::pause_sniff(bool pause)
+{
+    if (sniff_rx_)
+    {
+        bool run = sniffing_ && !pause;
+        if (run && !sniff_rx_->enabled())
+        {
+            //  Edges left from before the pause are stale
+            IR_GpioRx::Edge edge;
+            while (sniff_rx_->pop(edge));
+            sniffer_->reset();
+            sniff_rx_->enable(true);
+            async_context_add_at_time_worker_in_ms(asy_ctx_, &sniff_worker_, IR_SNIFF_POLL_MS);
+        }
+        else if (!run && sniff_rx_->enabled())
+        {
+            sniff_rx_->enable(false);
+            async_context_remove_at_time_worker(asy_ctx_, &sniff_worker_);
+        }
+    }
+}
+
+void IR_Device::sniff_work(async_context_t *ctx, async_at_time_worker_t *worker)
+{
+    IR_Device *self = static_cast<IR_Device *>(worker->user_data);
+    self->sniff_work();
+}
+
+void IR_Device::sniff_work()
+{
+    bool changed = false;
+    IR_GpioRx::Edge edge;
+    while (sniff_rx_->pop(edge))
+    {
+        changed = sniffer_->edge(edge.at, edge.mark) || changed;
+    }
+    changed = sniffer_->poll(to_us_since_boot(get_absolute_time())) || changed;
+    sniff_publish_ = sniff_publish_ || changed;
+    publish_sniff();
+    if (sniff_rx_->enabled())
+    {
+        async_context_add_at_time_worker_in_ms(asy_ctx_, &sniff_worker_, IR_SNIFF_POLL_MS);
+    }
+}
+
+void IR_Device::publish_sniff()
+{
+    if (sniff_publish_ && sniff_out_.level() < sniff_out_.capacity())
+    {
+        SniffLog *log = new SniffLog();
+        log->started = true;
+        log->sniffing = sniffing_;
+        sniffer_->frames(log->frames);
+        sniffer_->getStats(log->stats);
+        sniff_rx_->getStats(log->rx);
+        sniff_out_.push(log);
+        sniff_publish_ = false;
+        if (sniff_cb_)
+        {
+            sniff_cb_(sniff_data_);
+        }
+    }
+}
+
+bool IR_Device::takeSniffLog(SniffLog &log)
+{
+    bool ret = false;
+    SniffLog *copy;
+    while (sniff_out_.pop(copy))
+    {
+        std::swap(log, *copy);
+        delete copy;
+        ret = true;
+    }
+    return ret;
+}
+
+int IR_Device::learn(const uint32_t *const *captures, const uint32_t *counts, int n_captures,
+                     std::string &type, uint16_t &address, uint16_t &value)
+{
+    struct Code
+    {
+        bool            ok;                 // Decoded
+        std::string     type;               // Protocol
+        uint16_t        address;            // Address
+        uint16_t        value;              // Value
+        int             confidence;         // Classifier confidence
+    };
+    std::vector<Code> codes(n_captures);
+    int ret = 0;
+    int best = -1;
+    int best_votes = 0;
+    type.clear();
+    address = 0;
+    value = 0;
+
+    //  Vote on the codes the captures decode to
+    for (int cc = 0; cc < n_captures; cc++)
+    {
+        Code &code = codes[cc];
+        code.ok = match(captures[cc], counts[cc], code.type, code.address, code.value, code.confidence);
+    }
+    for (int cc = 0; cc < n_captures; cc++)
     {
-        if (it->second.decode)
+        int votes = 0;
+        for (int dd = 0; codes[cc].ok && dd < n_captures; dd++)
         {
-            if (it->second.decode(times_, n_times_, address, value, 0xffff))
+            if (codes[dd].ok && codes[dd].type == codes[cc].type &&
+                codes[dd].address == codes[cc].address && codes[dd].value == codes[cc].value)
             {
-                type = it->first;
-                break;
+                ++votes;
             }
         }
+        if (votes > best_votes || (votes > 0 && votes == best_votes && codes[cc].confidence > codes[best].confidence))
+        {
+            best = cc;
+            best_votes = votes;
+        }
     }
 
-    if (log_) log_->print("identify: result: '%s' %d %d\n", type.c_str(), address, value);
+    if (best >= 0)
+    {
+        type = codes[best].type;
+        address = codes[best].address;
+        value = codes[best].value;
+        ret = codes[best].confidence * best_votes / n_captures;
+    }
+    else
+    {
+        //  None decodes: average the first frames, without the outliers
+        int used = 0;
+        uint32_t n_times = IR_Learner::average(captures, counts, n_captures, average_, used);
+        if (n_times > 0 && match(average_, n_times, type, address, value, ret))
+        {
+            ret = ret * used / n_captures;
+        }
+        else if (n_times > 0 && IR_RawCode::encode(average_, n_times, type))
+        {
+            address = 0;
+            value = 0;
+            ret = 0;
+        }
+    }
+    return ret;
+}
+
+bool IR_Device::match(const uint32_t *times, uint32_t n_times, std::string &type, uint16_t &address, uint16_t &value,
+                      int &confidence)
+{
+    const std::vector<IR_Classifier::Signature> &sigs = signatures();
+    std::vector<IR_Classifier::Match> matches;
+    type.clear();
+    confidence = 0;
+    IR_Classifier::classify(times, n_times, sigs, matches);
+    if (IR_Classifier::decisive(matches) && decode(matches[0].proto, times, n_times, address, value))
+    {
+        type = protocolName(matches[0].proto);
+        confidence = matches[0].confidence;
+    }
+    else
+    {
+        //  Ambiguous: the matching protocols best first, then the rest
+        for (auto it = matches.cbegin(); it != matches.cend() && type.empty(); ++it)
+        {
+            if (decode(it->proto, times, n_times, address, value))
+            {
+                type = protocolName(it->proto);
+                confidence = it->confidence;
+            }
+        }
+        for (int proto = 0; proto < irs_.size() && type.empty(); proto++)
+        {
+            if (IR_Classifier::confidence(sigs[proto], times, n_times) == 0 && decode(proto, times, n_times, address, value))
+            {
+                type = protocolName(proto);
+            }
+        }
+    }
+    return !type.empty();
+}
 
-    if (cb_)
+bool IR_Device::decode(int proto, const uint32_t *times, uint32_t n_times, uint16_t &address, uint16_t &value)
+{
+    bool ret = false;
+    if (proto >= 0 && proto < irs_.size())
     {
-        cb_(type, address, value, user_data_);
+        auto it = irs_.cbegin();
+        std::advance(it, proto);
+        ret = it->second.decode && it->second.decode(times, n_times, address, value, 0xffff);
     }
-    cb_ = nullptr;
-    user_data_ = nullptr;
-}
\ No newline at end of file
+    return ret;
+}
@@ -5,62 +5,199 @@
 
 #include "ir_led.h"
 #include "ir_receiver.h"
+#include "irencoder.h"
+#include "irclassifier.h"
+#include "irlearner.h"
+#include "irpiotx.h"
+#include "irgpiorx.h"
+#include "irsniffer.h"
+#include "spscring.h"
 #include <map>
 #include <string>
 #include <vector>
 #include <pico/async_context.h>
+#include <pico/time.h>
+
+#ifndef IR_DEVICE_SAMPLES
+#define IR_DEVICE_SAMPLES   256             // Maximum samples to read
+#endif
+#ifndef IR_DEVICE_TIMEOUT
+#define IR_DEVICE_TIMEOUT   10000           // Read timeout (msec)
+#endif
+#ifndef IR_SNIFF_COPIES
+#define IR_SNIFF_COPIES     4               // Frame log copies waiting for the web core
+#endif
 
 class RAW_Receiver;
 class Logger;
 
 class IR_Device
 {
+public:
+    struct SniffLog
+    {
+        bool                            started;    // Sniffing has been started
+        bool                            sniffing;   // Sniffing wanted
+        std::vector<IR_Sniffer::Frame>  frames;     // Frames, oldest first
+        IR_Sniffer::Stats               stats;      // Sniffer counters
+        IR_GpioRx::Stats                rx;         // Receiver counters
+
+        SniffLog() : started(false), sniffing(false), stats(), rx() {}
+    };
+
 private:
     int             tx_gpio_;                   // GPIO for transmit
     int             rx_gpio_;                   // GPIO for receive
-    IR_LED          *tx_ir_led_;                // Transmit device
+    IR_PioTx        *tx_;                       // Transmitter
     IR_LED          *rx_ir_led_;                // Receive device
     async_context_t *asy_ctx_;                  // Async context
     async_when_pending_worker_t read_complete_; // IR output complete worker
     RAW_Receiver    *raw_;                      // Raw IR data rreceiver
-    uint32_t        *times_;                    // Read times
-    uint32_t        n_times_;                   // Number of read times
+    uint32_t        counts_[IR_LEARN_CAPTURES]; // Number of times in each capture
+    int             n_captures_;                // Captures kept in this learn
+    bool            timed_out_;                 // Read ended with no message
+    absolute_time_t learn_end_;                 // Time to give up waiting for a first press
     Logger          *log_;                      // Logger
 
+    IR_GpioRx       *sniff_rx_;                 // Edge receiver (null until sniffing first starts)
+    IR_Sniffer      *sniffer_;                  // Edge decoder and frame log
+    bool            sniffing_;                  // Sniffing wanted (paused while learning)
+    async_at_time_worker_t sniff_worker_;       // Edge ring reader
+    void            (*sniff_cb_)(void *data);   // Frame log changed callback
+    void            *sniff_data_;               // User data for sniff_cb_
+    SPSCRing<SniffLog *, IR_SNIFF_COPIES> sniff_out_;   // Frame log copies for the web core
+    bool            sniff_publish_;             // Frame log changed since the last copy
+
+    static uint32_t captures_[IR_LEARN_CAPTURES][IR_DEVICE_SAMPLES];    // Capture buffers
+    static uint32_t average_[IR_DEVICE_SAMPLES];                        // Averaged capture
+
     //  *****  Protocol mapping  *****
     struct IRMap
     {
-        IR_LED *(*tx)(int gpio);
+        const IR_Encoder *encoder;
         IR_Receiver *(*rx)(int gpio);
         bool (*decode)(uint32_t const *pulses, uint32_t n_pulse, uint16_t &addr, uint16_t &func, uint16_t address);
     };
 
     static std::map<std::string, struct IRMap> irs_;
-    static IR_LED *new_NEC_tx(int gpio);
-    static IR_LED *new_SAM_tx(int gpio);
-    static IR_LED *new_Sony12_tx(int gpio);
-    static IR_LED *new_Sony15_tx(int gpio);
+    static const NEC_Encoder nec_;
+    static const SAMSUNG_Encoder sam_;
+    static const Sony_Encoder sony12_;
+    static const Sony_Encoder sony15_;
 
     static void ir_rcv(uint64_t timestamp, uint16_t address, uint16_t value, IR_Receiver *obj);
     static bool ir_tmo(bool msg, uint32_t n_pulse, uint32_t const *pulses, IR_Receiver *obj);
     static void read_done(async_context_t *ctx, async_when_pending_worker_t *worker);
     void read_done();
-    void (*cb_)(const std::string &type, uint16_t address, uint16_t value, void *data);
+    void listen(uint32_t timeout);
+    static void sniff_work(async_context_t *ctx, async_at_time_worker_t *worker);
+    void sniff_work();
+    void pause_sniff(bool pause);
+    void publish_sniff();
+    static const std::vector<IR_Classifier::Signature> &signatures();
+    static bool decode(int proto, const uint32_t *times, uint32_t n_times, uint16_t &address, uint16_t &value);
+    static bool match(const uint32_t *times, uint32_t n_times, std::string &type, uint16_t &address, uint16_t &value,
+                      int &confidence);
+    void (*cb_)(const std::string &type, uint16_t address, uint16_t value, int confidence, void *data);
     void *user_data_;
 
 public:
     IR_Device(int tx_gpio, int rx_gpio, async_context_t *asy_ctx);
-    ~IR_Device() { release_tx(); release_rx(); }
+    ~IR_Device() { SniffLog log; sniff(false); takeSniffLog(log); release_tx(); release_rx(); delete sniff_rx_; delete sniffer_; }
 
-    bool get_transmitter(const std::string &proto, IR_LED * &ir_led);
+    IR_PioTx *transmitter() const { return tx_; }
+
+    /**
+     * @brief   Get the encoder for a protocol
+     * 
+     * @param   proto   Protocol number (see protocolId)
+     * 
+     * @return  Encoder or null if proto is not a protocol number
+     */
+    static const IR_Encoder *encoder(int proto);
 
     static bool validProtocol(const std::string &proto) { return irs_.find(proto) != irs_.cend(); }
     static int protocols(std::vector<std::string> &protolist);
 
-    void release_tx() { if (tx_ir_led_) delete tx_ir_led_; tx_ir_led_ = nullptr; }
+    /**
+     * @brief   Get the number of a protocol
+     * 
+     * @param   proto   Protocol name
+     * 
+     * @return  Protocol number (0 to protocol count - 1) or -1 if not a protocol
+     */
+    static int protocolId(const char *proto);
+    static const char *protocolName(int proto);
+
+    void release_tx() { if (tx_) delete tx_; tx_ = nullptr; }
     void release_rx() { if (rx_ir_led_) delete rx_ir_led_; rx_ir_led_ = nullptr; }
 
-    void identify(void (*cb)(const std::string &type, uint16_t address, uint16_t value, void *data), void *data);
+    /**
+     * @brief   Learn an IR message
+     * 
+     * @details Reads up to IR_LEARN_CAPTURES presses of the button, each
+     *          within IR_LEARN_NEXT_MS of the one before, and stops early
+     *          when two agree. Captures are kept in static buffers, reused
+     *          by each learn. See learn for how the result is chosen.
+     *          Only one learn runs at a time: check learning first.
+     * 
+     * @param   cb      Called with the protocol or raw code (empty if not
+     *                  identified), address, value and confidence (0 to 100)
+     * @param   data    User data for the callback
+     */
+    void identify(void (*cb)(const std::string &type, uint16_t address, uint16_t value, int confidence, void *data), void *data);
+    bool learning() const { return cb_ != nullptr; }
+
+    /**
+     * @brief   Get the consensus code of several captures of one button
+     * 
+     * @details Each capture goes to the decoder of the protocol its leader
+     *          and frame length single out, else each decoder is tried, best
+     *          matches first. The code most captures decode to wins. If none
+     *          decodes, the first frames are averaged (see IR_Learner) and
+     *          the average decoded, or given as a raw code (see IR_RawCode).
+     * 
+     * @param   captures    Captures (mark first, glitches removed)
+     * @param   counts      Number of marks and spaces of each capture
+     * @param   n_captures  Number of captures
+     * @param   type        Receives the protocol or raw code (empty if none)
+     * @param   address     Receives the address
+     * @param   value       Receives the value
+     * 
+     * @return  Classifier confidence scaled by the share of the captures
+     *          that agree (0 to 100, 0 for a raw code)
+     */
+    static int learn(const uint32_t *const *captures, const uint32_t *counts, int n_captures,
+                     std::string &type, uint16_t &address, uint16_t &value);
+
+    /**
+     * @brief   Start or stop sniffing
+     * 
+     * @details While sniffing, every frame the receiver sees is decoded and
+     *          logged (see IR_Sniffer), without waiting for a learn.
+     *          Sniffing pauses while a learn has the receiver.
+     * 
+     * @param   on      true to sniff
+     */
+    void sniff(bool on);
+    bool sniffing() const { return sniffing_; }
+
+    /**
+     * @brief   Get the latest copy of the frame log
+     * 
+     * @details The log belongs to the IR core, which pushes a copy of it
+     *          and the counters after each change and then calls the sniff
+     *          callback. Call on the web core; no lock is taken. A copy not
+     *          pushed because the web core is behind is pushed at the next
+     *          poll.
+     * 
+     * @param   log     Replaced by the newest copy, if any
+     * 
+     * @return  true if log was replaced
+     */
+    bool takeSniffLog(SniffLog &log);
+
+    void setSniffCallback(void (*cb)(void *data), void *data) { sniff_cb_ = cb; sniff_data_ = data; }
 
     void setLogger(Logger *logger) { log_ = logger; }
 };
@@ -0,0 +1,98 @@
+//                  *****  IR_Encoder classes implementation  *****
+
+#include "irencoder.h"
+
+bool IR_Encoder::encode(uint16_t address, uint16_t value, bool repeat, IRPulses &pulses) const
+{
+    bool ret = pulses.setCarrier(carrier_);
+    if (ret)
+    {
+        if (repeat)
+        {
+            repeatFrame(address, value, pulses);
+        }
+        else
+        {
+            for (int ii = 0; ii <= minimum_repeats_; ii++)
+            {
+                message(address, value, pulses);
+            }
+        }
+    }
+    return ret;
+}
+
+void IR_Encoder::bits(uint32_t bits, int nbits, uint32_t mark, uint32_t zero, uint32_t one, IRPulses &pulses)
+{
+    for (int ii = 0; ii < nbits; ii++)
+    {
+        pulses.mark(mark);
+        pulses.space((bits >> ii) & 1 ? one : zero);
+    }
+}
+
+void IR_Encoder::pad(uint64_t start, IRPulses &pulses) const
+{
+    uint64_t frame = repeat_interval_ * 1000;
+    uint64_t used = pulses.duration() - start;
+    if (used < frame)
+    {
+        pulses.space(frame - used);
+    }
+}
+
+
+//  *****  NEC  *****
+
+void NEC_Encoder::message(uint16_t address, uint16_t value, IRPulses &pulses) const
+{
+    //  Addresses above 0xff are the 16 bit extended form
+    uint32_t addr = address > 0xff ? address : (address & 0xff) | ((~address & 0xff) << 8);
+    uint64_t start = pulses.duration();
+    pulses.mark(9000);
+    pulses.space(4500);
+    bits(addr | ((value & 0xff) << 16) | ((~value & 0xff) << 24), 32, 562, 562, 1687, pulses);
+    pulses.mark(562);
+    pad(start, pulses);
+}
+
+void NEC_Encoder::repeatFrame(uint16_t address, uint16_t value, IRPulses &pulses) const
+{
+    uint64_t start = pulses.duration();
+    pulses.mark(9000);
+    pulses.space(2250);
+    pulses.mark(562);
+    pad(start, pulses);
+}
+
+
+//  *****  Samsung  *****
+
+void SAMSUNG_Encoder::message(uint16_t address, uint16_t value, IRPulses &pulses) const
+{
+    uint64_t start = pulses.duration();
+    pulses.mark(4500);
+    pulses.space(4500);
+    bits((address & 0xff) | ((address & 0xff) << 8) | ((value & 0xff) << 16) | ((~value & 0xff) << 24),
+         32, 560, 560, 1690, pulses);
+    pulses.mark(560);
+    pad(start, pulses);
+}
+
+
+//  *****  Sony  *****
+
+void Sony_Encoder::message(uint16_t address, uint16_t value, IRPulses &pulses) const
+{
+    //  Pulse width coded: the mark carries the bit
+    uint32_t data = (value & 0x7f) | ((address & ((1 << address_bits_) - 1)) << 7);
+    uint64_t start = pulses.duration();
+    pulses.mark(2400);
+    pulses.space(600);
+    for (int ii = 0; ii < 7 + address_bits_; ii++)
+    {
+        pulses.mark((data >> ii) & 1 ? 1200 : 600);
+        pulses.space(600);
+    }
+    pad(start, pulses);
+}
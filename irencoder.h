@@ -0,0 +1,104 @@
+//                  *****  IR_Encoder classes  *****
+
+#ifndef IR_ENCODER_H
+#define IR_ENCODER_H
+
+#include "irpulses.h"
+#include <stdint.h>
+
+/**
+ * @brief   IR protocol encoder
+ * 
+ * @details Appends the mark/space times of a protocol frame to a pulse
+ *          program. Frames are padded to the protocol repeat interval, so
+ *          the program time is the time the message occupies. Encoders
+ *          hold no state and do not touch the hardware.
+ */
+class IR_Encoder
+{
+private:
+    uint32_t        carrier_;                   // Carrier frequency (Hz)
+    int             repeat_interval_;           // Frame repeat interval (msec)
+    int             minimum_repeats_;           // Repeats sent with each message
+
+protected:
+    /**
+     * @brief   Append one message frame
+     */
+    virtual void message(uint16_t address, uint16_t value, IRPulses &pulses) const = 0;
+
+    /**
+     * @brief   Append one repeat frame
+     * 
+     * @details The default repeats the message frame
+     */
+    virtual void repeatFrame(uint16_t address, uint16_t value, IRPulses &pulses) const
+        { message(address, value, pulses); }
+
+    static void bits(uint32_t bits, int nbits, uint32_t mark, uint32_t zero, uint32_t one, IRPulses &pulses);
+    void pad(uint64_t start, IRPulses &pulses) const;
+
+public:
+    IR_Encoder(uint32_t carrier, int repeat_interval, int minimum_repeats = 0)
+     : carrier_(carrier), repeat_interval_(repeat_interval), minimum_repeats_(minimum_repeats) {}
+    virtual ~IR_Encoder() {}
+
+    uint32_t carrier() const { return carrier_; }
+    int repeatInterval() const { return repeat_interval_; }
+    int minimumRepeats() const { return minimum_repeats_; }
+
+    /**
+     * @brief   Append a message to a pulse program
+     * 
+     * @param   address Address
+     * @param   value   Value
+     * @param   repeat  Send the repeat frame, else the message and its
+     *                  minimum repeats
+     * @param   pulses  Program to append to
+     * 
+     * @return  false if the program has a different carrier
+     */
+    bool encode(uint16_t address, uint16_t value, bool repeat, IRPulses &pulses) const;
+
+    /**
+     * @brief   Get the time of a message
+     * 
+     * @param   repeat  Repeat frame, else the message and its minimum repeats
+     * 
+     * @return  Time (msec)
+     */
+    int messageTime(bool repeat) const { return repeat_interval_ * (repeat ? 1 : 1 + minimum_repeats_); }
+};
+
+class NEC_Encoder : public IR_Encoder
+{
+protected:
+    void message(uint16_t address, uint16_t value, IRPulses &pulses) const override;
+    void repeatFrame(uint16_t address, uint16_t value, IRPulses &pulses) const override;
+
+public:
+    NEC_Encoder() : IR_Encoder(38000, 108) {}
+};
+
+class SAMSUNG_Encoder : public IR_Encoder
+{
+protected:
+    void message(uint16_t address, uint16_t value, IRPulses &pulses) const override;
+
+public:
+    SAMSUNG_Encoder() : IR_Encoder(38000, 108) {}
+};
+
+class Sony_Encoder : public IR_Encoder
+{
+private:
+    int             address_bits_;              // Address bits (5, 8 or 13)
+
+protected:
+    void message(uint16_t address, uint16_t value, IRPulses &pulses) const override;
+
+public:
+    Sony_Encoder(int address_bits) : IR_Encoder(40000, 45, 2), address_bits_(address_bits) {}
+};
+
+#endif
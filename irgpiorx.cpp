@@ -0,0 +1,54 @@
+//                  *****  IR_GpioRx class implementation  *****
+
+#include "irgpiorx.h"
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <hardware/timer.h>
+
+#define IR_GPIO_RX_EDGES    (GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE)
+
+IR_GpioRx *IR_GpioRx::instance_ = nullptr;
+
+IR_GpioRx::IR_GpioRx(int gpio) : gpio_(gpio), enabled_(false), edges_(0), overruns_(0)
+{
+    instance_ = this;
+}
+
+IR_GpioRx::~IR_GpioRx()
+{
+    enable(false);
+    instance_ = nullptr;
+}
+
+void IR_GpioRx::enable(bool on)
+{
+    if (on && !enabled_)
+    {
+        gpio_init(gpio_);
+        gpio_set_dir(gpio_, GPIO_IN);
+        gpio_pull_up(gpio_);
+        gpio_acknowledge_irq(gpio_, IR_GPIO_RX_EDGES);
+        gpio_add_raw_irq_handler(gpio_, gpio_irq);
+        gpio_set_irq_enabled(gpio_, IR_GPIO_RX_EDGES, true);
+        irq_set_enabled(IO_IRQ_BANK0, true);
+    }
+    else if (!on && enabled_)
+    {
+        gpio_set_irq_enabled(gpio_, IR_GPIO_RX_EDGES, false);
+        gpio_remove_raw_irq_handler(gpio_, gpio_irq);
+    }
+    enabled_ = on;
+}
+
+void IR_GpioRx::gpio_irq()
+{
+    IR_GpioRx *self = instance_;
+    uint32_t events = gpio_get_irq_event_mask(self->gpio_);
+    if (events & IR_GPIO_RX_EDGES)
+    {
+        gpio_acknowledge_irq(self->gpio_, events);
+        //  The receiver output is low while it sees the carrier. Read the
+        //  level, in case both edges were latched.
+        self->push(time_us_32(), !gpio_get(self->gpio_));
+    }
+}
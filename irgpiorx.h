@@ -0,0 +1,81 @@
+//                  *****  IR_GpioRx class  *****
+
+#ifndef IR_GPIORX_H
+#define IR_GPIORX_H
+
+#include "spscring.h"
+#include <stdint.h>
+
+#ifndef IR_GPIO_RX_RING
+#define IR_GPIO_RX_RING     512             // Edges held between reads (power of two)
+#endif
+
+/**
+ * @brief   IR receiver edge capture
+ * 
+ * @details A GPIO interrupt on both edges of the receiver output adds the
+ *          time of each edge to a lock-free ring, which the IR core empties
+ *          at its own pace. The interrupt does nothing else, so it can run
+ *          alongside transmits and web work. An edge is lost, and counted,
+ *          only if the ring is full.
+ * 
+ *          Construct and enable on the core that is to take the interrupt.
+ */
+class IR_GpioRx
+{
+public:
+    struct Edge
+    {
+        uint32_t        at;                 // Time (usec since boot, low 32 bits)
+        bool            mark;               // Carrier starts (receiver output falls)
+    };
+
+    struct Stats
+    {
+        uint32_t        edges;              // Edges seen
+        uint32_t        overruns;           // Edges lost with the ring full
+    };
+
+private:
+    int                 gpio_;              // Receiver GPIO
+    bool                enabled_;           // Interrupt enabled
+    SPSCRing<Edge, IR_GPIO_RX_RING> ring_;  // Edges not yet read
+    volatile uint32_t   edges_;             // Edges seen
+    volatile uint32_t   overruns_;          // Edges lost
+
+    static IR_GpioRx    *instance_;         // Receiver taking the interrupt
+
+    static void gpio_irq();
+
+public:
+    IR_GpioRx(int gpio);
+    ~IR_GpioRx();
+
+    static IR_GpioRx *get() { return instance_; }
+
+    /**
+     * @brief   Start or stop taking edges
+     * 
+     * @details Stop while another receiver (RAW_Receiver) has the GPIO.
+     *          Edges already in the ring are kept.
+     */
+    void enable(bool on);
+    bool enabled() const { return enabled_; }
+
+    /**
+     * @brief   Add an edge (the interrupt handler, or a simulation)
+     */
+    void push(uint32_t at, bool mark)
+        { ++edges_; if (!ring_.push({at, mark})) ++overruns_; }
+
+    /**
+     * @brief   Take the oldest edge (IR core)
+     * 
+     * @return  false if there is none
+     */
+    bool pop(Edge &edge) { return ring_.pop(edge); }
+
+    void getStats(Stats &stats) const { stats = {edges_, overruns_}; }
+};
+
+#endif
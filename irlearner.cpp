@@ -0,0 +1,103 @@
+//                  *****  IR_Learner class implementation  *****
+
+#include "irlearner.h"
+#include "irclassifier.h"
+#include <algorithm>
+#include <vector>
+
+uint32_t IR_Learner::deglitch(uint32_t *times, uint32_t n_times)
+{
+    uint32_t ret = 0;
+    for (uint32_t ii = 0; ii < n_times; ii++)
+    {
+        if (times[ii] >= IR_LEARN_GLITCH)
+        {
+            times[ret++] = times[ii];
+        }
+        else if (ret == 0)
+        {
+            //  At the start: drop it and the time after it
+            ++ii;
+        }
+        else if (ii + 1 < n_times)
+        {
+            //  Within: the times either side are one mark or space
+            times[ret - 1] += times[ii] + times[ii + 1];
+            ++ii;
+        }
+        else
+        {
+            //  At the end: drop it and the time before it
+            --ret;
+        }
+    }
+    return ret;
+}
+
+uint32_t IR_Learner::average(const uint32_t *const *captures, const uint32_t *counts, int n_captures,
+                             uint32_t *times, int &used)
+{
+    //  The most common first frame length, longest if tied
+    std::vector<int> lengths(n_captures);
+    int length = 0;
+    int votes = 0;
+    for (int cc = 0; cc < n_captures; cc++)
+    {
+        lengths[cc] = IR_Classifier::frameLength(captures[cc], counts[cc]);
+    }
+    for (int cc = 0; cc < n_captures; cc++)
+    {
+        int nn = std::count(lengths.cbegin(), lengths.cend(), lengths[cc]);
+        if (lengths[cc] > 0 && (nn > votes || (nn == votes && lengths[cc] > length)))
+        {
+            length = lengths[cc];
+            votes = nn;
+        }
+    }
+
+    //  Drop the captures with a time far from the median
+    std::vector<bool> keep(n_captures);
+    std::vector<uint32_t> column;
+    for (int cc = 0; cc < n_captures; cc++)
+    {
+        keep[cc] = length > 0 && lengths[cc] == length;
+    }
+    for (int ii = 0; ii < length; ii++)
+    {
+        column.clear();
+        for (int cc = 0; cc < n_captures; cc++)
+        {
+            if (lengths[cc] == length)
+            {
+                column.push_back(captures[cc][ii]);
+            }
+        }
+        std::sort(column.begin(), column.end());
+        uint32_t median = column[column.size() / 2];
+        uint32_t limit = std::max<uint32_t>(median * IR_LEARN_OUTLIER / 100, IR_LEARN_SLACK);
+        for (int cc = 0; cc < n_captures; cc++)
+        {
+            if (keep[cc])
+            {
+                uint32_t tt = captures[cc][ii];
+                keep[cc] = (tt > median ? tt - median : median - tt) <= limit;
+            }
+        }
+    }
+
+    //  Average the rest (if all were dropped there is no consensus)
+    used = std::count(keep.cbegin(), keep.cend(), true);
+    for (int ii = 0; used > 0 && ii < length; ii++)
+    {
+        uint64_t sum = 0;
+        for (int cc = 0; cc < n_captures; cc++)
+        {
+            if (keep[cc])
+            {
+                sum += captures[cc][ii];
+            }
+        }
+        times[ii] = (sum + used / 2) / used;
+    }
+    return used > 0 ? length : 0;
+}
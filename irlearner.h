@@ -0,0 +1,70 @@
+//                  *****  IR_Learner class  *****
+
+#ifndef IR_LEARNER_H
+#define IR_LEARNER_H
+
+#include <stdint.h>
+
+#ifndef IR_LEARN_CAPTURES
+#define IR_LEARN_CAPTURES       3           // Most presses read in one learn
+#endif
+#ifndef IR_LEARN_NEXT_MS
+#define IR_LEARN_NEXT_MS        1500        // Wait for another press (msec)
+#endif
+#ifndef IR_LEARN_GLITCH
+#define IR_LEARN_GLITCH         100         // Mark or space too short to be IR (usec)
+#endif
+#ifndef IR_LEARN_MIN_TIMES
+#define IR_LEARN_MIN_TIMES      4           // Fewest marks and spaces in a capture kept
+#endif
+#ifndef IR_LEARN_OUTLIER
+#define IR_LEARN_OUTLIER        25          // Difference from the median that makes an outlier (%)
+#endif
+#ifndef IR_LEARN_SLACK
+#define IR_LEARN_SLACK          100         // Difference from the median always allowed (usec)
+#endif
+
+/**
+ * @brief   Consensus of several captures of one button
+ * 
+ * @details A learn reads the button up to IR_LEARN_CAPTURES times. Glitches
+ *          (pulses too short to be IR, from lamps or other light) are
+ *          removed from each capture. When no capture decodes, the first
+ *          frames are compared time by time: only the most common frame
+ *          length is kept, a capture with a time too far from the median
+ *          of the others is dropped, and the rest are averaged.
+ */
+class IR_Learner
+{
+public:
+    /**
+     * @brief   Remove glitches from a capture
+     * 
+     * @details A mark or space shorter than IR_LEARN_GLITCH within the
+     *          capture is merged with the times either side, one at the
+     *          start or end is dropped with its neighbour
+     * 
+     * @param   times   Capture (mark first), edited in place
+     * @param   n_times Number of marks and spaces
+     * 
+     * @return  Number of marks and spaces left
+     */
+    static uint32_t deglitch(uint32_t *times, uint32_t n_times);
+
+    /**
+     * @brief   Average the first frames of several captures
+     * 
+     * @param   captures    Captures (mark first)
+     * @param   counts      Number of marks and spaces of each capture
+     * @param   n_captures  Number of captures
+     * @param   times       Receives the averaged frame (as long as the
+     *                      longest capture)
+     * @param   used        Receives the number of captures averaged
+     * 
+     * @return  Number of marks and spaces in the averaged frame (0 if none)
+     */
+    static uint32_t average(const uint32_t *const *captures, const uint32_t *counts, int n_captures,
+                            uint32_t *times, int &used);
+};
+
+#endif
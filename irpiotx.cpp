@@ -0,0 +1,141 @@
+//                  *****  IR_PioTx class implementation  *****
+
+#include "irpiotx.h"
+#include "irpiotx.pio.h"
+#include <hardware/clocks.h>
+#include <hardware/dma.h>
+#include <hardware/irq.h>
+#include <hardware/pio.h>
+
+#define IR_PIO_CARRIER      38000           // Carrier if the program sets none (Hz)
+#define IR_PIO_CYCLE_TICKS  26              // State machine clocks per carrier cycle
+#define IR_PIO_WORD_TICKS   10              // Clocks per mark and space outside the timing loops
+
+IR_PioTx *IR_PioTx::instance_ = nullptr;
+
+IR_PioTx::IR_PioTx(int gpio, async_context_t *context)
+ : gpio_(gpio), ctx_(context), done_cb_(nullptr), done_data_(nullptr), busy_(false), started_(nil_time)
+{
+    stats_ = {0, 0, 0, 0};
+    done_worker_ = { .do_work = done, .user_data = this };
+    async_context_add_when_pending_worker(ctx_, &done_worker_);
+
+    PIO pio = pio0;
+    if (!pio_can_add_program(pio, &ir_tx_program))
+    {
+        pio = pio1;
+    }
+    pio_ = pio_get_index(pio);
+    offset_ = pio_add_program(pio, &ir_tx_program);
+    sm_ = pio_claim_unused_sm(pio, true);
+    dma_ = dma_claim_unused_channel(true);
+    ir_tx_program_init(pio, sm_, offset_, gpio_);
+    pio_sm_set_enabled(pio, sm_, true);
+
+    instance_ = this;
+    int irq = pio_ == 0 ? PIO0_IRQ_0 : PIO1_IRQ_0;
+    pio_set_irq0_source_enabled(pio, static_cast<pio_interrupt_source>(pis_interrupt0 + sm_), true);
+    irq_add_shared_handler(irq, pio_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(irq, true);
+}
+
+IR_PioTx::~IR_PioTx()
+{
+    PIO pio = pio_get_instance(pio_);
+    int irq = pio_ == 0 ? PIO0_IRQ_0 : PIO1_IRQ_0;
+    pio_set_irq0_source_enabled(pio, static_cast<pio_interrupt_source>(pis_interrupt0 + sm_), false);
+    irq_remove_handler(irq, pio_irq);
+    instance_ = nullptr;
+
+    dma_channel_abort(dma_);
+    dma_channel_unclaim(dma_);
+    pio_sm_set_enabled(pio, sm_, false);
+    pio_sm_exec(pio, sm_, pio_encode_set(pio_pins, 0));
+    pio_sm_unclaim(pio, sm_);
+    pio_remove_program(pio, &ir_tx_program, offset_);
+    async_context_remove_when_pending_worker(ctx_, &done_worker_);
+}
+
+int IR_PioTx::load(const IRPulses &pulses)
+{
+    uint64_t hz = pulses.carrier() != 0 ? pulses.carrier() : IR_PIO_CARRIER;
+    int ret = 0;
+    for (int ii = 0; ii < pulses.size(); ii++)
+    {
+        if (ret >= IR_PIO_MAX_WORDS - 1)
+        {
+            return -1;
+        }
+        if (ii % 2 == 0)
+        {
+            uint64_t cycles = (pulses[ii] * hz + 500000) / 1000000;
+            if (cycles > 0)
+            {
+                words_[ret++] = ((cycles - 1) << 1) | 1;
+            }
+        }
+        else
+        {
+            uint64_t ticks = (pulses[ii] * hz * IR_PIO_CYCLE_TICKS + 500000) / 1000000;
+            ticks = ticks > IR_PIO_WORD_TICKS ? ticks - IR_PIO_WORD_TICKS : 1;
+            words_[ret++] = (ticks > 0x7fffffff ? 0x7fffffff : ticks) << 1;
+        }
+    }
+    words_[ret++] = 0;
+    return ret;
+}
+
+bool IR_PioTx::send(const IRPulses &pulses)
+{
+    int nwords = busy_ ? -1 : load(pulses);
+    if (nwords < 0)
+    {
+        ++stats_.rejected;
+        return false;
+    }
+
+    PIO pio = pio_get_instance(pio_);
+    uint32_t hz = pulses.carrier() != 0 ? pulses.carrier() : IR_PIO_CARRIER;
+    pio_sm_set_clkdiv(pio, sm_, static_cast<float>(clock_get_hz(clk_sys)) / (hz * IR_PIO_CYCLE_TICKS));
+
+    dma_channel_config cfg = dma_channel_get_default_config(dma_);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_dreq(&cfg, pio_get_dreq(pio, sm_, true));
+
+    busy_ = true;
+    started_ = get_absolute_time();
+    ++stats_.programs;
+    stats_.words += nwords - 1;
+    dma_channel_configure(dma_, &cfg, &pio->txf[sm_], words_, nwords, true);
+    return true;
+}
+
+void IR_PioTx::pio_irq()
+{
+    IR_PioTx *self = instance_;
+    if (self)
+    {
+        PIO pio = pio_get_instance(self->pio_);
+        if (pio_interrupt_get(pio, self->sm_))
+        {
+            pio_interrupt_clear(pio, self->sm_);
+            async_context_set_work_pending(self->ctx_, &self->done_worker_);
+        }
+    }
+}
+
+void IR_PioTx::done(async_context_t *ctx, async_when_pending_worker_t *worker)
+{
+    IR_PioTx *self = static_cast<IR_PioTx *>(worker->user_data);
+    if (self->busy_)
+    {
+        self->busy_ = false;
+        self->stats_.busy_us += absolute_time_diff_us(self->started_, get_absolute_time());
+        if (self->done_cb_)
+        {
+            self->done_cb_(self, self->done_data_);
+        }
+    }
+}
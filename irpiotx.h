@@ -0,0 +1,80 @@
+//                  *****  IR_PioTx class  *****
+
+#ifndef IR_PIOTX_H
+#define IR_PIOTX_H
+
+#include "irpulses.h"
+#include <pico/async_context.h>
+#include <pico/time.h>
+#include <stdint.h>
+
+#ifndef IR_PIO_MAX_WORDS
+#define IR_PIO_MAX_WORDS    1024            // Longest program (marks + spaces + end)
+#endif
+
+/**
+ * @brief   PIO IR transmitter
+ * 
+ * @details A PIO state machine generates the carrier and times each mark
+ *          and space from one FIFO word, and DMA feeds it the whole pulse
+ *          program, so a message, or a macro with the delays between its
+ *          messages, goes out with no CPU work per pulse. The state machine
+ *          raises an interrupt at the end of the program and the done
+ *          callback runs on the async context.
+ * 
+ *          Construct on the core that is to take the interrupt.
+ */
+class IR_PioTx
+{
+public:
+    struct Stats
+    {
+        uint32_t        programs;           // Programs sent
+        uint32_t        words;              // Marks and spaces sent
+        uint32_t        rejected;           // Programs refused (busy or too long)
+        uint64_t        busy_us;            // Time transmitting (usec)
+    };
+
+private:
+    int                 gpio_;              // IR LED GPIO
+    async_context_t     *ctx_;              // Async context
+    async_when_pending_worker_t done_worker_;   // Program complete worker
+    void                (*done_cb_)(IR_PioTx *tx, void *user_data);
+    void                *done_data_;
+    volatile bool       busy_;              // Program running
+    absolute_time_t     started_;           // Program start time
+    Stats               stats_;             // Statistics
+
+    int                 pio_;               // PIO block number
+    int                 sm_;                // State machine
+    int                 offset_;            // Program offset
+    int                 dma_;               // DMA channel
+    uint32_t            words_[IR_PIO_MAX_WORDS];   // Program words being sent
+
+    static IR_PioTx     *instance_;         // Transmitter taking the interrupt
+
+    int load(const IRPulses &pulses);
+    static void pio_irq();
+    static void done(async_context_t *ctx, async_when_pending_worker_t *worker);
+
+public:
+    IR_PioTx(int gpio, async_context_t *context);
+    ~IR_PioTx();
+
+    /**
+     * @brief   Start sending a pulse program
+     * 
+     * @param   pulses  Program (copied, may be reused at once)
+     * 
+     * @return  false if busy or the program is too long
+     */
+    bool send(const IRPulses &pulses);
+    bool busy() const { return busy_; }
+
+    void setDoneCallback(void (*cb)(IR_PioTx *tx, void *user_data), void *user_data)
+        { done_cb_ = cb; done_data_ = user_data; }
+
+    void getStats(Stats &stats) const { stats = stats_; }
+};
+
+#endif
@@ -0,0 +1,68 @@
+//                  *****  IRPlan class implementation  *****
+
+#include "irplan.h"
+#include "irdevice.h"
+#include "irrawcode.h"
+#include <string.h>
+
+IRPlan::Step IRPlan::compile(const char *type, uint16_t address, uint16_t value, uint16_t delay)
+{
+    Step ret = {STEP_NONE, 0, address, value, delay, 0};
+    int proto = IR_Device::protocolId(type);
+    if (proto >= 0)
+    {
+        ret.proto = proto;
+    }
+    return ret;
+}
+
+void IRPlan::add(const char *type, uint16_t address, uint16_t value, uint16_t delay)
+{
+    Step step = compile(type, address, value, delay);
+    if (step.proto == STEP_NONE && *type != 0)
+    {
+        if (strncmp(type, "cec:", 4) == 0 && type[4] != 0)
+        {
+            step.proto = STEP_CEC;
+        }
+        else
+        {
+            step.proto = IR_RawCode::isRaw(type) ? STEP_RAW : STEP_MENU;
+        }
+        step.name = names_.size();
+        names_.push_back(type);
+    }
+    if (!steps_.empty())
+    {
+        step.at = steps_.back().at + steps_.back().delay;
+    }
+    steps_.push_back(step);
+}
+
+void IRPlan::repeat(int times)
+{
+    int nn = steps_.size();
+    for (int tt = 1; tt < times; tt++)
+    {
+        for (int ii = 0; ii < nn; ii++)
+        {
+            Step step = steps_[ii];
+            step.at = steps_.back().at + steps_.back().delay;
+            steps_.push_back(step);
+        }
+    }
+}
+
+std::string IRPlan::type(const Step &step) const
+{
+    std::string ret;
+    if (step.proto >= 0)
+    {
+        ret = IR_Device::protocolName(step.proto);
+    }
+    else if (step.proto != STEP_NONE && step.name < names_.size())
+    {
+        ret = names_[step.name];
+    }
+    return ret;
+}
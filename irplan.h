@@ -0,0 +1,84 @@
+//                  *****  IRPlan class  *****
+
+#ifndef IRPLAN_H
+#define IRPLAN_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/**
+ * @brief   Compiled action list
+ * 
+ * @details Action types are resolved once, when the action file loads, to
+ *          an IR protocol number (an index into the transmitters kept by
+ *          IR_Device) or to a CEC, raw IR or menu step, so sending a step
+ *          needs no protocol lookup by name. Each step also holds its start
+ *          offset from the first step, the sum of the delays before it.
+ */
+class IRPlan
+{
+public:
+    static const int8_t STEP_NONE = -1;     // Blank or unknown type (delay only)
+    static const int8_t STEP_CEC = -2;      // tvadapter CEC message
+    static const int8_t STEP_MENU = -3;     // Menu navigation, expanded when sent
+    static const int8_t STEP_RAW = -4;      // Raw IR code (see IR_RawCode)
+
+    struct Step
+    {
+        int8_t          proto;              // IR protocol number or STEP_ kind
+        uint8_t         name;               // Type name index (CEC, raw and menu steps)
+        uint16_t        address;            // Address
+        uint16_t        value;              // Value
+        uint16_t        delay;              // Post action delay (msec)
+        uint32_t        at;                 // Start offset less transmit times (msec)
+
+        bool sameMessage(const Step &other) const
+            { return proto == other.proto && address == other.address && value == other.value; }
+    };
+
+private:
+    std::vector<Step>           steps_;     // Compiled steps
+    std::vector<std::string>    names_;     // CEC, raw and menu type names
+
+public:
+    void clear() { steps_.clear(); names_.clear(); }
+
+    /**
+     * @brief   Compile and add a step
+     * 
+     * @param   type    IR protocol, "cec:" command, "raw:" code or menu action
+     * @param   address Address
+     * @param   value   Value
+     * @param   delay   Post action delay (msec)
+     */
+    void add(const char *type, uint16_t address, uint16_t value, uint16_t delay);
+    void reserve(int steps) { steps_.reserve(steps); }
+
+    /**
+     * @brief   Repeat the steps
+     * 
+     * @param   times   Total number of copies of the steps
+     */
+    void repeat(int times);
+
+    int size() const { return steps_.size(); }
+    const Step &step(int stepNo) const { return steps_[stepNo]; }
+
+    /**
+     * @brief   Get the type name of a step
+     * 
+     * @return  Protocol or CEC, raw or menu type name (blank for STEP_NONE)
+     */
+    std::string type(const Step &step) const;
+
+    /**
+     * @brief   Compile a single step that is not part of a plan
+     * 
+     * @details For steps produced at send time (menu navigation), which
+     *          are IR messages or blank delays
+     */
+    static Step compile(const char *type, uint16_t address, uint16_t value, uint16_t delay);
+};
+
+#endif
@@ -2,57 +2,78 @@
 
 #include "irprocessor.h"
 #include "ir_led.h"
-#include "menu.h"
+#include "irrawcode.h"
 #include "remote.h"
 #include <stdio.h>
 #include <pico/stdlib.h>
 
-IR_Processor::IR_Processor(Remote *remote, int gpio_send, int gpio_receive)
-     : remote_(remote), busy_(0), busy_cb_(nullptr), user_data_(nullptr), tvadapter_(0)
+IR_Processor::IR_Processor(Remote *remote, int gpio_send, int gpio_receive, async_context_t *context)
+     : remote_(remote), asy_ctx_(context), batch_(true),
+       started_(get_absolute_time()), work_us_(0), wakeups_(0), commands_(0),
+       busy_(0), busy_cb_(nullptr), user_data_(nullptr)
 {
-    asy_ctx_ = cyw43_arch_async_context();
+    intake_worker_ = { .do_work = intake, .user_data = this };
+    async_context_add_when_pending_worker(asy_ctx_, &intake_worker_);
     ir_device_ = new IR_Device(gpio_send, gpio_receive, asy_ctx_);
     send_worker_ = new SendWorker(this, asy_ctx_);
     repeat_worker_ = new RepeatWorker(this, asy_ctx_, send_worker_);
 
-    ir_device_->setLogger(remote_->logger());
+    log_.setDebug(remote_->irDebug());
+    ir_device_->setLogger(&log_);
 }
 
 void IR_Processor::run()
 {
+    started_ = get_absolute_time();
+    commandQueued();
     while (true)
     {
-        bool go = !isBusy();
-        if (!go)
-        {
-            Command *cmd = remote_->peekNextCommand();
-            if (cmd)
-            {
-                if (cmd->url() != "/tvadapter" || cmd->action() == "press" || cmd->action() == "release")
-                {
-                    go = true;
-                }
-            }
-        }
+        async_context_wait_for_work_ms(asy_ctx_, 1000);
+    }
+}
 
-        if (go)
-        {
-            Command *cmd = remote_->getNextCommand();
-            if (cmd)
-            {
-                if (cmd->url() == "/tvadapter")
-                {
-                    if (tvadapter_ != cmd->client())
-                    {
-                        remote_->logger()->print("tvadapter handle %u -> %u\n", tvadapter_, cmd->client());
+void IR_Processor::intake(async_context_t *context, async_when_pending_worker_t *worker)
+{
+    IR_Processor *self = static_cast<IR_Processor *>(worker->user_data);
+    absolute_time_t start = get_absolute_time();
+    ++self->wakeups_;
+    self->take_commands();
+    self->add_work_time(start);
+}
 
-                    }
-                    tvadapter_ = cmd->client();
-                }
-                do_command(cmd);
-            }
+void IR_Processor::take_commands()
+{
+    //  Release, cancel and press go straight through
+    Command *cmd;
+    while ((cmd = remote_->getNextCommand(Remote::LANE_HIGH)) != nullptr)
+    {
+        ++commands_;
+        do_command(cmd);
+    }
+
+    //  Everything else takes its turn when the processor is idle
+    while ((cmd = remote_->getNextCommand(Remote::LANE_NORMAL)) != nullptr)
+    {
+        ++commands_;
+        if (!scheduler_.add(cmd))
+        {
+            cmd->setReply("busy", false);
+            do_reply(cmd);
         }
     }
+
+    while (!isBusy() && !scheduler_.empty())
+    {
+        do_command(scheduler_.next());
+    }
+}
+
+void IR_Processor::getIdleStats(IdleStats &stats) const
+{
+    stats.wakeups = wakeups_;
+    stats.commands = commands_;
+    stats.work_us = work_us_;
+    stats.run_us = absolute_time_diff_us(started_, get_absolute_time());
 }
 
 bool IR_Processor::do_reply(Command *cmd)
@@ -63,26 +84,36 @@ bool IR_Processor::do_reply(Command *cmd)
 
 bool IR_Processor::do_command(Command *cmd)
 {
-    if (cmd->action() == "click")
+    //  Everything the command needs was copied when it was made on the web core
+    log_.setDebug(remote_->irDebug());
+
+    if (cmd->action() == Command::CMD_CLICK)
     {
         cancel_repeat();
-        cmd->setReply(cmd->action());
+        cmd->setReply(cmd->actionName());
+        if (cmd->times() > 1)
+        {
+            cmd->setReplyValue("count", cmd->times());
+        }
         if (!send(cmd))
         {
             do_reply(cmd);
         }
     }
-    else if (cmd->action() == "press")
+    else if (cmd->action() == Command::CMD_PRESS)
     {
         if (!isRepeating(cmd))
         {
             bool cancelled = cancel_repeat();
-            if (cmd->repeat() > 0 && cmd->redirect().empty())
+            if (cmd->repeat() > 0 && cmd->redirect()[0] == 0)
             {
                 if (!cancelled && send_worker_->command() == nullptr)
                 {
-                    cmd->setReply(cmd->action(), false);
-                    do_repeat(cmd);
+                    cmd->setReply(cmd->actionName(), false);
+                    if (!do_repeat(cmd))
+                    {
+                        cmd->setReply("busy");
+                    }
                 }
                 else
                 {
@@ -102,38 +133,60 @@ bool IR_Processor::do_command(Command *cmd)
         else
         {
             repeat_worker_->continueRepeat();
+            delete cmd;
         }
     }
-    else if (cmd->action() == "release" || cmd->action()== "cancel")
+    else if (cmd->action() == Command::CMD_RELEASE || cmd->action() == Command::CMD_CANCEL)
     {
         cancel_repeat();
-        cmd->setReply(cmd->action(), false);
-        cmd->setReplyValue("repetitions", std::to_string(send_worker_->repetitions()));
+        cmd->setReply(cmd->actionName(), false);
+        cmd->setReplyValue("repetitions", send_worker_->repetitions());
         do_reply(cmd);
     }
-    else if (cmd->action() == "test_send")
+    else if (cmd->action() == Command::CMD_TEST_SEND)
     {
         cancel_repeat();
-        cmd->setReply(cmd->action());
+        cmd->setReply(cmd->actionName());
         if (!send(cmd))
         {
             do_reply(cmd);
         }
     }
-    else if (cmd->action() == "ir_get")
+    else if (cmd->action() == Command::CMD_IR_GET)
+    {
+        if (ir_device_->learning())
+        {
+            //  One learn at a time: the receiver and callback belong to the first
+            cmd->setReply("busy");
+            do_reply(cmd);
+        }
+        else
+        {
+            ir_device_->identify(identified, new std::pair<IR_Processor *, Command *>(this, cmd));
+        }
+    }
+    else if (cmd->action() == Command::CMD_SNIFF)
+    {
+        ir_device_->sniff(cmd->row() != 0);
+        cmd->setReply(cmd->actionName());
+        cmd->setReplyValue("sniff", ir_device_->sniffing() ? 1 : 0);
+        do_reply(cmd);
+    }
+    else
     {
-        ir_device_->identify(identified, new std::pair<IR_Processor *, Command *>(this, cmd));
+        delete cmd;
     }
     return true;
 }
 
-void IR_Processor::identified(const std::string &type, uint16_t address, uint16_t value, void *data)
+void IR_Processor::identified(const std::string &type, uint16_t address, uint16_t value, int confidence, void *data)
 {
     auto ptrs = static_cast<std::pair<IR_Processor *, Command *> *>(data);
     IR_Processor *self = ptrs->first;
     Command *cmd = ptrs->second;
     cmd->setStep(type, address, value);
     cmd->setReply("ir_resp");
+    cmd->setReplyValue("confidence", confidence);
     self->do_reply(cmd);
     delete ptrs;
 }
@@ -160,6 +213,10 @@ bool IR_Processor::do_repeat(Command *cmd)
 {
     bool ret = false;
     Command *rcmd = new Command(*cmd);
+    if (!rcmd)
+    {
+        return false;
+    }
     RepeatWorker *rparam = repeat_worker_;
     rparam->reset();
     SendWorker *sparam = rparam->sendWorker();
@@ -190,26 +247,19 @@ void IR_Processor::add_to_busy(int add)
         {
             busy_cb_(busy_ != 0, user_data_);
         }
+        if (busy_ == 0)
+        {
+            //  Commands held back while busy can go now
+            commandQueued();
+        }
     }
 }
 
-bool IR_Processor::send_cec_message(Command::Step &step)
+bool IR_Processor::send_cec_message(const std::string &type, uint16_t address, uint16_t value)
 {
-    bool ret = false;
-    if (tvadapter_ != 0)
-    {
-        std::string message = "{\"action\":\"cec\",\"cmd\":\"" + step.type().substr(4) +
-                            "\",\"val1\":" + std::to_string(step.address()) +
-                            ",\"val2\":" + std::to_string(step.value()) + "}";
-        remote_->logger()->print_debug(2, "CEC message: %s\n", message.c_str());
-        ret = WEB::get()->send_message(tvadapter_, message);
-        if (!ret)
-        {
-            remote_->logger()->print("Invalid handle %u for CEC command\n", tvadapter_);
-            tvadapter_ = 0;
-        }
-    }
-    return ret;
+    //  The web core sends it to the tvadapter
+    log_.print_debug(2, "CEC message: %s %u %u\n", type.c_str() + 4, address, value);
+    return remote_->sendCEC(type.c_str() + 4, address, value);
 }
 
 
@@ -225,6 +275,9 @@ bool IR_Processor::SendWorker::start()
         repetitions_ = 0;
         start_time_ = to_ms_since_boot(get_absolute_time());
         pause = cmd_->repeat();
+        cmd_->getPlan(plan_);
+        steps_per_send_ = plan_.size();
+        plan_.repeat(cmd_->times());
     }
     return async_context_add_at_time_worker_in_ms(asy_ctx_, &time_worker_, pause);
 }
@@ -232,71 +285,81 @@ bool IR_Processor::SendWorker::start()
 void IR_Processor::SendWorker::time_work(async_context_t *context, async_at_time_worker_t *worker)
 {
     SendWorker *param = sendWorker(worker);
+    absolute_time_t start = get_absolute_time();
     param->time_work();
+    param->irProcessor()->add_work_time(start);
 }
 
 void IR_Processor::SendWorker::time_work()
 {
     bool more = false;
     int ii = sendStep();
-    if (command() && ii < command()->steps().size())
+    if (command() && ii < plan_.size() && menu_steps_.size() == 0 && irp_->batch_ && sendBatch(ii))
     {
-        Command::Step step = getStep(ii, true);
-        if (get_transmitter(step.type()))
+        more = true;
+    }
+    else if (command() && ii < plan_.size() && menu_steps_.size() == 0 && !menu_wait_ &&
+             plan_.step(ii).proto == IRPlan::STEP_MENU)
+    {
+        //  Menus belong to the web core, which expands the action and rings menu_ready
+        menu_wait_ = true;
+        const IRPlan::Step &step = plan_.step(ii);
+        irp_->remote_->requestMenuSteps(Command::Step(plan_.type(step), step.address, step.value, step.delay));
+        more = true;
+    }
+    else if (command() && ii < plan_.size())
+    {
+        bool menu = menu_steps_.size() > 0;
+        bool expanded = false;
+        IRPlan::Step step = getStep(ii, true);
+        if (step.proto == IRPlan::STEP_MENU && getMenuSteps(step))
+        {
+            expanded = true;
+            step = getStep(ii, true);
+        }
+
+        if (get_encoder(step.proto))
         {
+            //  Each merged click starts with a full message
             bool repeat = repeated() ||
-                         (last_step_.type() == step.type() &&
-                          last_step_.address() == step.address() &&
-                          last_step_.value() == step.value() &&
-                          last_step_.delay() < ir_led_->repeatInterval() / 2);
+                         (!expanded && (menu || ii % steps_per_send_ != 0) && IRSchedule::repeats(last_step_, step));
             last_step_ = step;
-            ir_led_->setMessageTimes(step.address(), step.value());
-            if (!repeat)
+            pulses_.clear();
+            encoder_->encode(step.address, step.value, repeat, pulses_);
+            if (!irp_->ir_device_->transmitter()->send(pulses_))
             {
-                ir_led_->transmit();
+                irp_->log_.print("IR transmitter refused step %d\n", ii);
+                set_ir_complete(nullptr, this);
             }
-            else
+            if (repeat && !expanded)
             {
-                ir_led_->repeat();
                 ++repetitions_;
             }
-            logStep("Step", step, ii, repeat);
+            logStep(expanded ? "Menu Step" : "Step", step, ii, repeat);
+        }
+        else if (step.proto == IRPlan::STEP_RAW)
+        {
+            last_step_ = step;
+            pulses_.clear();
+            if (!IR_RawCode::decode(plan_.type(step), pulses_) || !irp_->ir_device_->transmitter()->send(pulses_))
+            {
+                irp_->log_.print("IR transmitter refused raw step %d\n", ii);
+                set_ir_complete(nullptr, this);
+            }
+            logStep("Raw Step", step, ii, false);
         }
-        else if (step.type().length() > 4 && step.type().substr(0, 4) == "cec:")
+        else if (step.proto == IRPlan::STEP_CEC)
         {
-            irp_->send_cec_message(step);
+            irp_->send_cec_message(plan_.type(step), step.address, step.value);
             set_ir_complete(nullptr, this);
         }
-        else if (getMenuSteps(step))
+        else
         {
-            step = getStep(ii, true);
-            if (get_transmitter(step.type()))
-            {
-                last_step_ = step;
-                ir_led_->setMessageTimes(step.address(), step.value());
-                if (!repeated())
-                {
-                    ir_led_->transmit();
-                }
-                else
-                {
-                    ir_led_->repeat();
-                }
-                logStep("Menu Step", step, ii, repeated());
-            }
-            else if (step.type().empty())
+            if (expanded)
             {
                 last_step_ = step;
                 logStep("Menu Blank", step, ii, repeated());
             }
-            else
-            {
-                logStep("Menu Done", step, ii, repeated());
-                set_ir_complete(nullptr, this);
-            }
-        }
-        else
-        {
             set_ir_complete(nullptr, this);
         }
         more = true;
@@ -323,16 +386,41 @@ void IR_Processor::SendWorker::time_work()
     }
 }
 
-void IR_Processor::SendWorker::logStep(const char *name, const Command::Step &step, int stepno, bool repeat) const
+bool IR_Processor::SendWorker::sendBatch(int stepNo)
+{
+    bool ret = false;
+    IRPlan::Step last = last_step_;
+    if (schedule_.build(plan_, stepNo, steps_per_send_, repeated(), last, IR_PIO_MAX_WORDS - 1) > 0 &&
+        irp_->ir_device_->transmitter()->send(schedule_.pulses()))
+    {
+        last_step_ = last;
+        for (int ii = 0; ii < schedule_.size(); ii++)
+        {
+            const IRSchedule::Entry &entry = schedule_.entry(ii);
+            if (entry.repeat)
+            {
+                ++repetitions_;
+            }
+            logStep("Batch Step", plan_.step(entry.step), entry.step, entry.repeat);
+        }
+        //  The last step's delay is in the program
+        setStep(stepNo + schedule_.size() - 1);
+        batched_ = true;
+        ret = true;
+    }
+    return ret;
+}
+
+void IR_Processor::SendWorker::logStep(const char *name, const IRPlan::Step &step, int stepno, bool repeat) const
 {
-    if (irp_->remote_->logger()->isDebug(1))
+    if (irp_->log_.isDebug(1))
     {
-        irp_->remote_->logger()->print("%5d %s %2d: '%s' %d %d %d repeat=%s\n",
-            elapsed(), name, stepno, step.type().c_str(), step.address(), step.value(), step.delay(), repeat ? "T" : "F");
+        irp_->log_.print("%5d %s %2d: '%s' %d %d %d repeat=%s\n",
+            elapsed(), name, stepno, plan_.type(step).c_str(), step.address, step.value, step.delay, repeat ? "T" : "F");
     }
 }
 
-void IR_Processor::SendWorker::set_ir_complete(IR_LED *led, void *user_data)
+void IR_Processor::SendWorker::set_ir_complete(IR_PioTx *tx, void *user_data)
 {
     SendWorker *param = sendWorker(user_data);
     param->setIRComplete();
@@ -341,12 +429,25 @@ void IR_Processor::SendWorker::set_ir_complete(IR_LED *led, void *user_data)
 void IR_Processor::SendWorker::ir_complete(async_context_t *context, async_when_pending_worker_t *worker)
 {
     SendWorker *param = sendWorker(worker);
+    absolute_time_t start = get_absolute_time();
     param->scheduleNext();
+    param->irProcessor()->add_work_time(start);
 }
 
-Command::Step IR_Processor::SendWorker::getStep(int stepNo, bool peek)
+void IR_Processor::SendWorker::menu_ready(async_context_t *context, async_when_pending_worker_t *worker)
 {
-    Command::Step ret;
+    SendWorker *param = sendWorker(worker);
+    absolute_time_t start = get_absolute_time();
+    if (param->menu_wait_)
+    {
+        param->time_work();
+    }
+    param->irProcessor()->add_work_time(start);
+}
+
+IRPlan::Step IR_Processor::SendWorker::getStep(int stepNo, bool peek)
+{
+    IRPlan::Step ret = IRPlan::compile("", 0, 0, 0);
     if (menu_steps_.size() > 0)
     {
         ret = menu_steps_.front();
@@ -356,75 +457,45 @@ Command::Step IR_Processor::SendWorker::getStep(int stepNo, bool peek)
             nextStep();
         }
     }
-    else if (stepNo < cmd_->steps().size())
+    else if (stepNo < plan_.size())
     {
-        ret = cmd_->steps().at(stepNo);
+        ret = plan_.step(stepNo);
     }
     return ret;
 }
 
-bool IR_Processor::SendWorker::getMenuSteps(const Command::Step &step)
+bool IR_Processor::SendWorker::getMenuSteps(const IRPlan::Step &step)
 {
-    bool ret = Menu::getMenuSteps(step, menu_steps_);
-    if (ret && step.delay() > 0)
+    std::deque<Command::Step> steps;
+    bool ret = irp_->remote_->takeMenuSteps(steps);
+    menu_wait_ = false;
+    for (auto it = steps.cbegin(); it != steps.cend(); ++it)
     {
-        menu_steps_.push_back(Command::Step("", 0, 0, step.delay()));
+        menu_steps_.push_back(IRPlan::compile(it->type().c_str(), it->address(), it->value(), it->delay()));
     }
-    return ret;
-}
-
-int IR_Processor::SendWorker::getTime()
-{
-    int delays = 0;
-    for (int ii = 0; ii < cmd_->steps().size(); ii++)
+    if (ret && step.delay > 0)
     {
-        delays += cmd_->steps().at(ii).delay();
-        if (get_transmitter(cmd_->steps().at(ii).type()))
-        {
-            delays += ir_led_->repeatInterval() * (1 /*+ ir_led_->minimum_repeats()*/);
-        }
-        else if (getMenuSteps(cmd_->steps().at(ii)))
-        {
-            while (menu_steps_.size() > 0)
-            {
-                delays += menu_steps_.front().delay();
-                if (get_transmitter(menu_steps_.front().type()))
-                {
-                    delays += ir_led_->repeatInterval() * (1 + ir_led_->minimum_repeats());
-                }
-                menu_steps_.pop_front();
-            }
-        }
+        menu_steps_.push_back(IRPlan::compile("", 0, 0, step.delay));
     }
-    return delays;
+    return ret;
 }
 
 bool IR_Processor::SendWorker::scheduleNext()
 {
     int ns = nextStep();
-    const Command::Step step = getStep(ns);
-    int delay = step.delay();
-    int rpt = 0;
-    if (get_transmitter(step.type()))
-    {
-        rpt = ir_led_->repeatInterval();
-        rpt = 0;
-    }
-    absolute_time_t next1 = make_timeout_time_ms(delay);
-    absolute_time_t next2 = delayed_by_ms(time_worker_.next_time, rpt);
+    const IRPlan::Step step = getStep(ns);
+    absolute_time_t next1 = make_timeout_time_ms(batched_ ? 0 : step.delay);
+    batched_ = false;
+    absolute_time_t next2 = time_worker_.next_time;
     time_worker_.next_time = absolute_time_diff_us(next1, next2) > 0 ? next2 : next1;
     bool ret = async_context_add_at_time_worker(asy_ctx_, &time_worker_);
     return ret;
 }
 
-bool IR_Processor::SendWorker::get_transmitter(const std::string &proto)
+bool IR_Processor::SendWorker::get_encoder(int proto)
 {
-    bool ret = irProcessor()->ir_device_->get_transmitter(proto, ir_led_);
-    if (ret)
-    {
-        ir_led_->setDoneCallback(set_ir_complete, this);
-    }
-    return ret;
+    encoder_ = IR_Device::encoder(proto);
+    return encoder_ != nullptr;
 }
 
 
@@ -452,7 +523,7 @@ void IR_Processor::RepeatWorker::repeat()
             }
             else
             {
-                irp_->remote_->logger()->print_debug(1, "Stop repeating at limit\n");
+                irp_->log_.print_debug(1, "Stop repeating at limit\n");
                 finish();
             }
         }
@@ -5,13 +5,16 @@
 
 #include "irdevice.h"
 #include "command.h"
+#include "commandscheduler.h"
+#include "irschedule.h"
+#include "logger.h"
 #include <vector>
 #include <deque>
 #include <map>
+#include <atomic>
 #include <pico/async_context.h>
 
 class Remote;
-class IR_LED;
 
 class IR_Processor
 {
@@ -22,48 +25,62 @@ private:
     {
     private:
         IR_Processor                *irp_;              // Pointer to this object
-        IR_LED                      *ir_led_;           // IR LED
+        const IR_Encoder            *encoder_;          // Protocol encoder of the step
+        IRPulses                    pulses_;            // Pulse program being sent
+        IRSchedule                  schedule_;          // Batch being sent
+        bool                        batched_;           // Last send was a batch
         uint32_t                    start_time_;        // Command start time
         async_context_t             *asy_ctx_;          // Async context
         async_at_time_worker_t      time_worker_;       // Timing worker
         async_when_pending_worker_t ir_complete_;       // IR output complete worker
+        async_when_pending_worker_t menu_ready_;        // Menu steps arrived worker
         Command                     *cmd_;              // Active command
         RepeatWorker                *repeat_worker_;    // Repeat worker
         int                         send_step_;         // Step in send operation
-        std::deque<Command::Step>   menu_steps_;        // Menu steps
-        Command::Step               last_step_;         // Last command step sent
+        IRPlan                      plan_;              // Compiled command steps (snapshot)
+        int                         steps_per_send_;    // Steps in one send (plan_ holds times())
+        std::deque<IRPlan::Step>    menu_steps_;        // Menu steps
+        IRPlan::Step                last_step_;         // Last command step sent
         int                         repetitions_;       // Repetition count
         bool                        repeated_;          // Repeated operation flag
         bool                        do_reply_;          // Send reply when action complete
+        bool                        menu_wait_;         // Waiting for menu steps from the web core
 
         IR_Processor *irProcessor() const { return irp_; }
-        bool get_transmitter(const std::string &proto);
+        bool get_encoder(int proto);
         bool scheduleNext();
-        bool getMenuSteps(const Command::Step &step);
+        bool getMenuSteps(const IRPlan::Step &step);
+        bool sendBatch(int stepNo);
 
         int sendStep() const { return send_step_; }
         int nextStep() { return menu_steps_.size() == 0 ? send_step_++ : send_step_; }
         void setStep(int step) { send_step_ = step; }
-        Command::Step getStep(int stepNo, bool peek = false);
+        IRPlan::Step getStep(int stepNo, bool peek = false);
         bool repeated() const { return repeated_; }
         void setIRComplete() { async_context_set_work_pending(asy_ctx_, &ir_complete_); }
 
         static void time_work(async_context_t *, async_at_time_worker_t *);
         void time_work();
         static void ir_complete(async_context_t *, async_when_pending_worker_t *);
-        static void set_ir_complete(IR_LED *led, void *user_data);
+        static void set_ir_complete(IR_PioTx *tx, void *user_data);
+        static void menu_ready(async_context_t *, async_when_pending_worker_t *);
         bool doReply() const { return do_reply_; }
 
-        void logStep(const char *name, const Command::Step &step, int stepno, bool repeat) const;
+        void logStep(const char *name, const IRPlan::Step &step, int stepno, bool repeat) const;
 
     public:
         SendWorker(IR_Processor *parent, async_context_t *async)
-         : irp_(parent), ir_led_(nullptr), start_time_(0), asy_ctx_(async),
-           cmd_(nullptr), repeat_worker_(nullptr), send_step_(0), repeated_(false), do_reply_(false)
+         : irp_(parent), encoder_(nullptr), batched_(false), start_time_(0), asy_ctx_(async),
+           cmd_(nullptr), repeat_worker_(nullptr), send_step_(0), steps_per_send_(0),
+           last_step_(IRPlan::compile("", 0, 0, 0)), repetitions_(0), repeated_(false), do_reply_(false),
+           menu_wait_(false)
         {
             time_worker_ = { .do_work = time_work, .user_data = this };
             ir_complete_ = { .do_work = ir_complete, .user_data = this };
+            menu_ready_ = { .do_work = menu_ready, .user_data = this };
             async_context_add_when_pending_worker(asy_ctx_, &ir_complete_);
+            async_context_add_when_pending_worker(asy_ctx_, &menu_ready_);
+            parent->ir_device_->transmitter()->setDoneCallback(set_ir_complete, this);
         }
 
         Command *command() const { return cmd_; }
@@ -77,12 +94,13 @@ private:
         void setRepeatWorker(RepeatWorker *worker) { repeat_worker_ = worker; }
         void setRepeated(bool repeated = true) { repeated_ = repeated; }
         void setDoReply(bool doReply = true) { do_reply_ = doReply; }
+        void setMenuReady() { async_context_set_work_pending(asy_ctx_, &menu_ready_); }
 
-        int getTime();
         int repetitions() const { return repetitions_; }
 
         void reset() { cmd_ = nullptr; repeat_worker_ = nullptr; send_step_ = 0;
-                       menu_steps_.clear(), last_step_.setType(""), repetitions_ = 0; repeated_ = false; do_reply_ = false; }
+                       menu_steps_.clear(), last_step_ = IRPlan::compile("", 0, 0, 0); repetitions_ = 0; repeated_ = false; do_reply_ = false;
+                       batched_ = false; menu_wait_ = false; }
     };
 
     static SendWorker *sendWorker(async_at_time_worker_t *worker) { return static_cast<SendWorker *>(worker->user_data); }
@@ -132,7 +150,15 @@ private:
     SendWorker                      *send_worker_;      // Send step worker
     RepeatWorker                    *repeat_worker_;    // Repeat worker
     async_context_t                 *asy_ctx_;          // Async context
-    ClientHandle                    tvadapter_;         // Handle for tvadapter websocket
+    async_when_pending_worker_t     intake_worker_;     // Command doorbell worker
+    CommandScheduler                scheduler_;         // Normal lane commands waiting
+    std::atomic<bool>               batch_;             // Send runs of IR steps as one program
+    Logger                          log_;               // Console logger (no flash writes on core 1)
+
+    absolute_time_t                 started_;           // Time run() started
+    uint64_t                        work_us_;           // Time spent in IR workers
+    uint32_t                        wakeups_;           // Doorbell rings serviced
+    uint32_t                        commands_;          // Commands taken
 
     int                             busy_;              // Busy counter
     void add_to_busy(int add);
@@ -140,6 +166,10 @@ private:
     void (*busy_cb_)(bool busy, void *user_data);
     void *user_data_;
 
+    static void intake(async_context_t *context, async_when_pending_worker_t *worker);
+    void take_commands();
+    void add_work_time(absolute_time_t start) { work_us_ += absolute_time_diff_us(start, get_absolute_time()); }
+
     bool do_command(Command *cmd);
     bool do_reply(Command *cmd);
     bool send(Command *cmd);
@@ -148,16 +178,116 @@ private:
     bool isRepeating(const Command *cmd) const
         {return repeat_worker_->isActive() && send_worker_->command() != nullptr && *send_worker_->command() == *cmd;}
 
-    static void identified(const std::string &type, uint16_t address, uint16_t value, void *data);
+    static void identified(const std::string &type, uint16_t address, uint16_t value, int confidence, void *data);
 
-    bool send_cec_message(Command::Step &step);
+    bool send_cec_message(const std::string &type, uint16_t address, uint16_t value);
 
 public:
-    IR_Processor(Remote*remote, int gpio_send, int gpio_receive);
+    /**
+     * @brief   Construct the IR engine
+     * 
+     * @details Construct on the core that is to run it. All IR timing and
+     *          receive work runs on the given async context, leaving the
+     *          cyw43 context to the network.
+     * 
+     * @param   remote          Remote object (command source and reply sink)
+     * @param   gpio_send       IR LED GPIO
+     * @param   gpio_receive    IR receiver GPIO
+     * @param   context         Async context of the IR core
+     */
+    IR_Processor(Remote *remote, int gpio_send, int gpio_receive, async_context_t *context);
     ~IR_Processor() { delete ir_device_; delete send_worker_; delete repeat_worker_; }
 
+    /**
+     * @brief   Run the IR engine (does not return)
+     * 
+     * @details Commands are taken by a when_pending worker that the Remote
+     *          rings as it queues a command, and again when the processor
+     *          goes idle, so the core sleeps while there is nothing to do.
+     *          High lane commands run at once. Normal lane commands wait in
+     *          the scheduler until the processor is idle.
+     */
     void run();
 
+    /**
+     * @brief   Ring the command doorbell
+     * 
+     * @details Called by the web core after queuing a command
+     */
+    void commandQueued() { async_context_set_work_pending(asy_ctx_, &intake_worker_); }
+
+    /**
+     * @brief   Ring the menu steps doorbell
+     * 
+     * @details Called by the web core when it has expanded the menu action
+     *          the send is waiting on (see Remote::requestMenuSteps)
+     */
+    void menuStepsReady() { send_worker_->setMenuReady(); }
+
+    struct IdleStats
+    {
+        uint32_t    wakeups;            // Doorbell rings serviced
+        uint32_t    commands;           // Commands taken
+        uint64_t    work_us;            // Time spent in IR workers
+        uint64_t    run_us;             // Time since run() started
+    };
+
+    /**
+     * @brief   Get the intake and idle time counters
+     * 
+     * @param   stats   Receives the counters
+     */
+    void getIdleStats(IdleStats &stats) const;
+
+    /**
+     * @brief   Get the IR transmitter counters
+     * 
+     * @param   stats   Receives the counters
+     */
+    void getTxStats(IR_PioTx::Stats &stats) const { ir_device_->transmitter()->getStats(stats); }
+
+    /**
+     * @brief   Get the per-client scheduling counters
+     * 
+     * @param   stats   Array to receive the clients
+     * @param   max     Size of array
+     * 
+     * @return  Number of clients copied
+     */
+    int getClientStats(CommandScheduler::ClientStats *stats, int max) const { return scheduler_.getStats(stats, max); }
+
+    /**
+     * @brief   Select batch or step by step sending
+     * 
+     * @details In batch mode each run of IR and delay steps in a command is
+     *          encoded into one pulse program, so the transmitter clock
+     *          times the steps and the delays between them. CEC and menu
+     *          steps are sent one at a time in either mode. Batch is the
+     *          default.
+     * 
+     * @param   batch   true for batch mode
+     */
+    void setBatch(bool batch) { batch_ = batch; }
+    bool batch() const { return batch_; }
+
+    /**
+     * @brief   Get the latest copy of the sniffed frames and counters
+     * 
+     * @details Call on the web core (see IR_Device::takeSniffLog)
+     * 
+     * @param   log     Replaced if a newer copy has been published
+     * 
+     * @return  true if log was replaced
+     */
+    bool getSniffLog(IR_Device::SniffLog &log) { return ir_device_->takeSniffLog(log); }
+
+    /**
+     * @brief   Set the callback for a change in the sniffed frames
+     * 
+     * @details Called on the IR core
+     */
+    void setSniffCallback(void (*cb)(void *data), void *data) { ir_device_->setSniffCallback(cb, data); }
+
     void setBusyCallback(void (*busy_cb)(bool busy, void *user_data), void *user_data) { busy_cb_ = busy_cb; user_data_ = user_data; }
 };
 
@@ -0,0 +1,72 @@
+//                  *****  IRPulses class implementation  *****
+
+#include "irpulses.h"
+
+void IRPulses::mark(uint32_t usec)
+{
+    if (usec == 0)
+    {
+        return;
+    }
+    if (times_.size() % 2 == 0)
+    {
+        times_.push_back(usec);
+    }
+    else
+    {
+        times_.back() += usec;
+    }
+    duration_ += usec;
+}
+
+void IRPulses::space(uint32_t usec)
+{
+    if (usec == 0)
+    {
+        return;
+    }
+    if (times_.empty())
+    {
+        times_.push_back(0);
+    }
+    if (times_.size() % 2 == 1)
+    {
+        times_.push_back(usec);
+    }
+    else
+    {
+        times_.back() += usec;
+    }
+    duration_ += usec;
+}
+
+bool IRPulses::setCarrier(uint32_t hz)
+{
+    bool ret = false;
+    if (carrier_ == 0 || carrier_ == hz)
+    {
+        carrier_ = hz;
+        ret = true;
+    }
+    return ret;
+}
+
+bool IRPulses::append(const IRPulses &other)
+{
+    bool ret = other.carrier_ == 0 || setCarrier(other.carrier_);
+    if (ret)
+    {
+        for (int ii = 0; ii < other.size(); ii++)
+        {
+            if (ii % 2 == 0)
+            {
+                mark(other[ii]);
+            }
+            else
+            {
+                space(other[ii]);
+            }
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,63 @@
+//                  *****  IRPulses class  *****
+
+#ifndef IRPULSES_H
+#define IRPULSES_H
+
+#include <vector>
+#include <stdint.h>
+
+/**
+ * @brief   IR pulse program
+ * 
+ * @details Alternating mark (carrier on) and space times in microseconds,
+ *          marks at the even indices. Adding a mark after a mark, or a
+ *          space after a space, lengthens the last one, so messages and
+ *          the delays between them can be appended to one program. Times
+ *          of 0 are not added. A program that starts with a space has a
+ *          leading mark of 0.
+ */
+class IRPulses
+{
+private:
+    std::vector<uint32_t>   times_;         // Mark/space times (usec)
+    uint64_t                duration_;      // Sum of times (usec)
+    uint32_t                carrier_;       // Carrier frequency (Hz), 0 if not set
+
+public:
+    IRPulses() : duration_(0), carrier_(0) {}
+
+    void clear() { times_.clear(); duration_ = 0; carrier_ = 0; }
+    void reserve(int pulses) { times_.reserve(pulses); }
+
+    void mark(uint32_t usec);
+    void space(uint32_t usec);
+
+    /**
+     * @brief   Append another program
+     * 
+     * @param   other   Program to append
+     * 
+     * @return  false if the programs have different carriers
+     */
+    bool append(const IRPulses &other);
+
+    /**
+     * @brief   Set the carrier frequency
+     * 
+     * @param   hz      Carrier frequency (Hz)
+     * 
+     * @return  false if the program already has a different carrier
+     */
+    bool setCarrier(uint32_t hz);
+    uint32_t carrier() const { return carrier_; }
+
+    int size() const { return times_.size(); }
+    uint32_t operator[](int index) const { return times_[index]; }
+    const uint32_t *times() const { return times_.data(); }
+    uint64_t duration() const { return duration_; }
+
+    bool operator==(const IRPulses &other) const { return carrier_ == other.carrier_ && times_ == other.times_; }
+    bool operator!=(const IRPulses &other) const { return !(*this == other); }
+};
+
+#endif
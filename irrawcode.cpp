@@ -0,0 +1,164 @@
+//                  *****  IR_RawCode class implementation  *****
+
+#include "irrawcode.h"
+#include <algorithm>
+#include <vector>
+#include <utility>
+#include <stdio.h>
+#include <stdlib.h>
+
+const char IR_RawCode::digits_[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+int IR_RawCode::bitsFor(int count)
+{
+    int ret = 0;
+    while ((1 << ret) < count)
+    {
+        ++ret;
+    }
+    return ret;
+}
+
+int IR_RawCode::digit(char ch)
+{
+    const char *pos = ch != 0 ? strchr(digits_, ch) : nullptr;
+    return pos ? pos - digits_ : -1;
+}
+
+bool IR_RawCode::encode(const uint32_t *times, uint32_t n_times, std::string &type)
+{
+    bool ret = false;
+    type.clear();
+    if (n_times >= IR_RAW_MIN_TIMES)
+    {
+        //  Quantize: each cluster of sorted times becomes its mean, to 10 usec
+        struct Cluster
+        {
+            uint32_t    low;                // Shortest time
+            uint32_t    high;               // Longest time
+            uint32_t    centre;             // Quantized time
+        };
+        std::vector<uint32_t> sorted(times, times + n_times);
+        std::sort(sorted.begin(), sorted.end());
+        std::vector<Cluster> clusters;
+        for (uint32_t ii = 0; ii < n_times; )
+        {
+            uint32_t low = sorted[ii];
+            uint32_t spread = std::max<uint32_t>(low * IR_RAW_TOLERANCE / 100, IR_RAW_SLACK);
+            uint64_t sum = 0;
+            uint32_t jj = ii;
+            while (jj < n_times && sorted[jj] - low <= spread)
+            {
+                sum += sorted[jj++];
+            }
+            clusters.push_back({low, sorted[jj - 1], static_cast<uint32_t>((sum / (jj - ii) + 5) / 10 * 10)});
+            ii = jj;
+        }
+        auto quantize = [&clusters](uint32_t time)
+        {
+            uint32_t ret = time;
+            for (auto it = clusters.cbegin(); it != clusters.cend(); ++it)
+            {
+                if (time >= it->low && time <= it->high)
+                {
+                    ret = it->centre;
+                }
+            }
+            return ret;
+        };
+
+        //  Pair table and the pair sequence
+        std::vector<std::pair<uint32_t, uint32_t>> pairs;
+        std::vector<uint8_t> seq;
+        ret = true;
+        for (uint32_t ii = 0; ret && ii < n_times; ii += 2)
+        {
+            std::pair<uint32_t, uint32_t> pair(quantize(times[ii]), ii + 1 < n_times ? quantize(times[ii + 1]) : 0);
+            int idx = std::find(pairs.cbegin(), pairs.cend(), pair) - pairs.cbegin();
+            if (idx == pairs.size())
+            {
+                pairs.push_back(pair);
+            }
+            seq.push_back(idx);
+            ret = pairs.size() <= MAX_PAIRS;
+        }
+
+        if (ret)
+        {
+            char buf[32];
+            snprintf(buf, sizeof(buf), IR_RAW_PREFIX "%d:", IR_RAW_CARRIER);
+            type = buf;
+            for (int ii = 0; ii < pairs.size(); ii++)
+            {
+                snprintf(buf, sizeof(buf), "%s%u/%u", ii > 0 ? "," : "", pairs[ii].first, pairs[ii].second);
+                type += buf;
+            }
+            type += ':';
+
+            int bits = bitsFor(pairs.size());
+            int max_run = 1 << (6 - bits);
+            for (int ii = 0; ii < seq.size(); )
+            {
+                int run = 1;
+                while (run < max_run && ii + run < seq.size() && seq[ii + run] == seq[ii])
+                {
+                    ++run;
+                }
+                type += digits_[seq[ii] | ((run - 1) << bits)];
+                ii += run;
+            }
+            ret = type.size() <= IR_RAW_MAX_CODE;
+        }
+        if (!ret)
+        {
+            type.clear();
+        }
+    }
+    return ret;
+}
+
+bool IR_RawCode::decode(const std::string &type, IRPulses &pulses)
+{
+    bool ret = false;
+    if (isRaw(type.c_str()))
+    {
+        char *end = nullptr;
+        const char *ptr = type.c_str() + sizeof(IR_RAW_PREFIX) - 1;
+        uint32_t khz = strtoul(ptr, &end, 10);
+        ret = end != ptr && *end == ':' && khz >= 10 && khz <= 100;
+
+        //  Pair table
+        uint32_t marks[MAX_PAIRS];
+        uint32_t spaces[MAX_PAIRS];
+        int npairs = 0;
+        while (ret && (npairs == 0 || *end == ','))
+        {
+            ptr = end + 1;
+            marks[npairs] = strtoul(ptr, &end, 10);
+            ret = end != ptr && *end == '/';
+            if (ret)
+            {
+                ptr = end + 1;
+                spaces[npairs] = strtoul(ptr, &end, 10);
+                ret = end != ptr && (*end == ':' || (*end == ',' && npairs < MAX_PAIRS - 1));
+                ++npairs;
+            }
+        }
+
+        //  Runs
+        ret = ret && *end == ':' && end[1] != 0 && pulses.setCarrier(khz * 1000);
+        int bits = bitsFor(npairs);
+        for (ptr = end + 1; ret && *ptr != 0; ++ptr)
+        {
+            int dig = digit(*ptr);
+            int idx = dig & ((1 << bits) - 1);
+            ret = dig >= 0 && idx < npairs;
+            for (int run = (dig >> bits) + 1; ret && run > 0; run--)
+            {
+                pulses.mark(marks[idx]);
+                pulses.space(spaces[idx]);
+            }
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,91 @@
+//                  *****  IR_RawCode class  *****
+
+#ifndef IR_RAWCODE_H
+#define IR_RAWCODE_H
+
+#include "irpulses.h"
+#include <string>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef IR_RAW_CARRIER
+#define IR_RAW_CARRIER      38              // Carrier for captured codes (kHz)
+#endif
+#ifndef IR_RAW_TOLERANCE
+#define IR_RAW_TOLERANCE    20              // Spread of times quantized to one (%)
+#endif
+#ifndef IR_RAW_SLACK
+#define IR_RAW_SLACK        100             // Spread of short times quantized to one (usec)
+#endif
+#ifndef IR_RAW_MIN_TIMES
+#define IR_RAW_MIN_TIMES    8               // Shortest capture kept as a raw code
+#endif
+#ifndef IR_RAW_MAX_CODE
+#define IR_RAW_MAX_CODE     240             // Longest raw type string
+#endif
+
+#define IR_RAW_PREFIX       "raw:"
+
+/**
+ * @brief   Raw IR code for remotes with no protocol decoder
+ * 
+ * @details A captured code is kept as an action type string
+ * 
+ *              raw:<kHz>:<mark>/<space>,...:<runs>
+ * 
+ *          The captured times are quantized to the centres of clusters no
+ *          wider than IR_RAW_TOLERANCE, and each mark with the space after
+ *          it is one entry in the table of pairs (usec, the final mark has
+ *          a space of 0). The runs are base64url characters, each holding a
+ *          pair number in its low bits and one less than the number of
+ *          times it repeats in the rest, as few low bits as the table
+ *          needs. An NEC frame takes about 60 characters.
+ * 
+ *          Decoding gives the quantized times exactly. The receiver removes
+ *          the carrier, so a captured code is given IR_RAW_CARRIER, which
+ *          may be edited in the type.
+ */
+class IR_RawCode
+{
+public:
+    static const int    MAX_PAIRS = 64;     // Most mark/space pairs in the table
+
+private:
+    static const char   digits_[];          // base64url digits
+
+    static int bitsFor(int count);
+    static int digit(char ch);
+
+public:
+    /**
+     * @brief   Check for a raw type
+     */
+    static bool isRaw(const char *type) { return strncmp(type, IR_RAW_PREFIX, sizeof(IR_RAW_PREFIX) - 1) == 0; }
+
+    /**
+     * @brief   Make a raw type from captured times
+     * 
+     * @param   times   Mark and space times (usec, starting with a mark)
+     * @param   n_times Number of times
+     * @param   type    Receives the type string
+     * 
+     * @return  false if the capture is too short, or needs too many pairs or
+     *          characters
+     */
+    static bool encode(const uint32_t *times, uint32_t n_times, std::string &type);
+
+    /**
+     * @brief   Make the pulse program of a raw type
+     * 
+     * @param   type    Type string
+     * @param   pulses  Program to append to
+     * 
+     * @return  false if the type is not a valid raw code or the program has
+     *          a different carrier
+     */
+    static bool decode(const std::string &type, IRPulses &pulses);
+
+    static bool valid(const std::string &type) { IRPulses pulses; return decode(type, pulses); }
+};
+
+#endif
@@ -0,0 +1,153 @@
+//                  *****  IRSchedule class implementation  *****
+
+#include "irschedule.h"
+#include "irdevice.h"
+#include "irrawcode.h"
+#include "menu.h"
+#include <deque>
+#include <utility>
+
+bool IRSchedule::repeats(const IRPlan::Step &last, const IRPlan::Step &step)
+{
+    const IR_Encoder *enc = IR_Device::encoder(step.proto);
+    return enc != nullptr && last.sameMessage(step) && last.delay < enc->repeatInterval() / 2;
+}
+
+int IRSchedule::build(const IRPlan &plan, int first, int steps_per_send, bool repeated, IRPlan::Step &last, int max_pulses)
+{
+    pulses_.clear();
+    entries_.clear();
+    for (int ii = first; ii < plan.size(); ii++)
+    {
+        const IRPlan::Step &step = plan.step(ii);
+        const IR_Encoder *enc = IR_Device::encoder(step.proto);
+        bool raw = step.proto == IRPlan::STEP_RAW;
+        if (!enc && !raw && step.proto != IRPlan::STEP_NONE)
+        {
+            break;
+        }
+
+        bool repeat = false;
+        frame_.clear();
+        if (enc)
+        {
+            repeat = repeated || (ii % steps_per_send != 0 && repeats(last, step));
+            enc->encode(step.address, step.value, repeat, frame_);
+        }
+        else if (raw && !IR_RawCode::decode(plan.type(step), frame_))
+        {
+            break;
+        }
+        frame_.space(step.delay * 1000);
+
+        uint64_t at = pulses_.duration();
+        if (pulses_.size() + frame_.size() > max_pulses || !pulses_.append(frame_))
+        {
+            break;
+        }
+        entries_.push_back({ii, repeat, at});
+        if (enc || raw)
+        {
+            last = step;
+        }
+    }
+    return entries_.size();
+}
+
+void IRSchedule::timeline(const IRPlan &plan, int steps_per_send, std::vector<uint64_t> &frames)
+{
+    frames.clear();
+    IRPulses frame;
+    IRPlan::Step last = IRPlan::compile("", 0, 0, 0);
+    uint64_t at = 0;
+    for (int ii = 0; ii < plan.size(); ii++)
+    {
+        const IRPlan::Step &step = plan.step(ii);
+        const IR_Encoder *enc = IR_Device::encoder(step.proto);
+        if (enc)
+        {
+            bool repeat = ii % steps_per_send != 0 && repeats(last, step);
+            int nframes = repeat ? 1 : 1 + enc->minimumRepeats();
+            for (int ff = 0; ff < nframes; ff++)
+            {
+                frames.push_back(at);
+                at += enc->repeatInterval() * 1000;
+            }
+            last = step;
+        }
+        else if (step.proto == IRPlan::STEP_RAW)
+        {
+            frame.clear();
+            if (IR_RawCode::decode(plan.type(step), frame))
+            {
+                frames.push_back(at);
+                at += frame.duration();
+                last = step;
+            }
+        }
+        at += step.delay * 1000;
+    }
+}
+
+uint32_t IRSchedule::duration(const IRPlan &plan, int steps_per_send)
+{
+    std::vector<std::pair<const Menu *, Menu::Position>> menus;
+    std::deque<Command::Step> steps;
+    IRPulses frame;
+    IRPlan::Step last = IRPlan::compile("", 0, 0, 0);
+    uint32_t ret = 0;
+    for (int ii = 0; ii < plan.size(); ii++)
+    {
+        const IRPlan::Step &step = plan.step(ii);
+        const IR_Encoder *enc = IR_Device::encoder(step.proto);
+        if (enc)
+        {
+            bool repeat = ii % steps_per_send != 0 && repeats(last, step);
+            ret += enc->messageTime(repeat);
+            last = step;
+        }
+        else if (step.proto == IRPlan::STEP_RAW)
+        {
+            frame.clear();
+            if (IR_RawCode::decode(plan.type(step), frame))
+            {
+                ret += (frame.duration() + 500) / 1000;
+                last = step;
+            }
+        }
+        else if (step.proto == IRPlan::STEP_MENU)
+        {
+            std::string type = plan.type(step);
+            const Menu *menu = Menu::stepMenu(type);
+            int mm = 0;
+            while (menu && mm < menus.size() && menus[mm].first != menu)
+            {
+                ++mm;
+            }
+            if (menu && mm == menus.size())
+            {
+                menus.emplace_back(menu, menu->position());
+            }
+
+            //  As sent, the first step of an expansion is a full message
+            if (menu && menu->getSteps(Command::Step(type, step.address, step.value, step.delay), steps, menus[mm].second))
+            {
+                bool first = true;
+                for (auto it = steps.cbegin(); it != steps.cend(); ++it)
+                {
+                    IRPlan::Step menu_step = IRPlan::compile(it->type().c_str(), it->address(), it->value(), it->delay());
+                    const IR_Encoder *menu_enc = IR_Device::encoder(menu_step.proto);
+                    if (menu_enc)
+                    {
+                        ret += menu_enc->messageTime(!first && repeats(last, menu_step));
+                        last = menu_step;
+                        first = false;
+                    }
+                    ret += menu_step.delay;
+                }
+            }
+        }
+        ret += step.delay;
+    }
+    return ret;
+}
@@ -0,0 +1,93 @@
+//                  *****  IRSchedule class  *****
+
+#ifndef IRSCHEDULE_H
+#define IRSCHEDULE_H
+
+#include "irplan.h"
+#include "irpulses.h"
+#include <vector>
+#include <stdint.h>
+
+/**
+ * @brief   Time-stamped pulse schedule for a run of plan steps
+ * 
+ * @details Consecutive IR and delay steps of a plan are encoded into one
+ *          pulse program, each step's delay a space after its message, so
+ *          the transmitter plays the run, delays included, from its own
+ *          clock. Raw IR steps go as their captured times. A run ends before
+ *          a CEC or menu step, a carrier change or a step that would
+ *          overflow the program.
+ */
+class IRSchedule
+{
+public:
+    struct Entry
+    {
+        int             step;               // Plan step number
+        bool            repeat;             // Sent as a repeat frame
+        uint64_t        at;                 // Planned start (usec from program start)
+    };
+
+private:
+    IRPulses            pulses_;            // Program for the run
+    IRPulses            frame_;             // Step being added
+    std::vector<Entry>  entries_;           // Steps in the run
+
+public:
+    /**
+     * @brief   Check if a step repeats the step before it
+     * 
+     * @details The same message sent again within half the protocol repeat
+     *          interval goes as a repeat frame
+     */
+    static bool repeats(const IRPlan::Step &last, const IRPlan::Step &step);
+
+    /**
+     * @brief   Build the schedule for the run starting at a step
+     * 
+     * @param   plan            Plan
+     * @param   first           First step of the run
+     * @param   steps_per_send  Steps in one send (a merged click starts with
+     *                          a full message)
+     * @param   repeated        Send every IR step as a repeat frame
+     * @param   last            Last step sent, updated to the last IR step
+     *                          of the run
+     * @param   max_pulses      Longest program (marks and spaces)
+     * 
+     * @return  Number of steps in the run (0 if the first cannot be scheduled)
+     */
+    int build(const IRPlan &plan, int first, int steps_per_send, bool repeated, IRPlan::Step &last, int max_pulses);
+
+    const IRPulses &pulses() const { return pulses_; }
+    int size() const { return entries_.size(); }
+    const Entry &entry(int index) const { return entries_[index]; }
+
+    /**
+     * @brief   Get the planned start of every frame of a plan
+     * 
+     * @details As the plan would go out as one program. CEC and menu steps
+     *          take only their delay.
+     * 
+     * @param   plan            Plan
+     * @param   steps_per_send  Steps in one send
+     * @param   frames          Receives the frame starts (usec from the first)
+     */
+    static void timeline(const IRPlan &plan, int steps_per_send, std::vector<uint64_t> &frames);
+
+    /**
+     * @brief   Estimate the time to send a plan
+     * 
+     * @details The protocol frame and raw code times and delays of the
+     *          steps, with menu actions expanded from copies of the menu
+     *          positions, so no menu moves. Call on the web core, which
+     *          owns the menus.
+     * 
+     * @param   plan            Plan
+     * @param   steps_per_send  Steps in one send
+     * 
+     * @return  Time (msec)
+     */
+    static uint32_t duration(const IRPlan &plan, int steps_per_send);
+};
+
+#endif
@@ -0,0 +1,136 @@
+//                  *****  IR_Sniffer class implementation  *****
+
+#include "irsniffer.h"
+#include "irdevice.h"
+#include "irlearner.h"
+#include <pico/time.h>
+#include <time.h>
+
+#define CLOCK_SET_EPOCH     1704067200      // 2024-01-01
+
+IR_Sniffer::IR_Sniffer()
+ : n_times_(0), last_edge_(0), mark_(false), in_frame_(false), last_end_(0), seq_(0)
+{
+    stats_ = {0, 0, 0, 0};
+}
+
+bool IR_Sniffer::edge(uint32_t at, bool mark)
+{
+    bool ret = false;
+    if (in_frame_ && mark != mark_)
+    {
+        uint32_t time = at - last_edge_;
+        if (mark && time >= IR_SNIFF_GAP)
+        {
+            ret = endFrame();
+        }
+        else if (n_times_ < IR_SNIFF_SAMPLES)
+        {
+            times_[n_times_++] = time;
+        }
+        else
+        {
+            ret = endFrame();
+        }
+    }
+    if (!in_frame_ && mark)
+    {
+        in_frame_ = true;
+        n_times_ = 0;
+    }
+    if (mark != mark_ || !in_frame_)
+    {
+        last_edge_ = at;
+        mark_ = mark;
+    }
+    return ret;
+}
+
+bool IR_Sniffer::poll(uint32_t now)
+{
+    bool ret = false;
+    if (in_frame_ && !mark_ && now - last_edge_ >= IR_SNIFF_GAP)
+    {
+        ret = endFrame();
+    }
+    else if (in_frame_ && mark_ && now - last_edge_ >= IR_SNIFF_STUCK)
+    {
+        //  Steady light, not IR
+        in_frame_ = false;
+        ++stats_.noise;
+    }
+    return ret;
+}
+
+bool IR_Sniffer::endFrame()
+{
+    bool ret = true;
+    in_frame_ = false;
+    uint32_t start = last_edge_;
+    for (uint32_t ii = 0; ii < n_times_; ii++)
+    {
+        start -= times_[ii];
+    }
+    bool recent = seq_ > 0 && start - last_end_ < IR_SNIFF_REPEAT_MS * 1000;
+    Frame &last = log_[(seq_ + IR_SNIFF_LOG - 1) % IR_SNIFF_LOG];
+    last_end_ = last_edge_;
+
+    uint32_t n_times = IR_Learner::deglitch(times_, n_times_);
+    if (n_times < IR_LEARN_MIN_TIMES)
+    {
+        //  A leader and stop mark only is a repeat frame (NEC)
+        if (recent && n_times == 3)
+        {
+            ++last.repeats;
+            ++stats_.repeats;
+        }
+        else
+        {
+            ++stats_.noise;
+            ret = false;
+        }
+    }
+    else
+    {
+        const uint32_t *capture = times_;
+        std::string type;
+        uint16_t address = 0;
+        uint16_t value = 0;
+        IR_Device::learn(&capture, &n_times, 1, type, address, value);
+        if (recent && !type.empty() && type == last.type && address == last.address && value == last.value)
+        {
+            ++last.repeats;
+            ++stats_.repeats;
+        }
+        else
+        {
+            Frame &frame = log_[seq_ % IR_SNIFF_LOG];
+            time_t now = time(nullptr);
+            frame.seq = ++seq_;
+            frame.at = to_ms_since_boot(get_absolute_time());
+            frame.time = now > CLOCK_SET_EPOCH ? static_cast<uint32_t>(now) : 0;
+            frame.type = type;
+            frame.address = address;
+            frame.value = value;
+            frame.repeats = 0;
+            frame.times = n_times;
+            ++stats_.frames;
+            if (IR_Device::validProtocol(type))
+            {
+                ++stats_.decoded;
+            }
+        }
+    }
+    return ret;
+}
+
+int IR_Sniffer::frames(std::vector<Frame> &frames) const
+{
+    frames.clear();
+    uint32_t first = seq_ > IR_SNIFF_LOG ? seq_ - IR_SNIFF_LOG : 0;
+    for (uint32_t seq = first; seq < seq_; seq++)
+    {
+        frames.push_back(log_[seq % IR_SNIFF_LOG]);
+    }
+    return frames.size();
+}
@@ -0,0 +1,119 @@
+//                  *****  IR_Sniffer class  *****
+
+#ifndef IR_SNIFFER_H
+#define IR_SNIFFER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#ifndef IR_SNIFF_LOG
+#define IR_SNIFF_LOG        16              // Frames kept
+#endif
+#ifndef IR_SNIFF_SAMPLES
+#define IR_SNIFF_SAMPLES    256             // Longest frame (marks and spaces)
+#endif
+#ifndef IR_SNIFF_GAP
+#define IR_SNIFF_GAP        10000           // Space that ends a frame (usec)
+#endif
+#ifndef IR_SNIFF_STUCK
+#define IR_SNIFF_STUCK      200000          // Mark too long to be IR (usec)
+#endif
+#ifndef IR_SNIFF_REPEAT_MS
+#define IR_SNIFF_REPEAT_MS  200             // Gap within which a frame repeats the last (msec)
+#endif
+#ifndef IR_SNIFF_POLL_MS
+#define IR_SNIFF_POLL_MS    20              // Interval between reads of the edge ring (msec)
+#endif
+
+/**
+ * @brief   Incremental decoder for a stream of receiver edges
+ * 
+ * @details Edges are turned into mark and space times as they arrive. A
+ *          frame ends at a space of IR_SNIFF_GAP, and is then decoded as a
+ *          learn of one capture (see IR_Device::learn). The same code
+ *          again, or a short repeat frame, within IR_SNIFF_REPEAT_MS of the
+ *          frame before counts as a repeat of it. The last IR_SNIFF_LOG
+ *          frames are kept in fixed slots.
+ * 
+ *          Feed and read on one context. The IR core feeds it and passes
+ *          copies of the log to the web core (see IR_Device::takeSniffLog).
+ */
+class IR_Sniffer
+{
+public:
+    struct Frame
+    {
+        uint32_t        seq;                // Frame number (from 1)
+        uint32_t        at;                 // Time received (msec since boot)
+        uint32_t        time;               // Time received (sec since epoch, 0 if clock not set)
+        std::string     type;               // Protocol or raw code (empty if neither)
+        uint16_t        address;            // Address
+        uint16_t        value;              // Value
+        uint16_t        repeats;            // Repeat frames that followed
+        uint16_t        times;              // Marks and spaces in the frame
+    };
+
+    struct Stats
+    {
+        uint32_t        frames;             // Frames logged
+        uint32_t        decoded;            // Frames decoded to a protocol
+        uint32_t        repeats;            // Repeat frames
+        uint32_t        noise;              // Captures dropped as noise
+    };
+
+private:
+    uint32_t            times_[IR_SNIFF_SAMPLES];   // Frame being received
+    uint32_t            n_times_;           // Marks and spaces received
+    uint32_t            last_edge_;         // Time of the last edge (usec)
+    bool                mark_;              // Carrier on since the last edge
+    bool                in_frame_;          // Receiving a frame
+    uint32_t            last_end_;          // End of the last frame (usec)
+    Frame               log_[IR_SNIFF_LOG]; // Frames by seq modulo IR_SNIFF_LOG
+    uint32_t            seq_;               // Last frame number
+    Stats               stats_;             // Statistics
+
+    bool endFrame();
+
+public:
+    IR_Sniffer();
+
+    /**
+     * @brief   Drop a partly received frame
+     * 
+     * @details After edges were not taken for a while
+     */
+    void reset() { in_frame_ = false; }
+
+    /**
+     * @brief   Add a receiver edge
+     * 
+     * @param   at      Time (usec, wraps)
+     * @param   mark    Carrier starts
+     * 
+     * @return  true if the log changed
+     */
+    bool edge(uint32_t at, bool mark);
+
+    /**
+     * @brief   End a frame that has been silent for IR_SNIFF_GAP
+     * 
+     * @param   now     Time (usec, as for edge)
+     * 
+     * @return  true if the log changed
+     */
+    bool poll(uint32_t now);
+
+    /**
+     * @brief   Get the logged frames
+     * 
+     * @param   frames  Receives the frames, oldest first
+     * 
+     * @return  Number of frames
+     */
+    int frames(std::vector<Frame> &frames) const;
+
+    void getStats(Stats &stats) const { stats = stats_; }
+};
+
+#endif
@@ -2,6 +2,9 @@
 
 #include "menu.h"
 #include "txt.h"
+#include "irdevice.h"
+#include "irschedule.h"
+#include "menujournal.h"
 #include <stdio.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -11,8 +14,9 @@
 
 std::map<std::string, Menu *> Menu::menus_;
 
-Menu::Menu() : curcol_(-1), data_(nullptr), datasize_(0)
+Menu::Menu() : wrap_cols_(false), wrap_rows_(false), data_(nullptr), datasize_(0)
 {
+    pos_.col = -1;
     const char *cmds[] = {"open", "up", "down", "left", "right", "ok"};
     for (int ii = 0; ii < 6; ii++)
     {
@@ -20,8 +24,9 @@ Menu::Menu() : curcol_(-1), data_(nullptr), datasize_(0)
     }
 }
 
-Menu::Menu(const std::string &name) : curcol_(-1), data_(nullptr), datasize_(0)
+Menu::Menu(const std::string &name) : wrap_cols_(false), wrap_rows_(false), data_(nullptr), datasize_(0)
 {
+    pos_.col = -1;
     setName(name);
     const char *cmds[] = {"open", "up", "down", "left", "right", "ok"};
     for (int ii = 0; ii < 6; ii++)
@@ -134,6 +139,20 @@ bool Menu::loadJSON(const json_t *json)
 
     if (ret)
     {
+        prop = json_getProperty(json, "wrap");
+        if (prop && json_getType(prop) == JSON_ARRAY)
+        {
+            const json_t *val = json_getChild(prop);
+            if (val)
+            {
+                wrap_cols_ = json_getInteger(val) != 0;
+            }
+            if (val && (val = json_getSibling(val)))
+            {
+                wrap_rows_ = json_getInteger(val) != 0;
+            }
+        }
+
         const char *cmds[] = {"open", "up", "down", "left", "right", "ok"};
         for (int ii = 0; ii < 6; ii++)
         {
@@ -202,7 +221,7 @@ void Menu::outputJSON(std::ostream &strm) const
         strm << sep << *it;
         sep = ", ";
     }
-    strm << "]\n}\n";
+    strm << "],\n\"wrap\": [" << (wrap_cols_ ? 1 : 0) << ", " << (wrap_rows_ ? 1 : 0) << "]\n}\n";
 }
 
 bool Menu::saveFile() const
@@ -253,6 +272,10 @@ Menu *Menu::getMenu(const std::string &name)
                 menus_.erase(name);
                 printf("'%s' is not a menu\n", name.c_str());
             }
+            else
+            {
+                MenuJournal::get()->restore(ret->name_, ret->geometry(), ret->pos_);
+            }
         }
     }
     return ret;
@@ -282,6 +305,7 @@ bool Menu::deleteMenu(const char *name)
         delete it->second;
         menus_.erase(name);
     }
+    MenuJournal::get()->clear(name);
     return ret;
 }
 
@@ -327,6 +351,7 @@ bool Menu::rename(const std::string &name)
         {
             std::string oldfile = menuFile(name_);
             ::rename(oldfile.c_str(), newfile.c_str());
+            MenuJournal::get()->clear(name_);
         }
         setName(newname);
     }
@@ -385,7 +410,67 @@ bool Menu::setRowsPerColumn(const std::string &rowspercol)
     return ret;
 }
 
+void Menu::setWrap(bool cols, bool rows)
+{
+    if (cols != wrap_cols_ || rows != wrap_rows_)
+    {
+        wrap_cols_ = cols;
+        wrap_rows_ = rows;
+        reset();
+    }
+}
+
+uint32_t Menu::moveTime(const std::string &op, int count) const
+{
+    uint32_t ret = 0;
+    if (count > 0)
+    {
+        const auto it = commands_.find(op);
+        if (it != commands_.cend() && !it->second.type().empty())
+        {
+            const Command::Step &cmd = it->second;
+            IRPlan::Step step = IRPlan::compile(cmd.type().c_str(), cmd.address(), cmd.value(), cmd.delay());
+            const IR_Encoder *enc = IR_Device::encoder(step.proto);
+            uint32_t first = cmd.delay() + (enc ? enc->messageTime(false) : 0);
+            uint32_t next = cmd.delay() + (enc ? enc->messageTime(IRSchedule::repeats(step, step)) : 0);
+            ret = first + (count - 1) * next;
+        }
+        else
+        {
+            ret = 1000000;
+        }
+    }
+    return ret;
+}
+
+uint32_t Menu::geometry() const
+{
+    uint32_t ret = 2166136261u;
+    for (auto it = rows_.cbegin(); it != rows_.cend(); ++it)
+    {
+        ret = (ret ^ *it) * 16777619u;
+    }
+    ret = (ret ^ (wrap_cols_ ? 1 : 0) ^ (wrap_rows_ ? 2 : 0)) * 16777619u;
+    return ret;
+}
+
+void Menu::forget()
+{
+    reset();
+    MenuJournal::get()->clear(name_);
+}
+
 bool Menu::getSteps(const Command::Step &step, std::deque<Command::Step> &steps)
+{
+    bool ret = getSteps(step, steps, pos_);
+    if (ret)
+    {
+        MenuJournal::get()->record(name_, geometry(), pos_);
+    }
+    return ret;
+}
+
+bool Menu::getSteps(const Command::Step &step, std::deque<Command::Step> &steps, Position &pos) const
 {
     bool ret = false;
     steps.clear();
@@ -418,27 +503,27 @@ bool Menu::getSteps(const Command::Step &step, std::deque<Command::Step> &steps)
 
         if (func == "set")
         {
-            ret = set_pos(opt, p1, p2, steps);
+            ret = set_pos(opt, p1, p2, steps, pos);
         }
         else if (func == "move")
         {
-            ret = move_pos(p1, p2, steps);
+            ret = move_pos(p1, p2, steps, pos);
         }
         else if (func == "up")
         {
-            ret = move_pos(0, -1, steps);
+            ret = move_pos(0, -1, steps, pos);
         }
         else if (func == "down")
         {
-            ret = move_pos(0, 1, steps);
+            ret = move_pos(0, 1, steps, pos);
         }
         else if (func == "left")
         {
-            ret = move_pos(-1, 0, steps);
+            ret = move_pos(-1, 0, steps, pos);
         }
         else if (func == "right")
         {
-            ret = move_pos(1, 0, steps);
+            ret = move_pos(1, 0, steps, pos);
         }
         else if (func == "ok")
         {
@@ -446,7 +531,7 @@ bool Menu::getSteps(const Command::Step &step, std::deque<Command::Step> &steps)
         }
         else if (func == "clear")
         {
-            reset();
+            resetPosition(pos);
             ret = true;
         }
     }
@@ -456,10 +541,7 @@ bool Menu::getSteps(const Command::Step &step, std::deque<Command::Step> &steps)
 bool Menu::getMenuSteps(const Command::Step &step, std::deque<Command::Step> &steps)
 {
     bool ret = false;
-    std::size_t i1 = step.type().find_first_of(".(");
-    std::string name = step.type().substr(0, i1);
-
-    Menu *menu = getMenu(name);
+    Menu *menu = stepMenu(step.type());
     if (menu)
     {
         ret = menu->getSteps(step, steps);
@@ -468,7 +550,12 @@ bool Menu::getMenuSteps(const Command::Step &step, std::deque<Command::Step> &st
     return ret;
 }
 
-bool Menu::set_pos(const std::string &opt, int col, int row, std::deque<Command::Step> &steps)
+Menu *Menu::stepMenu(const std::string &type)
+{
+    return getMenu(type.substr(0, type.find_first_of(".(")));
+}
+
+bool Menu::set_pos(const std::string &opt, int col, int row, std::deque<Command::Step> &steps, Position &pos) const
 {
     col -= 1;
     row -= 1;
@@ -482,48 +569,19 @@ bool Menu::set_pos(const std::string &opt, int col, int row, std::deque<Command:
             add_step("open", steps);
         }
 
-        if (curcol_ == -1)
+        Move moves[4];
+        int nm = plan_axis(pos.col, col, colcount, wrap_cols_, "left", "right", moves);
+        nm += plan_axis(pos.colrow.at(col), row, rows_.at(col), wrap_rows_, "up", "down", moves + nm);
+        for (int ii = 0; ii < nm; ii++)
         {
-            int mid = colcount / 2;
-            if (col < mid)
-            {
-                move_pos(-(colcount - 1), 0, steps);
-                move_pos(col, 0, steps);
-            }
-            else
-            {
-                move_pos(colcount - 1, 0, steps);
-                move_pos(-(colcount - col - 1), 0, steps);
-            }
-        }
-        else
-        {
-            move_pos(col - curcol_, 0, steps);
-        }
-
-        int rowcount = rows_.at(col);
-        int currow = colrow_.at(col);
-        if (currow == -1)
-        {
-            int mid = rowcount / 2;
-            if (row < mid)
-            {
-                move_pos(0, -(rowcount - 1), steps);
-                move_pos(0, row, steps);
-            }
-            else
+            for (int jj = 0; jj < moves[ii].count; jj++)
             {
-                move_pos(0, rowcount - 1, steps);
-                move_pos(0, -(rowcount - row - 1), steps);
+                add_step(moves[ii].op, steps);
             }
         }
-        else
-        {
-            move_pos(0, row - currow, steps);
-        }
 
-        curcol_ = col;
-        colrow_[col] = row;
+        pos.col = col;
+        pos.colrow[col] = row;
         
         if (opt.find("-ok") == std::string::npos)
         {
@@ -533,16 +591,16 @@ bool Menu::set_pos(const std::string &opt, int col, int row, std::deque<Command:
     return ret;
 }
 
-bool Menu::move_pos(int cols, int rows, std::deque<Command::Step> &steps)
+bool Menu::move_pos(int cols, int rows, std::deque<Command::Step> &steps, Position &pos) const
 {
     int colcount = rows_.size();
     bool ret = abs(cols) < colcount;
     if (ret)
     {
         int rowcount = 0;
-        if (curcol_ != -1)
+        if (pos.col != -1)
         {
-            rowcount = rows_.at(curcol_);
+            rowcount = rows_.at(pos.col);
         }
         else
         {
@@ -568,9 +626,9 @@ bool Menu::move_pos(int cols, int rows, std::deque<Command::Step> &steps)
             {
                 add_step(op, steps);
             }
-            if (curcol_ != -1)
+            if (pos.col != -1)
             {
-                curcol_ += cols;
+                pos.col = step_pos(pos.col, cols, colcount, wrap_cols_);
             }
 
             op = "down";
@@ -583,9 +641,9 @@ bool Menu::move_pos(int cols, int rows, std::deque<Command::Step> &steps)
             {
                 add_step(op, steps);
             }
-            if (curcol_ != -1 && colrow_.at(curcol_) != -1)
+            if (pos.col != -1 && pos.colrow.at(pos.col) != -1)
             {
-                colrow_[curcol_] += rows;
+                pos.colrow[pos.col] = step_pos(pos.colrow[pos.col], rows, rows_.at(pos.col), wrap_rows_);
             }
         }
     }
@@ -593,7 +651,67 @@ bool Menu::move_pos(int cols, int rows, std::deque<Command::Step> &steps)
     return ret;
 }
 
-void Menu::add_step(const std::string &op, std::deque<Command::Step> &steps)
+int Menu::plan_axis(int from, int to, int count, bool wrap, const char *dec, const char *inc, Move moves[2]) const
+{
+    int ret = 1;
+    if (from == -1 && wrap)
+    {
+        from = 0;
+    }
+
+    if (from == -1)
+    {
+        //  Drive into an edge to find the position, then back to the target
+        ret = 2;
+        if (moveTime(dec, count - 1) + moveTime(inc, to) <= moveTime(inc, count - 1) + moveTime(dec, count - 1 - to))
+        {
+            moves[0] = {dec, count - 1};
+            moves[1] = {inc, to};
+        }
+        else
+        {
+            moves[0] = {inc, count - 1};
+            moves[1] = {dec, count - 1 - to};
+        }
+    }
+    else if (to >= from)
+    {
+        moves[0] = {inc, to - from};
+        if (wrap && moveTime(dec, count - (to - from)) < moveTime(inc, to - from))
+        {
+            moves[0] = {dec, count - (to - from)};
+        }
+    }
+    else
+    {
+        moves[0] = {dec, from - to};
+        if (wrap && moveTime(inc, count - (from - to)) < moveTime(dec, from - to))
+        {
+            moves[0] = {inc, count - (from - to)};
+        }
+    }
+    return ret;
+}
+
+int Menu::step_pos(int at, int delta, int count, bool wrap)
+{
+    int ret = at + delta;
+    if (wrap)
+    {
+        ret = ((ret % count) + count) % count;
+    }
+    else if (ret < 0)
+    {
+        ret = 0;
+    }
+    else if (ret >= count)
+    {
+        ret = count - 1;
+    }
+    return ret;
+}
+
+void Menu::add_step(const std::string &op, std::deque<Command::Step> &steps) const
 {
     const auto it = commands_.find(op);
     if (it != commands_.cend() && !it->second.type().empty())
@@ -14,12 +14,26 @@
 
 class Menu
 {
+public:
+    struct Position
+    {
+        int                 col;                    // Current column (-1 if not known)
+        std::vector<int>    colrow;                 // Current row by column (-1 if not known)
+    };
+
+    struct Move
+    {
+        const char          *op;                    // Operation (up, down, left, right)
+        int                 count;                  // Times to send it
+    };
+
 private:
     std::string             name_;                  // Menu name
     std::map<std::string, Command::Step> commands_; // Commands (open, up, down, left, right, ok)
     std::vector<int>        rows_;                  // Rows per column
-    std::vector<int>        colrow_;                // Current row by column
-    int                     curcol_;                // Current column
+    bool                    wrap_cols_;             // Moving off the last column wraps to the first
+    bool                    wrap_rows_;             // Moving off the last row wraps to the first
+    Position                pos_;                   // Current position
 
     std::string             filename_;              // Filename
     char                    *data_;                 // File data
@@ -28,9 +42,11 @@ private:
     bool load();
     bool loadJSON(const json_t *json);
 
-    bool set_pos(const std::string &opt, int col, int row, std::deque<Command::Step> &steps);
-    bool move_pos(int cols, int rows, std::deque<Command::Step> &steps);
-    void add_step(const std::string &op, std::deque<Command::Step> &steps);
+    bool set_pos(const std::string &opt, int col, int row, std::deque<Command::Step> &steps, Position &pos) const;
+    bool move_pos(int cols, int rows, std::deque<Command::Step> &steps, Position &pos) const;
+    void add_step(const std::string &op, std::deque<Command::Step> &steps) const;
+    int plan_axis(int from, int to, int count, bool wrap, const char *dec, const char *inc, Move moves[2]) const;
+    static int step_pos(int at, int delta, int count, bool wrap);
 
     static std::map<std::string, Menu *> menus_;    // Map of known menus
 
@@ -48,7 +64,7 @@ public:
     bool loadJSON(const json_t *json, const char *filename);
     void outputJSON(std::ostream &strm) const;
     bool saveFile() const;
-    void clear() { name_.clear(), commands_.clear(); rows_.clear(), colrow_.clear(); }
+    void clear() { name_.clear(), commands_.clear(); rows_.clear(), wrap_cols_ = wrap_rows_ = false; pos_.colrow.clear(); }
 
     const std::string &name() const { return name_; }
     bool rename(const std::string &name);
@@ -114,9 +130,43 @@ public:
      */
     bool setRowsPerColumn(const std::string &rowspercol);
 
+    bool wrapColumns() const { return wrap_cols_; }
+    bool wrapRows() const { return wrap_rows_; }
+
+    /**
+     * @brief   Set whether the on-screen menu wraps around
+     * 
+     * @details A wrapping axis can be crossed either way, and is taken to
+     *          open at its first entry when the position is not known, as
+     *          it cannot be found by driving into an edge
+     * 
+     * @param   cols    Moving off the last column wraps to the first
+     * @param   rows    Moving off the last row wraps to the first
+     */
+    void setWrap(bool cols, bool rows);
+
+    /**
+     * @brief   Get the time to send an operation a number of times
+     * 
+     * @details The first message, then repeat frames where the operation's
+     *          delay allows, each followed by the operation's delay.
+     *          Operations with no IR code cost more than any move so the
+     *          planner avoids them.
+     * 
+     * @param   op      Operation (up, down, left, right)
+     * @param   count   Times to send it
+     * 
+     * @return  Time (msec)
+     */
+    uint32_t moveTime(const std::string &op, int count) const;
+
     /**
      * @brief   Get the steps for a menu action
      * 
+     * @details A set action takes the quickest path by moveTime: either
+     *          way round a wrapping axis, and from an unknown position into
+     *          whichever edge makes the trip back cheapest
+     * 
      * @param   step    Step containing menu call
      * @param   steps   deque to receive steps to accomplish menu action
      * 
@@ -125,10 +175,51 @@ public:
     bool getSteps(const Command::Step &step, std::deque<Command::Step> &steps);
     static bool getMenuSteps(const Command::Step &step, std::deque<Command::Step> &steps);
 
+    /**
+     * @brief   Get the steps for a menu action from a given position
+     * 
+     * @details Leaves the menu's own position alone, so a sequence of
+     *          actions can be planned or timed without sending them
+     * 
+     * @param   step    Step containing menu call
+     * @param   steps   deque to receive steps to accomplish menu action
+     * @param   pos     Position to start from, updated to the end position
+     * 
+     * @return  true if steps filled successfully
+     */
+    bool getSteps(const Command::Step &step, std::deque<Command::Step> &steps, Position &pos) const;
+
+    /**
+     * @brief   Get the menu a menu action is for
+     * 
+     * @param   type    Step type (menu[.func][(opt)])
+     * 
+     * @return  Pointer to menu or null if not a menu
+     */
+    static Menu *stepMenu(const std::string &type);
+
+    const Position &position() const { return pos_; }
+
+    /**
+     * @brief   Get a value that changes with the menu's shape
+     * 
+     * @details From the rows per column and the wrap settings, so a
+     *          journaled position is not used for a menu since reshaped
+     */
+    uint32_t geometry() const;
+
     /**
      * @brief   Reset the position of the menu
      */
-    void reset() { curcol_ = -1; colrow_.assign(rows_.size(), -1); }
+    void reset() { resetPosition(pos_); }
+
+    /**
+     * @brief   Reset the position and forget it in the journal
+     * 
+     * @details For when the menu is known to have been moved by other means
+     */
+    void forget();
+    void resetPosition(Position &pos) const { pos.col = -1; pos.colrow.assign(rows_.size(), -1); }
 
     /**
      * @brief   Enumerate the menu files
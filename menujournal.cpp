@@ -0,0 +1,268 @@
+//                  *****  MenuJournal class implementation  *****
+
+#include "menujournal.h"
+#include <pico/time.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+//  Times before this are from a clock not yet set by NTP
+#define CLOCK_SET_EPOCH     1704067200      // 2024-01-01
+
+MenuJournal::MenuJournal() : tick_(0), dirty_(false)
+{
+    memset(slots_, 0, sizeof(slots_));
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+uint32_t MenuJournal::clockTime()
+{
+    time_t now = time(nullptr);
+    return now > CLOCK_SET_EPOCH ? static_cast<uint32_t>(now) : 0;
+}
+
+uint32_t MenuJournal::upTime()
+{
+    return to_ms_since_boot(get_absolute_time()) / 1000 + 1;
+}
+
+uint32_t MenuJournal::checksum(const Record &rec)
+{
+    //  FNV-1a over the record after the check sum
+    uint32_t ret = 2166136261u;
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(&rec);
+    for (size_t ii = sizeof(rec.check); ii < sizeof(rec); ii++)
+    {
+        ret = (ret ^ data[ii]) * 16777619u;
+    }
+    return ret;
+}
+
+int MenuJournal::find(const std::string &name) const
+{
+    int ret = -1;
+    for (int ii = 0; ii < MENU_JOURNAL_SLOTS && ret < 0; ii++)
+    {
+        if (slots_[ii].used != 0 && name == slots_[ii].rec.name)
+        {
+            ret = ii;
+        }
+    }
+    return ret;
+}
+
+int MenuJournal::slot(const std::string &name)
+{
+    int ret = find(name);
+    if (ret < 0)
+    {
+        //  Free slot, else the least recently used
+        ret = 0;
+        for (int ii = 1; ii < MENU_JOURNAL_SLOTS && slots_[ret].used != 0; ii++)
+        {
+            if (slots_[ii].used < slots_[ret].used)
+            {
+                ret = ii;
+            }
+        }
+        memset(&slots_[ret], 0, sizeof(slots_[ret]));
+        strncpy(slots_[ret].rec.name, name.c_str(), MAX_NAME - 1);
+    }
+    slots_[ret].used = ++tick_;
+    return ret;
+}
+
+bool MenuJournal::load()
+{
+    bool ret = false;
+    FILE *f = fopen(MENU_JOURNAL_FILE, "r");
+    if (f)
+    {
+        ret = true;
+        Record rec;
+        stats_.records = 0;
+        while (fread(&rec, sizeof(rec), 1, f) == 1)
+        {
+            ++stats_.records;
+            if (rec.check == checksum(rec) && rec.name[MAX_NAME - 1] == 0)
+            {
+                Slot &sl = slots_[slot(rec.name)];
+                sl.rec = rec;
+                sl.uptime = 0;
+                sl.dirty = false;
+            }
+        }
+        fclose(f);
+    }
+    return ret;
+}
+
+bool MenuJournal::compact()
+{
+    bool ret = false;
+    FILE *f = fopen(MENU_JOURNAL_FILE, "w");
+    if (f)
+    {
+        ret = true;
+        stats_.records = 0;
+        for (int ii = 0; ii < MENU_JOURNAL_SLOTS; ii++)
+        {
+            if (slots_[ii].used != 0)
+            {
+                slots_[ii].rec.check = checksum(slots_[ii].rec);
+                ret = fwrite(&slots_[ii].rec, sizeof(Record), 1, f) == 1 && ret;
+                ++stats_.records;
+                stats_.writes += slots_[ii].dirty ? 1 : 0;
+            }
+        }
+        ret = fclose(f) == 0 && ret;
+    }
+    return ret;
+}
+
+bool MenuJournal::flush()
+{
+    bool ret = true;
+    if (dirty_)
+    {
+        int count = 0;
+        for (int ii = 0; ii < MENU_JOURNAL_SLOTS; ii++)
+        {
+            count += slots_[ii].dirty ? 1 : 0;
+        }
+
+        if (stats_.records + count > 4 * MENU_JOURNAL_SLOTS)
+        {
+            ret = compact();
+        }
+        else
+        {
+            FILE *f = fopen(MENU_JOURNAL_FILE, "a");
+            ret = f != nullptr;
+            for (int ii = 0; ii < MENU_JOURNAL_SLOTS && ret; ii++)
+            {
+                if (slots_[ii].dirty)
+                {
+                    slots_[ii].rec.check = checksum(slots_[ii].rec);
+                    ret = fwrite(&slots_[ii].rec, sizeof(Record), 1, f) == 1;
+                    ++stats_.records;
+                    ++stats_.writes;
+                }
+            }
+            if (f)
+            {
+                ret = fclose(f) == 0 && ret;
+            }
+        }
+
+        if (ret)
+        {
+            for (int ii = 0; ii < MENU_JOURNAL_SLOTS; ii++)
+            {
+                slots_[ii].dirty = false;
+            }
+            dirty_ = false;
+        }
+        else
+        {
+            printf("Failed to write %s\n", MENU_JOURNAL_FILE);
+        }
+    }
+    return ret;
+}
+
+void MenuJournal::record(const std::string &name, uint32_t geometry, const Menu::Position &pos)
+{
+    if (name.length() >= MAX_NAME || pos.colrow.size() > MAX_COLS)
+    {
+        return;
+    }
+
+    Record rec;
+    memset(&rec, 0, sizeof(rec));
+    strncpy(rec.name, name.c_str(), MAX_NAME - 1);
+    rec.geometry = geometry;
+    rec.col = pos.col;
+    memset(rec.colrow, -1, sizeof(rec.colrow));
+    for (size_t ii = 0; ii < pos.colrow.size(); ii++)
+    {
+        rec.colrow[ii] = pos.colrow[ii] < 128 ? pos.colrow[ii] : -1;
+    }
+    rec.time = clockTime();
+
+    //  An unchanged position is written again only to keep it from expiring
+    Slot &sl = slots_[slot(name)];
+    bool changed = rec.geometry != sl.rec.geometry || rec.col != sl.rec.col ||
+                   memcmp(rec.colrow, sl.rec.colrow, sizeof(rec.colrow)) != 0;
+    bool stale = rec.time != 0 && (sl.rec.time == 0 || rec.time - sl.rec.time > MENU_JOURNAL_VALID_S / 2);
+    sl.rec = rec;
+    sl.uptime = upTime();
+    if (changed || stale)
+    {
+        sl.dirty = true;
+        dirty_ = true;
+    }
+}
+
+bool MenuJournal::restore(const std::string &name, uint32_t geometry, Menu::Position &pos)
+{
+    bool ret = false;
+    int ss = find(name);
+    if (ss >= 0 && slots_[ss].rec.geometry == geometry && slots_[ss].rec.col >= 0)
+    {
+        const Slot &sl = slots_[ss];
+        bool fresh = false;
+        if (sl.uptime != 0)
+        {
+            fresh = upTime() - sl.uptime < MENU_JOURNAL_VALID_S;
+        }
+        else
+        {
+            uint32_t now = clockTime();
+            fresh = now != 0 && sl.rec.time != 0 && now >= sl.rec.time && now - sl.rec.time < MENU_JOURNAL_VALID_S;
+        }
+
+        if (fresh)
+        {
+            pos.col = sl.rec.col;
+            for (size_t ii = 0; ii < pos.colrow.size() && ii < MAX_COLS; ii++)
+            {
+                pos.colrow[ii] = sl.rec.colrow[ii];
+            }
+            ++stats_.restored;
+            ret = true;
+        }
+        else
+        {
+            ++stats_.expired;
+        }
+    }
+    return ret;
+}
+
+void MenuJournal::clear(const std::string &name)
+{
+    int ss = find(name);
+    if (ss >= 0)
+    {
+        Record &rec = slots_[ss].rec;
+        rec.col = -1;
+        memset(rec.colrow, -1, sizeof(rec.colrow));
+        rec.time = clockTime();
+        slots_[ss].dirty = true;
+        dirty_ = true;
+    }
+}
+
+void MenuJournal::getStats(Stats &stats) const
+{
+    stats = stats_;
+    stats.menus = 0;
+    for (int ii = 0; ii < MENU_JOURNAL_SLOTS; ii++)
+    {
+        if (slots_[ii].used != 0 && slots_[ii].rec.col >= 0)
+        {
+            ++stats.menus;
+        }
+    }
+}
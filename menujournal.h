@@ -0,0 +1,137 @@
+//                  *****  MenuJournal class  *****
+
+#ifndef MENUJOURNAL_H
+#define MENUJOURNAL_H
+
+#include "menu.h"
+#include <string>
+#include <stdint.h>
+
+#ifndef MENU_JOURNAL_SLOTS
+#define MENU_JOURNAL_SLOTS      16          // Menus whose position is kept
+#endif
+#ifndef MENU_JOURNAL_VALID_S
+#define MENU_JOURNAL_VALID_S    (4 * 3600)  // Age after which a position is not trusted (sec)
+#endif
+#ifndef MENU_JOURNAL_FLUSH_MS
+#define MENU_JOURNAL_FLUSH_MS   5000        // Interval between journal writes (msec)
+#endif
+
+#define MENU_JOURNAL_FILE       "menupos.jnl"
+
+/**
+ * @brief   Journal of the last known menu cursor positions
+ * 
+ * @details Keeps the position of each menu in a fixed slot and appends the
+ *          slots that changed to a flash file of fixed size records, so a
+ *          menu loaded after a reboot can move from where it was left
+ *          rather than driving into an edge. The file is rewritten with
+ *          only the live records when it grows past four times the slots.
+ * 
+ *          A position is restored only if it was written for the same menu
+ *          shape within MENU_JOURNAL_VALID_S, as the menu may have been
+ *          moved with the TV's own remote since. After a reboot that needs
+ *          the clock set by NTP.
+ * 
+ *          Positions are recorded as the web core expands menu actions for
+ *          the IR core, and written by flush on the web core.
+ */
+class MenuJournal
+{
+public:
+    static const int    MAX_NAME = 20;      // Longest menu name kept (with terminator)
+    static const int    MAX_COLS = 15;      // Most columns kept
+
+    struct Stats
+    {
+        int             menus;              // Positions held
+        uint32_t        records;            // Records in the file
+        uint32_t        writes;             // Records written
+        uint32_t        restored;           // Positions restored
+        uint32_t        expired;            // Positions too old to restore
+    };
+
+private:
+    struct Record
+    {
+        uint32_t        check;              // Check sum of the rest of the record
+        uint32_t        time;               // Time written (sec since epoch, 0 if clock not set)
+        uint32_t        geometry;           // Menu shape (see Menu::geometry)
+        char            name[MAX_NAME];     // Menu name
+        int8_t          col;                // Current column (-1 if not known)
+        int8_t          colrow[MAX_COLS];   // Current row by column (-1 if not known)
+    };
+
+    struct Slot
+    {
+        Record          rec;                // Position
+        uint32_t        uptime;             // Time recorded (sec since boot, 0 if from file)
+        uint32_t        used;               // Last use tick (0 if free)
+        bool            dirty;              // Not yet written
+    };
+
+    Slot                slots_[MENU_JOURNAL_SLOTS]; // Menu positions
+    uint32_t            tick_;              // Use counter
+    bool                dirty_;             // A slot is not yet written
+    Stats               stats_;             // Statistics
+
+    MenuJournal();
+
+    int find(const std::string &name) const;
+    int slot(const std::string &name);
+    static uint32_t checksum(const Record &rec);
+    static uint32_t clockTime();
+    static uint32_t upTime();
+    bool compact();
+
+public:
+    static MenuJournal *get() { static MenuJournal *singleton = nullptr; if (!singleton) singleton = new MenuJournal(); return singleton; }
+
+    /**
+     * @brief   Read the journal file
+     * 
+     * @details Later records replace earlier ones for the same menu.
+     *          Records that fail their check are skipped.
+     * 
+     * @return  true if the file was read
+     */
+    bool load();
+
+    /**
+     * @brief   Write the positions that changed since the last flush
+     * 
+     * @return  true if there was nothing to write or it was written
+     */
+    bool flush();
+
+    /**
+     * @brief   Record a menu position
+     * 
+     * @param   name        Menu name
+     * @param   geometry    Menu shape
+     * @param   pos         Position
+     */
+    void record(const std::string &name, uint32_t geometry, const Menu::Position &pos);
+
+    /**
+     * @brief   Get a menu's last known position
+     * 
+     * @param   name        Menu name
+     * @param   geometry    Menu shape (a position for another shape is not used)
+     * @param   pos         Receives the position if found, valid and not too old
+     * 
+     * @return  true if pos set
+     */
+    bool restore(const std::string &name, uint32_t geometry, Menu::Position &pos);
+
+    /**
+     * @brief   Forget a menu's position
+     * 
+     * @param   name        Menu name
+     */
+    void clear(const std::string &name);
+
+    void getStats(Stats &stats) const;
+};
+
+#endif
@@ -0,0 +1,120 @@
+//                  *****  PageTemplate class implementation  *****
+
+#include "pagetemplate.h"
+#include "web_files.h"
+#include <string.h>
+#include <strings.h>
+
+std::map<std::string, PageTemplate *> PageTemplate::templates_;
+
+const PageTemplate *PageTemplate::get(const char *name)
+{
+    PageTemplate *ret = nullptr;
+    auto it = templates_.find(name);
+    if (it != templates_.end())
+    {
+        ret = it->second;
+    }
+    else
+    {
+        const char *data;
+        u16_t datalen;
+        if (WEB_FILES::get()->get_file(name, data, datalen))
+        {
+            ret = new PageTemplate();
+            if (ret->parse(data, datalen))
+            {
+                templates_[name] = ret;
+            }
+            else
+            {
+                delete ret;
+                ret = nullptr;
+            }
+        }
+    }
+    return ret;
+}
+
+bool PageTemplate::parse(const char *data, size_t datalen)
+{
+    bool ret = false;
+    const char *end = data + datalen;
+    const char *body = nullptr;
+    for (const char *ptr = data; ptr + 4 <= end; ptr++)
+    {
+        if (memcmp(ptr, "\r\n\r\n", 4) == 0)
+        {
+            body = ptr + 4;
+            break;
+        }
+    }
+
+    if (body != nullptr)
+    {
+        //  Keep the header lines except Content-Length, which depends on the render
+        const char *line = data;
+        while (line < body - 2)
+        {
+            const char *eol = line;
+            while (eol < body - 2 && !(eol[0] == '\r' && eol[1] == '\n')) eol++;
+            if (strncasecmp(line, "Content-Length:", 15) != 0)
+            {
+                if (!header_.empty()) header_ += "\r\n";
+                header_.append(line, eol - line);
+            }
+            line = eol + 2;
+        }
+
+        const char *text = body;
+        const char *ptr = body;
+        while (ptr + 4 <= end)
+        {
+            const char *tag_end = nullptr;
+            if (ptr[0] == '<' && ptr[1] == '?')
+            {
+                for (const char *tp = ptr + 2; tp + 2 <= end && *tp != '<' && *tp != '\n'; tp++)
+                {
+                    if (tp[0] == '?' && tp[1] == '>')
+                    {
+                        tag_end = tp;
+                        break;
+                    }
+                }
+            }
+            if (tag_end != nullptr)
+            {
+                segments_.push_back(Segment{text, static_cast<size_t>(ptr - text), std::string(ptr + 2, tag_end - ptr - 2)});
+                literal_ += ptr - text;
+                ptr = text = tag_end + 2;
+            }
+            else
+            {
+                ptr++;
+            }
+        }
+        segments_.push_back(Segment{text, static_cast<size_t>(end - text), std::string()});
+        literal_ += end - text;
+        ret = true;
+    }
+    return ret;
+}
+
+void PageTemplate::render(PageWriter &out, const Filler &fill) const
+{
+    for (auto it = segments_.cbegin(); it != segments_.cend(); ++it)
+    {
+        out.write(it->text, it->len);
+        if (!it->tag.empty())
+        {
+            fill(it->tag, out);
+        }
+    }
+}
+
+bool PageTemplate::send(WEB *web, ClientHandle client, const Filler &fill) const
+{
+    PageWriter out(web, client, header_);
+    render(out, fill);
+    return out.end();
+}
@@ -0,0 +1,83 @@
+//                  *****  PageTemplate class  *****
+
+#ifndef PAGETEMPLATE_H
+#define PAGETEMPLATE_H
+
+#include "web.h"
+#include "pagewriter.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <stddef.h>
+
+/**
+ * @brief   Preparsed HTML template
+ * 
+ * @details A WEB_FILES template is split once into literal text and <?tag?>
+ *          placeholders. Rendering walks the segments forward, copying the
+ *          literals straight from the resource data and asking the filler
+ *          to write each placeholder.
+ */
+class PageTemplate
+{
+public:
+    /**
+     * @brief   Placeholder callback
+     * 
+     * @param   tag     Placeholder name without <? and ?>
+     * @param   out     Output for the placeholder text
+     */
+    typedef std::function<void(const std::string &tag, PageWriter &out)> Filler;
+
+private:
+    struct Segment
+    {
+        const char      *text;              // Literal text (in the resource data)
+        size_t          len;                // Literal length
+        std::string     tag;                // Placeholder following the literal (empty if none)
+    };
+
+    std::vector<Segment>    segments_;      // Template segments
+    std::string             header_;        // HTTP header without Content-Length
+    size_t                  literal_;       // Total literal length
+
+    static std::map<std::string, PageTemplate *> templates_;   // Parsed templates
+
+    PageTemplate() : literal_(0) {}
+    bool parse(const char *data, size_t datalen);
+
+public:
+    /**
+     * @brief   Get a parsed template
+     * 
+     * @param   name    WEB_FILES resource name
+     * 
+     * @return  Template or nullptr if the resource does not exist
+     */
+    static const PageTemplate *get(const char *name);
+
+    const std::string &header() const { return header_; }
+    size_t literalSize() const { return literal_; }
+
+    /**
+     * @brief   Render the page body
+     * 
+     * @param   out     Output
+     * @param   fill    Placeholder callback
+     */
+    void render(PageWriter &out, const Filler &fill) const;
+
+    /**
+     * @brief   Render the page and stream the response
+     * 
+     * @param   web     WEB object
+     * @param   client  Client handle
+     * @param   fill    Placeholder callback
+     * 
+     * @return  true if successful
+     */
+    bool send(WEB *web, ClientHandle client, const Filler &fill) const;
+};
+
+#endif
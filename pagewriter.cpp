@@ -0,0 +1,148 @@
+//                  *****  PageWriter class implementation  *****
+
+#include "pagewriter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  A streaming window has room before the data for the chunk size line
+//  and after it for the closing CRLF so each chunk is a single send
+#define CHUNK_PREFIX    8                   // Hex size (up to 6 digits) + CRLF
+#define CHUNK_SUFFIX    2                   // CRLF
+
+PageWriter::PageWriter(WEB *web, ClientHandle client, const std::string &header, std::string *copy, size_t limit)
+    : data_(nullptr), len_(0), web_(web), client_(client), header_(&header), chunked_(false), ok_(true),
+      copy_(copy), copy_limit_(limit)
+{
+    data_ = static_cast<char *>(malloc(CHUNK_PREFIX + PAGE_WINDOW + CHUNK_SUFFIX));
+    ok_ = data_ != nullptr;
+    if (copy_)
+    {
+        copy_->clear();
+    }
+}
+
+PageWriter::~PageWriter()
+{
+    free(data_);
+}
+
+void PageWriter::keep(const char *data, size_t len)
+{
+    size_t need = copy_->length() + len;
+    if (need > copy_->capacity())
+    {
+        //  Grow by doubling up to the limit. Reserve on an empty string
+        //  allocates exactly, where growing in place may round up.
+        size_t size = copy_->capacity() < 1024 ? 1024 : copy_->capacity() * 2;
+        if (size > copy_limit_) size = copy_limit_;
+        if (size < need) size = need;
+        std::string grown;
+        grown.reserve(size);
+        grown = *copy_;
+        copy_->swap(grown);
+    }
+    copy_->append(data, len);
+}
+
+void PageWriter::stream(const char *data, size_t len)
+{
+    while (ok_ && len > 0)
+    {
+        size_t nn = PAGE_WINDOW - len_;
+        if (nn > len) nn = len;
+        memcpy(data_ + CHUNK_PREFIX + len_, data, nn);
+        len_ += nn;
+        data += nn;
+        len -= nn;
+        if (len_ == PAGE_WINDOW)
+        {
+            flush();
+        }
+    }
+}
+
+void PageWriter::write(const char *data, size_t len)
+{
+    if (copy_ && copy_->length() + len <= copy_limit_)
+    {
+        keep(data, len);
+    }
+    else
+    {
+        if (copy_)
+        {
+            //  Too long to hold: send what was held, then stream
+            std::string *copy = copy_;
+            copy_ = nullptr;
+            stream(copy->data(), copy->length());
+            std::string().swap(*copy);
+        }
+        stream(data, len);
+    }
+}
+
+PageWriter &PageWriter::operator <<(const char *str)
+{
+    write(str, strlen(str));
+    return *this;
+}
+
+PageWriter &PageWriter::operator <<(const std::string &str)
+{
+    write(str.c_str(), str.length());
+    return *this;
+}
+
+PageWriter &PageWriter::operator <<(int value)
+{
+    char num[12];
+    write(num, snprintf(num, sizeof(num), "%d", value));
+    return *this;
+}
+
+void PageWriter::flush()
+{
+    if (!chunked_)
+    {
+        std::string hdr(*header_);
+        hdr += "\r\nTransfer-Encoding: chunked\r\n\r\n";
+        ok_ = web_->send_data(client_, hdr.c_str(), hdr.length());
+        chunked_ = true;
+    }
+    if (ok_ && len_ > 0)
+    {
+        char size[CHUNK_PREFIX + 1];
+        int sl = snprintf(size, sizeof(size), "%x\r\n", static_cast<unsigned>(len_));
+        char *chunk = data_ + CHUNK_PREFIX - sl;
+        memcpy(chunk, size, sl);
+        memcpy(data_ + CHUNK_PREFIX + len_, "\r\n", CHUNK_SUFFIX);
+        ok_ = web_->send_data(client_, chunk, sl + len_ + CHUNK_SUFFIX);
+    }
+    len_ = 0;
+}
+
+bool PageWriter::end()
+{
+    if (copy_)
+    {
+        //  Held for the caller to send
+    }
+    else if (ok_ && !chunked_)
+    {
+        //  Everything fit in the window: send it whole with its length
+        std::string hdr(*header_);
+        char length[40];
+        snprintf(length, sizeof(length), "\r\nContent-Length: %u\r\n\r\n", static_cast<unsigned>(len_));
+        hdr += length;
+        ok_ = web_->send_data(client_, hdr.c_str(), hdr.length());
+        ok_ = ok_ && (len_ == 0 || web_->send_data(client_, data_ + CHUNK_PREFIX, len_));
+        len_ = 0;
+    }
+    else if (ok_)
+    {
+        flush();
+        ok_ = ok_ && web_->send_data(client_, "0\r\n\r\n", 5);
+    }
+    return ok_;
+}
@@ -0,0 +1,90 @@
+//                  *****  PageWriter class  *****
+
+#ifndef PAGEWRITER_H
+#define PAGEWRITER_H
+
+#include "web.h"
+#include <string>
+#include <stddef.h>
+
+#ifndef PAGE_WINDOW
+#define PAGE_WINDOW     1024                // Streamed response window (bytes)
+#endif
+
+/**
+ * @brief   Output for rendered pages
+ * 
+ * @details Text is only ever appended. The writer holds a fixed window and
+ *          sends it as an HTTP/1.1 chunk each time it fills. A page that
+ *          fits in the first window is sent in one piece with
+ *          Content-Length. The writer itself never holds more than the
+ *          window, but WEB::send_data copies each chunk and queues it until
+ *          TCP takes it, and the page is rendered in one pass (WEB gives no
+ *          notice as the queue drains), so the queued data still grows with
+ *          the page.
+ * 
+ *          For a page cache the body can instead be held, up to a limit,
+ *          and not sent: the caller then stores and sends it with its ETag.
+ *          A body that outgrows the limit is sent as held so far, dropped,
+ *          and the rest streamed.
+ */
+class PageWriter
+{
+private:
+    char                *data_;             // Window (malloc)
+    size_t              len_;               // Data length
+    WEB                 *web_;              // WEB object
+    ClientHandle        client_;            // Client handle
+    const std::string   *header_;           // Header lines
+    bool                chunked_;           // Chunked header sent
+    bool                ok_;                // All sends succeeded
+    std::string         *copy_;             // Held body (null if none or dropped)
+    size_t              copy_limit_;        // Largest body held
+
+    void keep(const char *data, size_t len);
+    void stream(const char *data, size_t len);
+    void flush();
+
+    PageWriter(const PageWriter &);
+    PageWriter &operator =(const PageWriter &);
+
+public:
+    /**
+     * @brief   Constructor
+     * 
+     * @param   web     WEB object
+     * @param   client  Client handle
+     * @param   header  Header lines without Content-Length or the closing blank line.
+     *                  Must remain valid until end().
+     * @param   copy    Receives the body, if no longer than limit (null to
+     *                  stream it all)
+     * @param   limit   Largest body held
+     */
+    PageWriter(WEB *web, ClientHandle client, const std::string &header, std::string *copy = nullptr,
+               size_t limit = 0);
+    ~PageWriter();
+
+    void write(const char *data, size_t len);
+    PageWriter &operator <<(const char *str);
+    PageWriter &operator <<(const std::string &str);
+    PageWriter &operator <<(int value);
+
+    /**
+     * @brief   Send the rest of the response
+     * 
+     * @details Sends nothing if the body was held (see kept)
+     * 
+     * @return  true if every part was sent
+     */
+    bool end();
+
+    /**
+     * @brief   Check whether the body was held
+     * 
+     * @return  true if the whole body is in the copy and none of the
+     *          response has been sent
+     */
+    bool kept() const { return copy_ != nullptr; }
+};
+
+#endif
@@ -2,19 +2,25 @@
 #include "remotefile.h"
 #include "irprocessor.h"
 #include "command.h"
+#include "menujournal.h"
 #include "txt.h"
 #include "config.h"
 #include "web.h"
 #include "web_files.h"
+#include "webasset.h"
 #include "web_set_time.h"
 #include "jsonmap.h"
 #include "backup.h"
 #include "led.h"
+#include "menu.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <pico/stdlib.h>
 #include "pico/cyw43_arch.h"
+#include <pico/multicore.h>
+#include <pico/flash.h>
+#include <pico/async_context_threadsafe_background.h>
 #include <pfs.h>
 #include <lfs.h>
 #include <sys/stat.h>
@@ -36,43 +42,95 @@ Remote *Remote::singleton_ = nullptr;
 
 struct Remote::URLPROC Remote::funcs[] =
     {
-        {std::regex("^/index(|\\.html)$", std::regex_constants::extended), &Remote::remote_get, nullptr},
-        {std::regex("^/config(|\\.html)$", std::regex_constants::extended), &Remote::config_get, &Remote::config_post},
-        {std::regex("^/backup(|\\.html)$", std::regex_constants::extended), &Remote::backup_get, &Remote::backup_post},
-        {std::regex("^/menu(|\\.html)$", std::regex_constants::extended), &Remote::menu_get, &Remote::menu_post},
-        {std::regex("^(.*)/setup(|\\.html)$", std::regex_constants::extended), &Remote::setup_get, &Remote::setup_post},
-        {std::regex("^(.*)/setup(|\\.html)/([0-9]+)$", std::regex_constants::extended), &Remote::setup_btn_get, &Remote::setup_btn_post},
-        {std::regex("^/editprompt(|\\.html)$", std::regex_constants::extended), &Remote::prompt_get, &Remote::prompt_post},
-        {std::regex("^/test(|\\.html)$", std::regex_constants::extended), &Remote::test_get, nullptr},
-        {std::regex("^/log(|\\.html)$", std::regex_constants::extended), &Remote::log_get, &Remote::log_post},
+        {URLPattern("/index[.html]"), &Remote::remote_get, nullptr},
+        {URLPattern("/config[.html]"), &Remote::config_get, &Remote::config_post},
+        {URLPattern("/backup[.html]"), &Remote::backup_get, &Remote::backup_post},
+        {URLPattern("/menu[.html]"), &Remote::menu_get, &Remote::menu_post},
+        {URLPattern("*/setup[.html]"), &Remote::setup_get, &Remote::setup_post},
+        {URLPattern("*/setup[.html]/#"), &Remote::setup_btn_get, &Remote::setup_btn_post},
+        {URLPattern("/editprompt[.html]"), &Remote::prompt_get, &Remote::prompt_post},
+        {URLPattern("/test[.html]"), &Remote::test_get, nullptr},
+        {URLPattern("/log[.html]"), &Remote::log_get, &Remote::log_post},
+        {URLPattern("/diag[.html]"), &Remote::diag_get, nullptr},
     };
 
+//  Entries for the same func must be adjacent (see wsindex_init)
 struct Remote::WSPROC Remote::wsproc[] =
     {
-        {"btnVal", std::regex(".*", std::regex_constants::extended), &Remote::remote_button},
-        {"ir_get", std::regex("^(.*)/setup(|\\.html)/([0-9]+)$", std::regex_constants::extended), &Remote::setup_ir_get},
-        {"ir_get", std::regex("^/menu.*", std::regex_constants::extended), &Remote::menu_ir_get},
-        {"ir_get", std::regex("^/test.*", std::regex_constants::extended), &Remote::test_ir_get},
-        {"get_wifi", std::regex("^/config.*", std::regex_constants::extended), &Remote::config_get_wifi},
-        {"scan_wifi", std::regex("^/config.*", std::regex_constants::extended), &Remote::config_scan_wifi},
-        {"test_send", std::regex("^/test.*", std::regex_constants::extended), &Remote::test_send},
-        {"tv_btn_click", std::regex("^/tvadapter", std::regex_constants::extended), &Remote::tvadapter_button},
-        {"tv_btn_press", std::regex("^/tvadapter", std::regex_constants::extended), &Remote::tvadapter_button},
-        {"tv_btn_release", std::regex("^/tvadapter", std::regex_constants::extended), &Remote::tvadapter_button},
-        {"input_select", std::regex("^/tvadapter", std::regex_constants::extended), &Remote::tvadapter_input},
+        {"btnVal", URLPattern("*"), &Remote::remote_button},
+        {"btn_time", URLPattern("*"), &Remote::remote_button_time},
+        {"ir_get", URLPattern("*/setup[.html]/#"), &Remote::setup_ir_get},
+        {"ir_get", URLPattern("/menu*"), &Remote::menu_ir_get},
+        {"ir_get", URLPattern("/test*"), &Remote::test_ir_get},
+        {"get_wifi", URLPattern("/config*"), &Remote::config_get_wifi},
+        {"scan_wifi", URLPattern("/config*"), &Remote::config_scan_wifi},
+        {"test_send", URLPattern("/test*"), &Remote::test_send},
+        {"sniff", URLPattern("/test*"), &Remote::test_sniff},
+        {"sniff_log", URLPattern("/test*"), &Remote::test_sniff_log},
+        {"tv_btn_click", URLPattern("/tvadapter"), &Remote::tvadapter_button},
+        {"tv_btn_press", URLPattern("/tvadapter"), &Remote::tvadapter_button},
+        {"tv_btn_release", URLPattern("/tvadapter"), &Remote::tvadapter_button},
+        {"input_select", URLPattern("/tvadapter"), &Remote::tvadapter_input},
     };
 
+uint8_t Remote::wsindex_[16];
+
+void Remote::wsindex_init()
+{
+    static_assert(count_of(wsproc) < 256, "wsindex_ entries are uint8_t");
+    memset(wsindex_, 0, sizeof(wsindex_));
+    for (int ii = 0; ii < count_of(wsproc); ii++)
+    {
+        if (ii == 0 || wsproc[ii].hash != wsproc[ii - 1].hash || strcmp(wsproc[ii].func, wsproc[ii - 1].func) != 0)
+        {
+            int slot = wsproc[ii].hash % count_of(wsindex_);
+            while (wsindex_[slot] != 0)
+            {
+                slot = (slot + 1) % count_of(wsindex_);
+            }
+            wsindex_[slot] = ii + 1;
+        }
+    }
+}
+
+const Remote::WSPROC *Remote::wsfind(const char *func, const char *path, URLPattern::Match &match)
+{
+    const WSPROC *ret = nullptr;
+    uint32_t hash = funcHash(func);
+    for (int slot = hash % count_of(wsindex_); wsindex_[slot] != 0; slot = (slot + 1) % count_of(wsindex_))
+    {
+        const WSPROC *proc = &wsproc[wsindex_[slot] - 1];
+        if (proc->hash == hash && strcmp(proc->func, func) == 0)
+        {
+            size_t len = strlen(path);
+            for (const WSPROC *end = wsproc + count_of(wsproc); !ret && proc < end && proc->hash == hash; ++proc)
+            {
+                if (proc->path_match.match(path, len, match))
+                {
+                    ret = proc;
+                }
+            }
+            break;
+        }
+    }
+    return ret;
+}
+
 bool Remote::init(int indicator_gpio, int button_gpio)
 {
     indicator_ = new Indicator(indicator_gpio);
     button_ = new Button(0, button_gpio);
     button_->setEventCallback(button_event, this);
 
-    queue_init(&exec_queue_, sizeof(Command *), 8);
-    queue_init(&resp_queue_, sizeof(Command *), 8);
+    Command::initPool();
+    wsindex_init();
 
     worker_ = { .do_work = get_replies, .user_data = this };
     async_context_add_when_pending_worker(cyw43_arch_async_context(), &worker_);
+
+    MenuJournal::get()->load();
+    journal_worker_ = { .do_work = flush_journal, .user_data = this };
+    async_context_add_at_time_worker_in_ms(cyw43_arch_async_context(), &journal_worker_, MENU_JOURNAL_FLUSH_MS);
     
     WEB *web = WEB::get();
     web->setLogger(log_);
@@ -124,40 +182,42 @@ Remote::~Remote()
     async_context_remove_when_pending_worker(cyw43_arch_async_context(), &worker_);
 
     Command *cmdptr;
-    while (queue_try_remove(&exec_queue_, &cmdptr))
+    while (high_ring_.pop(cmdptr))
     {
         delete cmdptr;
     }
-    queue_free(&exec_queue_);
 
-    while (queue_try_remove(&resp_queue_, &cmdptr))
+    while (exec_ring_.pop(cmdptr))
+    {
+        delete cmdptr;
+    }
+
+    while (resp_ring_.pop(cmdptr))
     {
         delete cmdptr;
     }
-    queue_free(&resp_queue_);
 }
 
-bool Remote::get_rfile(const std::string &url)
+bool Remote::get_rfile(const char *url)
 {
     if (!efile_.isModified())
     {
         efile_.clear();
     }
-    return rfile_.loadForURL(url);
+    return pages_.get(url, rfile_);
 }
 
 bool Remote::get_efile(const std::string &url)
 {
-    return efile_.loadForURL(url);
+    return efile_.loadForURL(url.c_str());
 }
 
 bool Remote::get_efile(const std::string &url, WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close)
 {
     bool ret = false;
-    rfile_.clear();
     if (!efile_.isModified() || RemoteFile::urlToAction(url) == efile_.filename())
     {
-        ret = efile_.loadForURL(url);
+        ret = efile_.loadForURL(url.c_str());
         if (!ret)
         {
             web->send_data(client, "HTTP/1.0 404 NOT_FOUND\r\n\r\n", 26);
@@ -203,17 +263,12 @@ void Remote::ws_message(WEB *web, ClientHandle client, const std::string &msg)
     if (func && path)
     {
         log_->print_debug(1, "%d WS func=%s, path=%s : %s\n", client, func, path, msg.c_str());
-        bool found = false;
-        for (int ii = 0; ii < count_of(wsproc); ii++)
+        const WSPROC *proc = wsfind(func, path, route_);
+        if (proc)
         {
-            if (func == wsproc[ii].func && std::regex_match(path, wsproc[ii].path_match))
-            {
-                (this->*wsproc[ii].cb)(web, client, msgmap);
-                found = true;
-                break;
-            }
+            (this->*proc->cb)(web, client, msgmap);
         }
-        if (!found)
+        else
         {
             log_->print("Message processor not found for func: '%s', path: '%s' <- '%s'\n", func, path, msg.c_str());
         }
@@ -224,15 +279,6 @@ void Remote::ws_message(WEB *web, ClientHandle client, const std::string &msg)
     }
 }
 
-bool Remote::send_http(WEB *web, ClientHandle client, TXT &html, bool &close)
-{
-    HTTPRequest::setHTMLLengthHeader(html);
-    bool ret = web->send_data(client, html.data(), html.datasize(), WEB::PREALL);
-    html.release();
-    close = !ret;
-    return ret;
-}
-
 bool Remote::http_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close)
 {
     bool ret = false;
@@ -240,7 +286,7 @@ bool Remote::http_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &cl
     bool found = false;
     for (int ii = 0; ii < count_of(funcs); ii++)
     {
-        if (std::regex_match(url, funcs[ii].url_match) && funcs[ii].get != nullptr)
+        if (funcs[ii].get != nullptr && funcs[ii].url_match.match(url, route_))
         {
             ret = (this->*funcs[ii].get)(web, client, rqst, close);
             found = true;
@@ -250,13 +296,11 @@ bool Remote::http_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &cl
     if (!found)
     {
         ret = false;
-        const char *data;
-        u16_t datalen;
-        if (url.length() > 0 && WEB_FILES::get()->get_file(url.substr(1), data, datalen))
+        const WebAsset *asset = url.length() > 0 ? WebAsset::get(url.substr(1)) : nullptr;
+        if (asset)
         {
-            web->send_data(client, data, datalen, WEB::STAT);
-            close = false;
-            ret = true;
+            ret = asset->send(web, client, WebAsset::accepts(rqst.header("Accept-Encoding"), "gzip"));
+            close = !ret;
         }
         else
         {
@@ -277,7 +321,7 @@ bool Remote::http_post(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &c
     std::string url = rqst.path();
     for (int ii = 0; ii < count_of(funcs); ii++)
     {
-        if (std::regex_match(url, funcs[ii].url_match) && funcs[ii].post != nullptr)
+        if (funcs[ii].post != nullptr && funcs[ii].url_match.match(url, route_))
         {
             ret = (this->*funcs[ii].post)(web, client, rqst, close);
             found = true;
@@ -327,26 +371,112 @@ bool Remote::get_label(std::string &label, const std::string &background, const
     return ret;
 }
 
-bool Remote::queue_command(const Command *cmd)
+bool Remote::queue_command(Command *cmd, WEB *web, ClientHandle client, const JSONMap &msgmap)
+{
+    bool ret = false;
+    const char *func = msgmap.strValue("func", "");
+    //  The scheduler shares the IR core by estimated send time
+    if (cmd && (cmd->action() == Command::CMD_CLICK || cmd->action() == Command::CMD_PRESS))
+    {
+        cmd->setEstimate(estimate_plan_);
+    }
+
+    if (cmd && strcmp(cmd->url(), "/tvadapter") == 0 && tvadapter_ != client)
+    {
+        //  CEC steps go to the tvadapter page that last sent a command
+        log_->print("tvadapter handle %u -> %u\n", tvadapter_, client);
+        tvadapter_ = client;
+    }
+
+    if (cmd == nullptr)
+    {
+        log_->print_debug(1, "No free command for %s\n", func);
+    }
+    else if (!push_command(cmd))
+    {
+        log_->print_debug(1, "Command lane full for %s\n", func);
+        delete cmd;
+    }
+    else
+    {
+        IR_Processor *ir = ir_;
+        if (ir)
+        {
+            ir->commandQueued();
+        }
+        ret = true;
+    }
+
+    if (!ret)
+    {
+        const char *resp = strcmp(func, "test_send") == 0 ? "send_resp" : (strcmp(func, "ir_get") == 0 ? "ir_resp" :
+                           (strcmp(func, "sniff") == 0 ? "sniff_resp" : "btn_resp"));
+        char msg[128];
+        snprintf(msg, sizeof(msg), "{\"func\":\"%s\",\"action\":\"busy\",\"button\":\"%d\",\"type\":\"\"}",
+                 resp, msgmap.intValue("btnVal"));
+        web->send_message(client, msg);
+    }
+    return ret;
+}
+
+bool Remote::push_command(Command *cmd)
 {
-    bool ret = queue_try_add(&exec_queue_, &cmd);
+    bool ret = false;
+    CommandLane lane = commandLane(cmd);
+    int level = 0;
+    if (lane == LANE_HIGH)
+    {
+        int limit = cmd->action() == Command::CMD_PRESS ? high_ring_.capacity() - 1 : high_ring_.capacity();
+        if (high_ring_.level() < limit)
+        {
+            ret = high_ring_.push(cmd);
+            level = high_ring_.level();
+        }
+    }
+    else
+    {
+        ret = exec_ring_.push(cmd);
+        level = exec_ring_.level();
+    }
+
+    LaneStats &stats = lanes_[lane];
+    if (ret)
+    {
+        ++stats.queued;
+        if (level > stats.peak)
+        {
+            stats.peak = level;
+        }
+    }
+    else
+    {
+        ++stats.refused;
+    }
     return ret;
 }
 
-Command *Remote::getNextCommand()
+Remote::CommandLane Remote::commandLane(const Command *cmd)
 {
-    Command *ret = nullptr;
-    if (!queue_try_remove(&exec_queue_, &ret))
+    CommandLane ret = LANE_NORMAL;
+    switch (cmd->action())
     {
-        ret = nullptr;
+    case Command::CMD_PRESS:
+    case Command::CMD_RELEASE:
+    case Command::CMD_CANCEL:
+        ret = LANE_HIGH;
+        break;
+
+    default:
+        break;
     }
     return ret;
 }
 
-Command *Remote::peekNextCommand()
+Command *Remote::getNextCommand(CommandLane lane)
 {
     Command *ret = nullptr;
-    if (!queue_try_peek(&exec_queue_, &ret))
+    bool ok = lane == LANE_HIGH ? high_ring_.pop(ret) : exec_ring_.pop(ret);
+    if (!ok)
     {
         ret = nullptr;
     }
@@ -355,7 +485,13 @@ Command *Remote::peekNextCommand()
 
 void Remote::commandReply(Command *command)
 {
-    queue_try_add(&resp_queue_, &command);
+    if (!resp_ring_.push(command))
+    {
+        //  Runs on the IR core, which must not write the log file
+        ++reply_drops_;
+        printf("Reply queue full, dropped reply for %s\n", command->url());
+        delete command;
+    }
     async_context_set_work_pending(cyw43_arch_async_context(), &worker_);
 }
 
@@ -368,17 +504,113 @@ void Remote::get_replies(async_context_t *context, async_when_pending_worker_t *
 void Remote::get_replies()
 {
     Command *cmd = nullptr;
-    while (queue_try_remove(&resp_queue_, &cmd))
+    while (resp_ring_.pop(cmd))
     {
         log_->print_debug(1, "Reply: %s\n", cmd->reply().c_str());
         cmd->web()->send_message(cmd->client(), cmd->reply());
         delete cmd;
     }
+    if (menu_state_.load(std::memory_order_acquire) == MENU_ASKED)
+    {
+        menu_rqst_.ok = Menu::getMenuSteps(menu_rqst_.step, menu_rqst_.steps);
+        menu_state_.store(MENU_DONE, std::memory_order_release);
+        IR_Processor *ir = ir_;
+        if (ir)
+        {
+            ir->menuStepsReady();
+        }
+    }
+
+    CECMessage cec;
+    while (cec_ring_.pop(cec))
+    {
+        send_cec(cec);
+    }
+
+    bool busy = ir_busy_;
+    if (busy != indicator_->irState())
+    {
+        indicator_->setIRState(busy);
+    }
+
+    if (sniffed_.exchange(false))
+    {
+        WEB *web = WEB::get();
+        std::string msg;
+        sniff_message(msg);
+        for (auto it = sniff_clients_.begin(); it != sniff_clients_.end(); )
+        {
+            //  A client that has gone is dropped
+            it = web->send_message(*it, msg) ? std::next(it) : sniff_clients_.erase(it);
+        }
+    }
+}
+
+void Remote::send_cec(const CECMessage &cec)
+{
+    if (tvadapter_ != 0)
+    {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "{\"action\":\"cec\",\"cmd\":\"%s\",\"val1\":%u,\"val2\":%u}",
+                 cec.cmd, cec.val1, cec.val2);
+        if (!WEB::get()->send_message(tvadapter_, msg))
+        {
+            log_->print("Invalid handle %u for CEC command\n", tvadapter_);
+            tvadapter_ = 0;
+        }
+    }
+}
+
+bool Remote::sendCEC(const char *cmd, uint16_t val1, uint16_t val2)
+{
+    CECMessage cec;
+    strncpy(cec.cmd, cmd, sizeof(cec.cmd) - 1);
+    cec.cmd[sizeof(cec.cmd) - 1] = 0;
+    cec.val1 = val1;
+    cec.val2 = val2;
+    bool ret = cec_ring_.push(cec);
+    if (!ret)
+    {
+        //  Runs on the IR core, which must not write the log file
+        printf("CEC queue full, dropped %s\n", cmd);
+    }
+    async_context_set_work_pending(cyw43_arch_async_context(), &worker_);
+    return ret;
+}
+
+void Remote::requestMenuSteps(const Command::Step &step)
+{
+    menu_rqst_.step = step;
+    menu_rqst_.steps.clear();
+    menu_state_.store(MENU_ASKED, std::memory_order_release);
+    async_context_set_work_pending(cyw43_arch_async_context(), &worker_);
+}
+
+bool Remote::takeMenuSteps(std::deque<Command::Step> &steps)
+{
+    bool ret = false;
+    steps.clear();
+    if (menu_state_.load(std::memory_order_acquire) == MENU_DONE)
+    {
+        steps.swap(menu_rqst_.steps);
+        ret = menu_rqst_.ok;
+        menu_state_.store(MENU_IDLE, std::memory_order_release);
+    }
+    return ret;
 }
 
 void Remote::ir_busy(bool busy, void *udata)
 {
-    static_cast<Remote *>(udata)->indicator_->setIRState(busy);
+    Remote *self = static_cast<Remote *>(udata);
+    self->ir_busy_ = busy;
+    async_context_set_work_pending(cyw43_arch_async_context(), &self->worker_);
+}
+
+void Remote::ir_sniffed(void *udata)
+{
+    Remote *self = static_cast<Remote *>(udata);
+    self->sniffed_ = true;
+    async_context_set_work_pending(cyw43_arch_async_context(), &self->worker_);
 }
 
 void Remote::web_state(int state, void *udata)
@@ -428,6 +660,12 @@ uint16_t Remote::to_u16(const std::string &str)
     return ret;
 }
 
+void Remote::flush_journal(async_context_t *ctx, async_at_time_worker_t *worker)
+{
+    MenuJournal::get()->flush();
+    async_context_add_at_time_worker_in_ms(ctx, worker, MENU_JOURNAL_FLUSH_MS);
+}
+
 void Remote::time_callback()
 {
     if (!time_initialized_)
@@ -440,6 +678,7 @@ void Remote::time_callback()
 void Remote::setDebug(int level)
 {
     log_->setDebug(level);
+    ir_debug_ = level;
     CONFIG::get()->set_debug(level);
 }
 
@@ -506,6 +745,82 @@ void Remote::Indicator::update()
     led_->setFlashPattern(pattern, 32);
 }
 
+//  *****  Flash writes  *****
+
+//  Core 1 also runs from flash, so every erase and program by the file
+//  system goes through flash_safe_execute, which parks core 1 in RAM
+//  until it is done. The IR frame in progress carries on in PIO and DMA.
+#ifndef FLASH_SAFE_TIMEOUT
+#define FLASH_SAFE_TIMEOUT  1000        // Longest wait for core 1 to park (ms)
+#endif
+
+static struct lfs_config fs_flash;      // Flash driver from ffs_pico_createcfg
+
+struct FlashOp
+{
+    const struct lfs_config *cfg;       // File system configuration
+    lfs_block_t             block;      // Block to erase or program
+    lfs_off_t               off;        // Offset in the block
+    const void              *buffer;    // Data to program
+    lfs_size_t              size;       // Length of data
+    int                     ret;        // Driver result
+};
+
+static void fs_prog_safe(void *param)
+{
+    FlashOp *op = (FlashOp *)param;
+    op->ret = fs_flash.prog(op->cfg, op->block, op->off, op->buffer, op->size);
+}
+
+static void fs_erase_safe(void *param)
+{
+    FlashOp *op = (FlashOp *)param;
+    op->ret = fs_flash.erase(op->cfg, op->block);
+}
+
+static int fs_flash_op(void (*func)(void *), FlashOp *op)
+{
+    if (!multicore_lockout_victim_is_initialized(1))
+    {
+        //  Core 1 not started yet
+        func(op);
+    }
+    else if (flash_safe_execute(func, op, FLASH_SAFE_TIMEOUT) != PICO_OK)
+    {
+        op->ret = LFS_ERR_IO;
+    }
+    return op->ret;
+}
+
+static int fs_prog(const struct lfs_config *cfg, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size)
+{
+    FlashOp op = {cfg, block, off, buffer, size, 0};
+    return fs_flash_op(fs_prog_safe, &op);
+}
+
+static int fs_erase(const struct lfs_config *cfg, lfs_block_t block)
+{
+    FlashOp op = {cfg, block, 0, nullptr, 0, 0};
+    return fs_flash_op(fs_erase_safe, &op);
+}
+
+//  IR engine entry point on core 1. Core 0 keeps the network and the flash;
+//  core 1 is parked by flash_safe_execute while core 0 writes flash.
+static void ir_core()
+{
+    static async_context_threadsafe_background_t context;
+
+    flash_safe_execute_core_init();
+    async_context_threadsafe_background_init_with_defaults(&context);
+
+    Remote *remote = Remote::get();
+    IR_Processor *ir = new IR_Processor(remote, IR_SEND_GPIO, IR_RCV_GPIO, &context.core);
+    ir->setBusyCallback(remote->ir_busy, remote);
+    ir->setSniffCallback(remote->ir_sniffed, remote);
+    remote->setIRProcessor(ir);
+    ir->run();
+}
+
 int main ()
 {
     stdio_init_all();
@@ -514,6 +829,9 @@ int main ()
     struct pfs_pfs *pfs;
     struct lfs_config cfg;
     ffs_pico_createcfg (&cfg, ROOT_OFFSET, ROOT_SIZE);
+    fs_flash = cfg;
+    cfg.prog = fs_prog;
+    cfg.erase = fs_erase;
     pfs = pfs_ffs_create (&cfg);
     pfs_mount (pfs, "/");
 
@@ -532,9 +850,16 @@ int main ()
     remote->cleanupFiles();
     remote->init(INDICATOR_GPIO, BUTTON_GPIO);
 
-    IR_Processor *ir = new IR_Processor(Remote::get(), IR_SEND_GPIO, IR_RCV_GPIO);
-    ir->setBusyCallback(remote->ir_busy, remote);
-    ir->run();
+    multicore_launch_core1(ir_core);
+    while (!multicore_lockout_victim_is_initialized(1))
+    {
+        //  No flash writes until core 1 can be parked
+        sleep_ms(1);
+    }
+    while (true)
+    {
+        sleep_ms(1000);
+    }
 
     return 0;
 }
@@ -4,15 +4,21 @@
 #define REMOTE_H
 
 #include "remotefile.h"
+#include "remotefilecache.h"
+#include "urlpattern.h"
+#include "pagewriter.h"
+#include "spscring.h"
+#include "command.h"
+#include "irdevice.h"
 #include "jsonmap.h"
 #include "web.h"
 #include "txt.h"
 #include "button.h"
 #include "file_logger.h"
 #include "pico/cyw43_arch.h"
-#include <pico/util/queue.h>
 #include <pico/async_context.h>
-#include <regex>
+#include <atomic>
+#include <deque>
 #include <set>
 #include <string>
 
@@ -23,18 +29,85 @@
 
 #define     LOG_FILE        "log_file.txt"
 
+#ifndef CEC_QUEUE_DEPTH
+#define CEC_QUEUE_DEPTH     4               // CEC messages waiting for the web core
+#endif
+
 class Command;
 class LED;
+class IR_Processor;
 
 class Remote
 {
+public:
+    /**
+     * @brief   Command lanes to the IR core
+     * 
+     * @details Commands that stop or continue a repeat (release, cancel and
+     *          press) use the high lane, which the IR core always empties
+     *          first. A press never takes the last high lane slot, which is
+     *          kept for a release or cancel. Everything else uses the normal
+     *          lane. A full lane refuses the command with a busy reply.
+     */
+    enum CommandLane
+    {
+        LANE_HIGH,
+        LANE_NORMAL,
+        LANE_COUNT
+    };
+
+    struct LaneStats
+    {
+        uint32_t    queued;             // Commands queued
+        uint32_t    refused;            // Commands refused, lane full
+        uint32_t    peak;               // Peak lane level
+    };
+
 private:
-    RemoteFile                  rfile_;                 // Remote page definition file
+    struct CECMessage
+    {
+        char                    cmd[24];                // CEC command
+        uint16_t                val1;                   // First value (action address)
+        uint16_t                val2;                   // Second value (action value)
+    };
+
+    enum MenuState
+    {
+        MENU_IDLE,                                      // Nothing asked
+        MENU_ASKED,                                     // IR core waiting, web core to expand
+        MENU_DONE                                       // Steps ready for the IR core
+    };
+
+    struct MenuRequest
+    {
+        Command::Step           step;                   // Menu action
+        std::deque<Command::Step> steps;                // Steps to send
+        bool                    ok;                     // Action expanded
+    };
+
+    RemoteFileCache             pages_;                 // Parsed remote page cache
+    RemoteFile                  *rfile_;                // Remote page definition file (in pages_)
     RemoteFile                  efile_;                 // Definition file for editing
     JSONMap                     icons_;                 // Icon list
-    queue_t                     exec_queue_;            // Command queue
-    queue_t                     resp_queue_;            // Response queue
+    SPSCRing<Command *, COMMAND_HIGH_DEPTH> high_ring_; // High priority lane to the IR core
+    SPSCRing<Command *, COMMAND_QUEUE_DEPTH> exec_ring_; // Normal lane to the IR core
+    SPSCRing<Command *, COMMAND_REPLY_DEPTH> resp_ring_; // Replies from the IR core
     async_when_pending_worker_t worker_;                // Response notice worker
+    std::atomic<IR_Processor *> ir_;                    // IR engine (command doorbell)
+    LaneStats                   lanes_[LANE_COUNT];     // Command lane counters
+    URLPattern::Match           route_;                 // Captures of last URL dispatch
+    uint32_t                    reply_drops_;           // Replies dropped, response queue full
+    IRPlan                      estimate_plan_;         // Work plan for send time estimates
+    async_at_time_worker_t      journal_worker_;        // Menu journal flush worker
+    std::atomic<bool>           sniffed_;               // Sniffed frames changed
+    std::set<ClientHandle>      sniff_clients_;         // Clients shown the sniffed frames
+    IR_Device::SniffLog         sniff_log_;             // Latest sniffed frames from the IR core
+    SPSCRing<CECMessage, CEC_QUEUE_DEPTH> cec_ring_;    // CEC messages from the IR core
+    ClientHandle                tvadapter_;             // tvadapter WebSocket client (0 if none)
+    MenuRequest                 menu_rqst_;             // Menu action the IR core is waiting on
+    std::atomic<int>            menu_state_;            // Owner of menu_rqst_ (MenuState)
+    std::atomic<bool>           ir_busy_;               // IR processor busy (set on the IR core)
+    std::atomic<int>            ir_debug_;              // Log level for the IR core
 
     class Indicator
     {
@@ -51,13 +124,14 @@ private:
         ~Indicator();
 
         void setIRState(bool busy) { ir_busy_ = busy; update(); }
+        bool irState() const { return ir_busy_; }
         void setWebState(int state);
     };
     Indicator                   *indicator_;            // Indicator LED object
     Button                      *button_;               // AP activation button
     FileLogger                  *log_;                  // Logger
 
-    bool get_rfile(const std::string &url);
+    bool get_rfile(const char *url);
     bool get_efile(const std::string &url);
     bool get_efile(const std::string &url, WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
 
@@ -69,13 +143,14 @@ private:
     static void ws_message_(WEB *web, ClientHandle client, const std::string &msg, void *udata)
      { static_cast<Remote *>(udata)->ws_message(web, client, msg); }
 
-    bool send_http(WEB *web, ClientHandle client, TXT &html, bool &close);
-
     bool http_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
     bool http_post(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
 
     bool remote_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
+    void render_remote(const std::string &tag, PageWriter &out, const std::string &backurl);
     bool remote_button(WEB *web, ClientHandle client, const JSONMap &msgmap);
+    bool remote_button_time(WEB *web, ClientHandle client, const JSONMap &msgmap);
+    static void flush_journal(async_context_t *ctx, async_at_time_worker_t *worker);
     bool backup_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
     bool backup_post(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
     bool setup_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
@@ -95,8 +170,12 @@ private:
     bool test_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
     bool test_send(WEB *web, ClientHandle client, const JSONMap &msgmap);
     bool test_ir_get(WEB *web, ClientHandle client, const JSONMap &msgmap);
+    bool test_sniff(WEB *web, ClientHandle client, const JSONMap &msgmap);
+    bool test_sniff_log(WEB *web, ClientHandle client, const JSONMap &msgmap);
+    void sniff_message(std::string &message);
     bool log_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
     bool log_post(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
+    bool diag_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
     bool prompt_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
     bool prompt_post(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
     bool tvadapter_button(WEB *web, ClientHandle client, const JSONMap &msgmap);
@@ -110,10 +189,25 @@ private:
     std::string get_label(const RemoteFile::Button *button) const;
     bool get_label(std::string &label, const std::string &background, const std::string &color, const std::string &fill) const;
 
-    bool queue_command(const Command *cmd);
+    /**
+     * @brief   Queue a command for the IR processor
+     * 
+     * @details If cmd is null (pool exhausted) or its lane is full the
+     *          request is refused with a "busy" reply and the command deleted
+     * 
+     * @param   cmd     Command to queue (may be null)
+     * @param   web     Web object for busy reply
+     * @param   client  Client for busy reply
+     * @param   msgmap  Request message
+     * 
+     * @return  true if queued
+     */
+    bool queue_command(Command *cmd, WEB *web, ClientHandle client, const JSONMap &msgmap);
+    bool push_command(Command *cmd);
 
     static void get_replies(async_context_t *context, async_when_pending_worker_t *worker);
     void get_replies();
+    void send_cec(const CECMessage &cec);
 
     uint16_t to_u16(const std::string &str);
 
@@ -127,11 +221,13 @@ private:
     static void watchdog_periodic(async_context_t *, async_at_time_worker_t *);
 
     static Remote *singleton_;
-    Remote() : indicator_(nullptr), log_(new FileLogger(LOG_FILE)), time_initialized_(false) {}
+    Remote() : rfile_(nullptr), ir_(nullptr), lanes_(), reply_drops_(0), sniffed_(false), tvadapter_(0),
+               menu_state_(MENU_IDLE), ir_busy_(false), ir_debug_(0), indicator_(nullptr), log_(new FileLogger(LOG_FILE)),
+               time_initialized_(false) {}
 
     struct URLPROC
     {
-        std::regex url_match;
+        URLPattern url_match;
         bool (Remote::* get)(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
         bool (Remote::* post)(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close);
     };
@@ -139,22 +235,99 @@ private:
 
     struct WSPROC
     {
-        std::string func;
-        std::regex  path_match;
+        const char  *func;
+        uint32_t    hash;
+        URLPattern  path_match;
         bool (Remote::* cb)(WEB *web, ClientHandle client, const JSONMap &msgmap);
+
+        constexpr WSPROC(const char *func, const URLPattern &path_match,
+                         bool (Remote::* cb)(WEB *web, ClientHandle client, const JSONMap &msgmap))
+         : func(func), hash(funcHash(func)), path_match(path_match), cb(cb) {}
     };
     static struct WSPROC wsproc[];
+    static uint8_t wsindex_[16];        // First wsproc entry + 1 for each func, by hash (0 if empty)
+    static void wsindex_init();
+    static const WSPROC *wsfind(const char *func, const char *path, URLPattern::Match &match);
+
+    /**
+     * @brief   FNV-1a hash of a WebSocket function name
+     */
+    static constexpr uint32_t funcHash(const char *func)
+    {
+        uint32_t hash = 2166136261u;
+        while (*func)
+        {
+            hash = (hash ^ static_cast<uint8_t>(*func++)) * 16777619u;
+        }
+        return hash;
+    }
 
 public:
     static Remote *get() { if (!singleton_) singleton_ = new Remote(); return singleton_; }
     ~Remote();
     bool init(int indicator_gpio, int button_gpio);
 
-    Command *getNextCommand();
-    Command *peekNextCommand();
+    /**
+     * @brief   Command intake for the IR core
+     * 
+     * @details The web side (core 0) is the only producer of commands and
+     *          the IR core (core 1) the only producer of replies, so both
+     *          rings are lock-free. A queued command rings the doorbell of
+     *          the IR processor set by setIRProcessor. A reply wakes the
+     *          reply worker on the cyw43 context, which sends it and
+     *          deletes the command. The IR core takes no lock: whatever
+     *          else it needs from the web side (menu steps, CEC messages,
+     *          the busy indicator) also goes through the reply worker.
+     */
+    void setIRProcessor(IR_Processor *ir) { ir_ = ir; }
+    Command *getNextCommand(CommandLane lane);
+    static CommandLane commandLane(const Command *cmd);
     void commandReply(Command *command);
 
+    /**
+     * @brief   Ask for the steps of a menu action
+     * 
+     * @details Menus and their positions belong to the web core. The IR
+     *          core asks for one action at a time; the reply worker
+     *          expands it, moving the menu, and rings
+     *          IR_Processor::menuStepsReady. Call on the IR core.
+     * 
+     * @param   step    Step holding the menu action
+     */
+    void requestMenuSteps(const Command::Step &step);
+
+    /**
+     * @brief   Take the steps of the menu action asked for
+     * 
+     * @details Call on the IR core after menuStepsReady
+     * 
+     * @param   steps   Receives the steps
+     * 
+     * @return  true if the action was expanded
+     */
+    bool takeMenuSteps(std::deque<Command::Step> &steps);
+
+    /**
+     * @brief   Send a CEC message to the tvadapter
+     * 
+     * @details Call on the IR core. The reply worker sends it to the client
+     *          that last sent a command from the tvadapter page.
+     * 
+     * @param   cmd     CEC command (action type less "cec:")
+     * @param   val1    Action address
+     * @param   val2    Action value
+     * 
+     * @return  false if the queue is full
+     */
+    bool sendCEC(const char *cmd, uint16_t val1, uint16_t val2);
+
+    /**
+     * @brief   Get the log level for the IR core
+     */
+    int irDebug() const { return ir_debug_; }
+
     static void ir_busy(bool busy, void *udata);
+    static void ir_sniffed(void *udata);
     static void web_state(int state, void *udata);
     static void button_event(struct Button::ButtonEvent &ev, void *user_data);
 
@@ -5,15 +5,14 @@
 #include "command.h"
 #include "config.h"
 #include "menu.h"
+#include "pagetemplate.h"
 #include "txt.h"
-#include "web_files.h"
 
 bool Remote::backup_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close)
 {
     bool ret = false;
-    const char *data;
-    u16_t datalen;
-    if (WEB_FILES::get()->get_file("backup.html", data, datalen))
+    const PageTemplate *tmpl = PageTemplate::get("backup.html");
+    if (tmpl)
     {
         std::string files = "<option value='all'>All (backup: ";
         files += CONFIG::get()->hostname();
@@ -35,23 +34,26 @@ bool Remote::backup_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &
             }
         }
 
-        TXT html(data, datalen, 2048);
-        html.substitute("<?files?>", files);
-
         std::vector<std::string> msg_color;
         TXT::split(rqst.userData(), "|", msg_color);
-        if (msg_color.size() == 2)
-        {
-            html.substitute("<?msg?>", msg_color.at(0));
-            html.substitute("<?msgcolor?>", msg_color.at(1));
-        }
-        else
-        {
-            html.substitute("<?msg?>", "");
-            html.substitute("<?msgcolor?>", "transparent");
-        }
-        
-        ret = send_http(web, client, html, close);
+        bool has_msg = msg_color.size() == 2;
+
+        ret = tmpl->send(web, client, [&](const std::string &tag, PageWriter &out)
+            {
+                if (tag == "files")
+                {
+                    out << files;
+                }
+                else if (tag == "msg")
+                {
+                    out << (has_msg ? msg_color.at(0) : "");
+                }
+                else if (tag == "msgcolor")
+                {
+                    out << (has_msg ? msg_color.at(1) : "transparent");
+                }
+            });
+        close = !ret;
     }
     return ret;
 }
@@ -65,9 +67,9 @@ bool Remote::backup_post(WEB *web, ClientHandle client, HTTPRequest &rqst, bool
     std::string button = rqst.postValue("button");
     if (button == "upload")
     {
-        rfile_.clear();
         efile_.clear();
         ret = Backup::loadBackup(rqst, msg);
+        pages_.invalidateAll();
         if (!ret)
         {
             msg = "Load failed";
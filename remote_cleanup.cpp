@@ -13,6 +13,7 @@ void Remote::cleanupFiles()
 {
     int nfa = add_missing_actions();
     int nfr = remove_excess_actions();
+    pages_.invalidateAll();
     if (nfa > 0 || nfr > 0)
     {
         log_->print("Added %d files, removed %d files\n\n", nfa, nfr);
@@ -48,12 +49,13 @@ void Remote::get_references(std::set<std::string> &files, std::set<std::string>
     files.clear();
     references.clear();
     RemoteFile::actionFiles(files);
+    RemoteFile rfile;
     for (auto it = files.cbegin(); it != files.cend(); ++it)
     {
         std::string url = RemoteFile::actionToURL(*it);
-        if (get_rfile(url))
+        if (rfile.loadForURL(url.c_str()))
         {
-            for (auto bi = rfile_.buttons().cbegin(); bi != rfile_.buttons().cend(); ++bi)
+            for (auto bi = rfile.buttons().cbegin(); bi != rfile.buttons().cend(); ++bi)
             {
                 if (strlen(bi->redirect()) > 0)
                 {
@@ -72,7 +74,6 @@ void Remote::get_references(std::set<std::string> &files, std::set<std::string>
             log_->print("Failed to load '%s' for url '%s'\n", it->c_str(), url.c_str());
         }
     }
-    rfile_.clear();
 }
 
 int Remote::add_missing_actions()
@@ -100,10 +101,10 @@ int Remote::add_missing_actions()
         }
         std::string json("{\"title\": \"");
         json += title + "\", \"buttons\": []}";
-        if (rfile_.loadString(json, it->c_str()))
+        RemoteFile rfile;
+        if (rfile.loadString(json, it->c_str()))
         {
-            rfile_.saveFile();
-            rfile_.clear();
+            rfile.saveFile();
         }
     }
 
@@ -4,7 +4,7 @@
 #include "config.h"
 #include "command.h"
 #include "txt.h"
-#include "web_files.h"
+#include "webasset.h"
 #include <stdio.h>
 #include <sys/stat.h>
 
@@ -16,11 +16,11 @@
 bool Remote::config_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close)
 {
     bool ret = false;
-    const char *data;
-    u16_t datalen;
-    if (WEB_FILES::get()->get_file("config.html", data, datalen))
+    const WebAsset *asset = WebAsset::get("config.html");
+    if (asset)
     {
-        ret = web->send_data(client, data, datalen, WEB::STAT);
+        ret = asset->send(web, client, WebAsset::accepts(rqst.header("Accept-Encoding"), "gzip"));
+        close = !ret;
     }
     return ret;
 }
@@ -0,0 +1,146 @@
+//                 ***** Remote class "diag" methods  *****
+
+#include "remote.h"
+#include "command.h"
+#include "irprocessor.h"
+#include "menujournal.h"
+#include "pagetemplate.h"
+#include <stdio.h>
+
+static void diag_section(std::string &rows, const char *title)
+{
+    rows += "<tr><th colspan='2'>";
+    rows += title;
+    rows += "</th></tr>\n";
+}
+
+static void diag_row(std::string &rows, const char *name, uint32_t value)
+{
+    char line[128];
+    snprintf(line, sizeof(line), "<tr><td>%s</td><td>%lu</td></tr>\n", name, static_cast<unsigned long>(value));
+    rows += line;
+}
+
+static void diag_client(std::string &rows, const CommandScheduler::ClientStats &stats)
+{
+    char line[256];
+    snprintf(line, sizeof(line), "<tr><td>Client %u</td><td>depth %lu, peak %lu, queued %lu, merged %lu, "
+             "sent %lu, wait avg %lu ms, max %lu ms, backlog %lu ms, refused %lu</td></tr>\n",
+             static_cast<unsigned>(stats.client),
+             static_cast<unsigned long>(stats.depth), static_cast<unsigned long>(stats.peak),
+             static_cast<unsigned long>(stats.queued), static_cast<unsigned long>(stats.coalesced),
+             static_cast<unsigned long>(stats.served),
+             static_cast<unsigned long>(stats.served > 0 ? stats.wait_ms / stats.served : 0),
+             static_cast<unsigned long>(stats.max_wait_ms), static_cast<unsigned long>(stats.backlog_ms),
+             static_cast<unsigned long>(stats.refused));
+    rows += line;
+}
+
+bool Remote::diag_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close)
+{
+    bool ret = false;
+    const PageTemplate *tmpl = PageTemplate::get("diag.html");
+    if (tmpl)
+    {
+        std::string rows;
+        rows.reserve(1024);
+
+        Command::PoolStats pool;
+        Command::poolStats(pool);
+        diag_section(rows, "Commands");
+        diag_row(rows, "Pool capacity", pool.capacity);
+        diag_row(rows, "In use", pool.in_use);
+        diag_row(rows, "Peak in use", pool.peak);
+        diag_row(rows, "Live objects", Command::count());
+        diag_row(rows, "Allocations", pool.allocs);
+        diag_row(rows, "Refused, pool exhausted", pool.failures);
+        diag_row(rows, "Queued, high lane", high_ring_.level());
+        diag_row(rows, "Queued, normal lane", exec_ring_.level());
+        diag_row(rows, "Replies pending", resp_ring_.level());
+        diag_row(rows, "Replies dropped", reply_drops_);
+
+        static const char *lane_names[] = {"High lane", "Normal lane"};
+        for (int lane = 0; lane < LANE_COUNT; lane++)
+        {
+            diag_section(rows, lane_names[lane]);
+            diag_row(rows, "Queued", lanes_[lane].queued);
+            diag_row(rows, "Refused, lane full", lanes_[lane].refused);
+            diag_row(rows, "Peak level", lanes_[lane].peak);
+        }
+
+        IR_Processor *ir = ir_;
+        if (ir)
+        {
+            IR_Processor::IdleStats idle;
+            ir->getIdleStats(idle);
+            diag_section(rows, "IR core");
+            diag_row(rows, "Doorbell wakeups", idle.wakeups);
+            diag_row(rows, "Commands taken", idle.commands);
+            diag_row(rows, "Work time (ms)", idle.work_us / 1000);
+            diag_row(rows, "Idle (%)", idle.run_us > 0 ? 100 - idle.work_us * 100 / idle.run_us : 100);
+
+            IR_PioTx::Stats tx;
+            ir->getTxStats(tx);
+            diag_section(rows, "IR transmitter");
+            diag_row(rows, "Pulse programs", tx.programs);
+            diag_row(rows, "Marks and spaces", tx.words);
+            diag_row(rows, "Refused", tx.rejected);
+            diag_row(rows, "Transmit time (ms)", tx.busy_us / 1000);
+
+            ir->getSniffLog(sniff_log_);
+            if (sniff_log_.started)
+            {
+                const IR_Sniffer::Stats &sniff = sniff_log_.stats;
+                const IR_GpioRx::Stats &rx = sniff_log_.rx;
+                diag_section(rows, "IR sniffer");
+                diag_row(rows, "Frames logged", sniff.frames);
+                diag_row(rows, "Decoded", sniff.decoded);
+                diag_row(rows, "Repeat frames", sniff.repeats);
+                diag_row(rows, "Dropped as noise", sniff.noise);
+                diag_row(rows, "Receiver edges", rx.edges);
+                diag_row(rows, "Edges lost, ring full", rx.overruns);
+            }
+
+            CommandScheduler::ClientStats clients[SCHEDULER_CLIENTS];
+            int nc = ir->getClientStats(clients, SCHEDULER_CLIENTS);
+            diag_section(rows, "Clients");
+            for (int ii = 0; ii < nc; ii++)
+            {
+                diag_client(rows, clients[ii]);
+            }
+        }
+
+        MenuJournal::Stats journal;
+        MenuJournal::get()->getStats(journal);
+        diag_section(rows, "Menu journal");
+        diag_row(rows, "Positions held", journal.menus);
+        diag_row(rows, "Records in file", journal.records);
+        diag_row(rows, "Records written", journal.writes);
+        diag_row(rows, "Positions restored", journal.restored);
+        diag_row(rows, "Positions expired", journal.expired);
+
+        RemoteFileCache::Stats cache;
+        pages_.getStats(cache);
+        diag_section(rows, "Page cache");
+        diag_row(rows, "Hits", cache.hits);
+        diag_row(rows, "Misses", cache.misses);
+        diag_row(rows, "Evictions", cache.evictions);
+        diag_row(rows, "Invalidations", cache.invalidations);
+        diag_row(rows, "Pages rendered", cache.renders);
+        diag_row(rows, "Not modified (304)", cache.not_modified);
+        diag_row(rows, "Entries", cache.entries);
+        diag_row(rows, "Rendered pages", cache.pages);
+        diag_row(rows, "Bytes", cache.bytes);
+        diag_row(rows, "Byte budget", cache.budget);
+
+        ret = tmpl->send(web, client, [&rows](const std::string &tag, PageWriter &out)
+            {
+                if (tag == "stats")
+                {
+                    out << rows;
+                }
+            });
+        close = !ret;
+    }
+    return ret;
+}
@@ -2,16 +2,15 @@
 
 #include "remote.h"
 #include "file_logger.h"
+#include "pagetemplate.h"
 #include "txt.h"
-#include "web_files.h"
 #include <stdio.h>
 
 bool Remote::log_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close)
 {
     bool ret = false;
-    const char *data;
-    u16_t datalen;
-    if (WEB_FILES::get()->get_file("log.html", data, datalen))
+    const PageTemplate *tmpl = PageTemplate::get("log.html");
+    if (tmpl)
     {
         int32_t endl = log_->line_count();
         try
@@ -31,27 +30,35 @@ bool Remote::log_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &clo
         }
         
         long bgnp = log_->find_line(bgnl);
-        long endp = log_->find_line(endl - bgnl, bgnp);
 
-        TXT html(data, datalen, datalen + endp - bgnp + 128);
-
-        html.substitute("<?from?>", bgnl);
-        html.substitute("<?to?>", endl);
-        html.substitute("<?dbglvl?>", log_->debugLevel());
-
-        uint32_t pos = html.find("<?lines?>");
-        html.replace(pos, 9, "");
-
-        char linebuf[133];
-        FILE *f = log_->open();
-        log_->position(f, bgnp);
-        while (bgnl++ < endl && log_->read(f, linebuf, sizeof(linebuf)))
-        {
-            pos = html.insert(pos, linebuf);
-        }
-        log_->close(f);
-
-        ret = send_http(web, client, html, close);
+        ret = tmpl->send(web, client, [this, bgnl, endl, bgnp](const std::string &tag, PageWriter &out)
+            {
+                if (tag == "from")
+                {
+                    out << bgnl;
+                }
+                else if (tag == "to")
+                {
+                    out << endl;
+                }
+                else if (tag == "dbglvl")
+                {
+                    out << log_->debugLevel();
+                }
+                else if (tag == "lines")
+                {
+                    char linebuf[133];
+                    int32_t line = bgnl;
+                    FILE *f = log_->open();
+                    log_->position(f, bgnp);
+                    while (line++ < endl && log_->read(f, linebuf, sizeof(linebuf)))
+                    {
+                        out << linebuf;
+                    }
+                    log_->close(f);
+                }
+            });
+        close = !ret;
     }
     return ret;
 }
@@ -3,38 +3,34 @@
 #include "remote.h"
 #include "menu.h"
 #include "command.h"
-#include "txt.h"
-#include "web_files.h"
+#include "pagetemplate.h"
 
 bool Remote::menu_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close)
 {
     bool ret = false;
-    const char *data;
-    u16_t datalen;
-    if (WEB_FILES::get()->get_file("menuedit.html", data, datalen))
+    const PageTemplate *tmpl = PageTemplate::get("menuedit.html");
+    if (tmpl)
     {
-        TXT html(data, datalen, 8192);
         std::string menu_name = rqst.query("menu");
         std::string readonly;
         std::set<std::string> names;
         Menu::menuNames(names);
-        std::string data;
-        for (auto it = names.cbegin(); it != names.cend(); ++it)
-        {
-            data += "<option value=\"" + *it + "\"" + (menu_name == *it ? " selected" : "") + ">" + *it + "</option>";
-        }
-        while(html.substitute("<?menus?>", data));
 
         std::map<std::string, Command::Step> emptymap;
-        std::map<std::string, Command::Step> &cmdmap = emptymap;
+        const std::map<std::string, Command::Step> *cmdmap = &emptymap;
         std::string rowspercol;
+        bool wrapcols = false;
+        bool wraprows = false;
         Menu *menu = Menu::getMenu(menu_name);
+        std::string selected = menu_name;
         if (menu)
         {
             menu_name = menu->name();
             readonly = " readonly";
-            cmdmap = menu->commands();
+            cmdmap = &menu->commands();
             rowspercol = menu->rowsPerColumn();
+            wrapcols = menu->wrapColumns();
+            wraprows = menu->wrapRows();
         }
         else
         {
@@ -47,20 +43,64 @@ bool Remote::menu_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &cl
             emptymap["ok"] = Command::Step();
         }
 
-        while(html.substitute("<?menuname?>", menu_name));
-        while(html.substitute("<?readonly?>", readonly));
-        for (auto it = cmdmap.cbegin(); it != cmdmap.cend(); ++it)
-        {
-            std::string key = it->first;
-            const Command::Step &step = it->second;
-            html.substitute(("<?" + key + "typ?>").c_str(), step.type());
-            html.substitute(("<?" + key + "add?>").c_str(), step.address());
-            html.substitute(("<?" + key + "val?>").c_str(), step.value());
-            html.substitute(("<?" + key + "dly?>").c_str(), step.delay());
-        }
-        html.substitute("<?rowspercol?>", rowspercol);
-
-        ret = send_http(web, client, html, close);
+        ret = tmpl->send(web, client, [&](const std::string &tag, PageWriter &out)
+            {
+                if (tag == "menus")
+                {
+                    for (auto it = names.cbegin(); it != names.cend(); ++it)
+                    {
+                        out << "<option value=\"" << *it << "\"" << (selected == *it ? " selected" : "") << ">"
+                            << *it << "</option>";
+                    }
+                }
+                else if (tag == "menuname")
+                {
+                    out << menu_name;
+                }
+                else if (tag == "readonly")
+                {
+                    out << readonly;
+                }
+                else if (tag == "rowspercol")
+                {
+                    out << rowspercol;
+                }
+                else if (tag == "wrapcols")
+                {
+                    out << (wrapcols ? " checked" : "");
+                }
+                else if (tag == "wraprows")
+                {
+                    out << (wraprows ? " checked" : "");
+                }
+                else if (tag.length() > 3)
+                {
+                    //  <?{key}typ?>, <?{key}add?>, <?{key}val?> or <?{key}dly?>
+                    auto it = cmdmap->find(tag.substr(0, tag.length() - 3));
+                    if (it != cmdmap->cend())
+                    {
+                        const Command::Step &step = it->second;
+                        const char *field = tag.c_str() + tag.length() - 3;
+                        if (strcmp(field, "typ") == 0)
+                        {
+                            out << step.type();
+                        }
+                        else if (strcmp(field, "add") == 0)
+                        {
+                            out << step.address();
+                        }
+                        else if (strcmp(field, "val") == 0)
+                        {
+                            out << step.value();
+                        }
+                        else if (strcmp(field, "dly") == 0)
+                        {
+                            out << step.delay();
+                        }
+                    }
+                }
+            });
+        close = !ret;
     }
     return ret;
 }
@@ -104,13 +144,19 @@ bool Remote::menu_post(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &c
             }
         }
 
-        if (menu && name && strlen(name) > 0)
+        const char *btn = rqst.postValue("btn");
+        if (menu && btn && strcmp(btn, "forget") == 0)
+        {
+            menu->forget();
+        }
+        else if (menu && name && strlen(name) > 0)
         {
             const char *value = rqst.postValue("rows");
             if (value)
             {
                 menu->setRowsPerColumn(value);
             }
+            menu->setWrap(rqst.postValue("wrapcols") != nullptr, rqst.postValue("wraprows") != nullptr);
 
             std::vector<const char *> typ;
             std::vector<const char *> add;
@@ -162,8 +208,8 @@ bool Remote::menu_ir_get(WEB *web, ClientHandle client, const JSONMap &msgmap)
     log_->print_debug(1, "ir_get = %d, path = %s\n", msgmap.intValue("ir_get"), msgmap.strValue("path"));
 
     int row = msgmap.intValue("ir_get");
-    Command *cmd = new Command(web, client, msgmap, nullptr);
-    queue_command(cmd);
+    Command *cmd = new Command(web, client, msgmap, nullptr, nullptr);
+    queue_command(cmd, web, client, msgmap);
     return ret;
 }
 
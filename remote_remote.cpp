@@ -2,26 +2,19 @@
 
 #include "remote.h"
 #include "command.h"
-#include "txt.h"
-#include "web_files.h"
+#include "pagetemplate.h"
+#include "irschedule.h"
+#include <string.h>
 
 bool Remote::remote_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close)
 {
-    bool ret = get_rfile(rqst.root());
+    bool ret = get_rfile(rqst.root().c_str());
     if (!ret)
     {
         log_->print("Error loading action file for %s\n", rqst.url().c_str());
         return false;
     }
 
-    const char *data;
-    u16_t datalen;
-    WEB_FILES::get()->get_file("index.html", data, datalen);
-
-    TXT html(data, datalen, 16384);
-
-    while(html.substitute("<?title?>", rfile_.title()));
-
     std::string backurl = rqst.root();
     std::size_t i1 = backurl.rfind('/');
     if (i1 != std::string::npos)
@@ -29,65 +22,105 @@ bool Remote::remote_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &
         backurl = backurl.erase(i1);
     }
     if (backurl.empty()) backurl = "/";
-    if (strcmp(rfile_.filename(), "actions.json") != 0)
+
+    const RemoteFileCache::Page *page = pages_.page(rfile_, backurl);
+    if (!page)
     {
-        html.substitute("<?backloc?>", backurl.c_str());
-        html.substitute("<?backvis?>", "visible");
+        const PageTemplate *tmpl = PageTemplate::get("index.html");
+        if (!tmpl)
+        {
+            return false;
+        }
+
+        //  Hold the page for the cache if it fits the budget, else stream it
+        auto fill = [this, &backurl](const std::string &tag, PageWriter &out) { render_remote(tag, out, backurl); };
+        std::string body;
+        PageWriter out(web, client, tmpl->header(), &body, pages_.pageRoom(rfile_));
+        tmpl->render(out, fill);
+        ret = out.end();
+        page = out.kept() ? pages_.setPage(rfile_, backurl, tmpl->header(), body) : nullptr;
+        if (!page)
+        {
+            if (out.kept())
+            {
+                //  Pinned entries left no room for it after all
+                ret = tmpl->send(web, client, fill);
+            }
+            close = !ret;
+            return ret;
+        }
+    }
+
+    if (rqst.header("If-None-Match") == page->etag)
+    {
+        pages_.notModified();
+        std::string resp("HTTP/1.1 304 Not Modified\r\nETag: ");
+        resp += page->etag;
+        resp += "\r\nCache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n";
+        ret = web->send_data(client, resp.c_str(), resp.length());
     }
     else
     {
-        html.substitute("<?backloc?>", "/");
-        html.substitute("<?backvis?>", "hidden");
+        ret = web->send_data(client, page->header.c_str(), page->header.length()) &&
+              web->send_data(client, page->body.c_str(), page->body.length());
     }
+    close = !ret;
+    return ret;
+}
 
-    std::size_t bi = html.find("<?buttons?>");
-    html.substitute("<?buttons?>", "");
-    TXT button(640);
-    std::string background;
-    std::string color;
-    std::string fill;
-    std::string label;
-
-    for (auto it = rfile_.buttons().cbegin(); it != rfile_.buttons().cend(); ++it)
+void Remote::render_remote(const std::string &tag, PageWriter &out, const std::string &backurl)
+{
+    bool home = strcmp(rfile_->filename(), "actions.json") == 0;
+    if (tag == "title")
     {
-        int pos = it->position();
-        int row = (pos - 1) / 5 + 1;
-        int col = (pos - 1) % 5 + 1;
-
-        if (strlen(it->redirect()) > 0 || it->actions().size() > 0)
-        {
-            button = "<button type=\"submit\"<?class?> style=\"grid-row:!row!; grid-column:!col!; color: {0}; background: {1};\""
-                " name=\"btnVal\" value=\"!pos!\">\n"
-                "  !label!\n"
-                "</button>\n";
+        out << rfile_->title();
+    }
+    else if (tag == "backloc")
+    {
+        out << (home ? "/" : backurl.c_str());
+    }
+    else if (tag == "backvis")
+    {
+        out << (home ? "hidden" : "visible");
+    }
+    else if (tag == "buttons")
+    {
+        std::string background;
+        std::string color;
+        std::string fill;
+        std::string label;
 
-            button.substitute("<?class?>", strlen(it->redirect()) > 0 && it->actions().size() == 0 ? " class=\"redir\"" : "");
-        }
-        else
+        for (auto it = rfile_->buttons().cbegin(); it != rfile_->buttons().cend(); ++it)
         {
-            button = "<span style=\"grid-row:!row!; grid-column:!col!; color: {0}; background: transparent; font-size: 24px; font-weight: bold;\">\n"
-                "  !label!\n"
-                "</span>\n";
-        }
-        button.substitute("!row!", row);
-        button.substitute("!col!", col);
-        button.substitute("!pos!", pos);
+            int pos = it->position();
+            int row = (pos - 1) / 5 + 1;
+            int col = (pos - 1) % 5 + 1;
 
-        it->getColors(background, color, fill);
+            it->getColors(background, color, fill);
+            label = it->label();
+            get_label(label, background, color, fill);
 
-        label = it->label();
-        get_label(label, background, color, fill);
-        button.substitute("!label!", label);
-        while (button.substitute("{0}", color));
-        while (button.substitute("{1}", background));
-        while (button.substitute("{2}", fill));
-        html.insert(bi, button.data());
-        bi += button.datasize();
+            if (strlen(it->redirect()) > 0 || it->actions().size() > 0)
+            {
+                out << "<button type=\"submit\"";
+                if (strlen(it->redirect()) > 0 && it->actions().size() == 0)
+                {
+                    out << " class=\"redir\"";
+                }
+                out << " style=\"grid-row:" << row << "; grid-column:" << col << "; color: " << color
+                    << "; background: " << background << ";\" name=\"btnVal\" value=\"" << pos << "\">\n"
+                    << "  " << label << "\n"
+                    << "</button>\n";
+            }
+            else
+            {
+                out << "<span style=\"grid-row:" << row << "; grid-column:" << col << "; color: " << color
+                    << "; background: transparent; font-size: 24px; font-weight: bold;\">\n"
+                    << "  " << label << "\n"
+                    << "</span>\n";
+            }
+        }
     }
-
-    ret = send_http(web, client, html, close);
-   
-    return ret;
 }
 
 bool Remote::remote_button(WEB *web, ClientHandle client, const JSONMap &msgmap)
@@ -97,18 +130,41 @@ bool Remote::remote_button(WEB *web, ClientHandle client, const JSONMap &msgmap)
         msgmap.intValue("btnVal"), msgmap.strValue("action"), msgmap.strValue("path"), msgmap.realValue("duration"));
 
     int button = msgmap.intValue("btnVal");
-    std::string url = msgmap.strValue("path");
+    const char *url = msgmap.strValue("path");
+    get_rfile(url);
+    RemoteFile::Button *btn = rfile_->getButton(button);
+    if (btn)
+    {
+        ret = true;
+        Command *cmd = new Command(web, client, msgmap, rfile_, btn);
+        queue_command(cmd, web, client, msgmap);
+    }
+    else
+    {
+        log_->print_error("Remote::remote_button  Did not find button %d in %s\n", button, url);
+    }
+    return ret;
+}
+
+bool Remote::remote_button_time(WEB *web, ClientHandle client, const JSONMap &msgmap)
+{
+    bool ret = false;
+    int button = msgmap.intValue("btn_time");
+    const char *url = msgmap.strValue("path");
     get_rfile(url);
-    RemoteFile::Button *btn = rfile_.getButton(button);
+    RemoteFile::Button *btn = rfile_->getButton(button);
     if (btn)
     {
         ret = true;
-        Command *cmd = new Command(web, client, msgmap, btn);
-        queue_command(cmd);
+        uint32_t msec = IRSchedule::duration(btn->plan(), btn->plan().size());
+        char msg[96];
+        snprintf(msg, sizeof(msg), "{\"func\":\"time_resp\",\"button\":\"%d\",\"duration\":\"%lu\"}",
+                 button, static_cast<unsigned long>(msec));
+        web->send_message(client, msg);
     }
     else
     {
-        log_->print_error("Remote::remote_button  Did not find button %d in %s\n", button, url.c_str());
+        log_->print_error("Remote::remote_button_time  Did not find button %d in %s\n", button, url);
     }
     return ret;
 }
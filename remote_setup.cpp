@@ -2,85 +2,76 @@
 
 #include "remote.h"
 #include "command.h"
-#include "txt.h"
-#include "web_files.h"
+#include "pagetemplate.h"
 
 bool Remote::setup_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close)
 {
     bool ret = false;
     std::string url = rqst.root();
-    std::smatch match;
-    static std::regex reg("^(.*)/setup(|\\.html)$", std::regex_constants::extended);
-    if (std::regex_match(url, match, reg))
-    {
-        std::string base_url = match[1].str();
-        if (base_url.empty()) base_url = "/";
-
-        std::string done = rqst.query("done");
-        if (done == "true")
-        {
-            rfile_.clear();
-            efile_.clear();
-            add_missing_actions();
-            std::string resp("HTTP/1.1 303 OK\r\nLocation: " + base_url + "\r\n"
-                            "Connection: keep-alive\r\n\r\n");
-            web->send_data(client, resp.c_str(), resp.length());
-            close = false;
-            return true;
-        }
-
-        ret = get_efile(base_url, web, client, rqst, close);
-        if (!ret)
-        {
-            log_->print("Error loading action file for GET %s\n", rqst.url().c_str());
-            //  Return true as get_efile has issued response
-            return true;
-        }
+    std::string base_url = route_.base(url);
+    if (base_url.empty()) base_url = "/";
 
-        const char *data;
-        u16_t datalen;
-        if (WEB_FILES::get()->get_file("setup.html", data, datalen))
-        {
-            TXT html(data, datalen, 16384);
-
-            while(html.substitute("<?title?>", efile_.title()));
+    std::string done = rqst.query("done");
+    if (done == "true")
+    {
+        efile_.clear();
+        add_missing_actions();
+        std::string resp("HTTP/1.1 303 OK\r\nLocation: " + base_url + "\r\n"
+                        "Connection: keep-alive\r\n\r\n");
+        web->send_data(client, resp.c_str(), resp.length());
+        close = false;
+        return true;
+    }
 
-            bool modified = efile_.isModified();
-            html.substitute("<?modified?>", modified ? "unsaved" : "saved");
+    ret = get_efile(base_url, web, client, rqst, close);
+    if (!ret)
+    {
+        log_->print("Error loading action file for GET %s\n", rqst.url().c_str());
+        //  Return true as get_efile has issued response
+        return true;
+    }
 
-            std::size_t bi = html.find("<?buttons?>");
-            html.substitute("<?buttons?>", "");
-            int nb = efile_.maxButtonPosition();
-            nb = (nb + 9) / 5 * 5 + 1;
-            std::string button;
-            button.reserve(512);
-            for (int pos = 1; pos < nb; pos++)
+    const PageTemplate *tmpl = PageTemplate::get("setup.html");
+    if (tmpl)
+    {
+        int nb = efile_.maxButtonPosition();
+        nb = (nb + 9) / 5 * 5 + 1;
+        ret = tmpl->send(web, client, [this, nb](const std::string &tag, PageWriter &out)
             {
-                RemoteFile::Button *btn = efile_.getButton(pos);
-                std::string background;
-                std::string color;
-                std::string fill;
-                RemoteFile::Button::getColors(btn, background, color, fill);
-
-                button = "<button type=\"button\" style=\"";
-                int row = (pos - 1) / 5 + 1;
-                int col = (pos - 1) % 5 + 1;
-                button += "grid-row:" + std::to_string(row) + "; grid-column:" + std::to_string(col);
-                button += "; color: " + color + "; background: " + background + ";\" ";
-                button += "onclick=\"btnAction(" + std::to_string(pos) + ")\">";
-                if (btn)
+                if (tag == "title")
                 {
-                    std::string label = btn->label();
-                    get_label(label, background, color, fill);
-                    button += label;
+                    out << efile_.title();
                 }
-                button += "</button>";
-                html.insert(bi, button.c_str());
-                bi += button.length();
-            }
-
-            ret = send_http(web, client, html, close);
-        }
+                else if (tag == "modified")
+                {
+                    out << (efile_.isModified() ? "unsaved" : "saved");
+                }
+                else if (tag == "buttons")
+                {
+                    std::string background;
+                    std::string color;
+                    std::string fill;
+                    for (int pos = 1; pos < nb; pos++)
+                    {
+                        RemoteFile::Button *btn = efile_.getButton(pos);
+                        RemoteFile::Button::getColors(btn, background, color, fill);
+
+                        int row = (pos - 1) / 5 + 1;
+                        int col = (pos - 1) % 5 + 1;
+                        out << "<button type=\"button\" style=\"grid-row:" << row << "; grid-column:" << col
+                            << "; color: " << color << "; background: " << background << ";\" "
+                            << "onclick=\"btnAction(" << pos << ")\">";
+                        if (btn)
+                        {
+                            std::string label = btn->label();
+                            get_label(label, background, color, fill);
+                            out << label;
+                        }
+                        out << "</button>";
+                    }
+                }
+            });
+        close = !ret;
     }
     return ret;
 }
@@ -90,38 +81,33 @@ bool Remote::setup_post(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &
     //rqst.printPostData();
     bool ret = false;
     std::string url = rqst.root();
-    std::smatch match;
-    static std::regex reg("^(.*)/setup(|\\.html)$", std::regex_constants::extended);
-    if (std::regex_match(url, match, reg))
+    std::string base_url = route_.base(url);
+    ret = get_efile(base_url, web, client, rqst, close);
+    if (!ret)
     {
-        std::string base_url = match[1].str();
-        ret = get_efile(base_url, web, client, rqst, close);
-        if (!ret)
-        {
-            log_->print("Error loading action file for POST %s\n", rqst.url().c_str());
-            //  Return true as get_efile has sent response
-            return true;
-        }
+        log_->print("Error loading action file for POST %s\n", rqst.url().c_str());
+        //  Return true as get_efile has sent response
+        return true;
+    }
 
-        const char *title = rqst.postValue("title");
-        if (title)
-        {
-            efile_.setTitle(title);
-        }
+    const char *title = rqst.postValue("title");
+    if (title)
+    {
+        efile_.setTitle(title);
+    }
 
-        const char *save = rqst.postValue("save");
-        if (efile_.isModified() && save && strcmp(save, "true") == 0)
+    const char *save = rqst.postValue("save");
+    if (efile_.isModified() && save && strcmp(save, "true") == 0)
+    {
+        if (efile_.saveFile())
         {
-            if (efile_.saveFile())
-            {
-                efile_.clearModified();
-                rfile_.clear();
-            }
+            efile_.clearModified();
+            pages_.invalidate(efile_.filename());
         }
-
-        ret = setup_get(web, client, rqst, close);
     }
 
+    ret = setup_get(web, client, rqst, close);
+
     return ret;
 }
 
@@ -129,76 +115,90 @@ bool Remote::setup_btn_get(WEB *web, ClientHandle client, HTTPRequest &rqst, boo
 {
     bool ret = false;
     std::string url = rqst.root();
-    std::smatch match;
-    static std::regex reg("^(.*)/setup(|\\.html)/([0-9]+)$", std::regex_constants::extended);
-    if (std::regex_match(url, match, reg))
-    {
-        std::string base_url = match[1].str();
-        if (base_url.empty()) base_url = "/";
-        int pos = to_u16(match[3].str());
-        log_->print_debug(1, "GET '%s' button at %d\n", base_url.c_str(), pos);
+    std::string base_url = route_.base(url);
+    if (base_url.empty()) base_url = "/";
+    int pos = route_.number;
+    log_->print_debug(1, "GET '%s' button at %d\n", base_url.c_str(), pos);
 
-        ret = get_efile(base_url, web, client, rqst, close);
-        if (!ret)
-        {
-            log_->print("Error loading action file for GET %s\n", rqst.url().c_str());
-            //  Return true as get_efile has sent response
-            return true;
-        }
+    ret = get_efile(base_url, web, client, rqst, close);
+    if (!ret)
+    {
+        log_->print("Error loading action file for GET %s\n", rqst.url().c_str());
+        //  Return true as get_efile has sent response
+        return true;
+    }
 
-        RemoteFile::Button newbtn(pos);
-        RemoteFile::Button *button = efile_.getButton(pos);
-        int nb = efile_.maxButtonPosition();
-        nb = (nb + 9) / 5 * 5 + 1;
-        if (pos > 0 && pos <= nb)
-        {            
-            if (!button)
-            {
-                button = &newbtn;
-            }
-        }
-        else
+    RemoteFile::Button newbtn(pos);
+    RemoteFile::Button *button = efile_.getButton(pos);
+    int nb = efile_.maxButtonPosition();
+    nb = (nb + 9) / 5 * 5 + 1;
+    if (pos > 0 && pos <= nb)
+    {            
+        if (!button)
         {
-            log_->print("Invalid button %d for %s\n", pos, rqst.url().c_str());
-            return false;
+            button = &newbtn;
         }
+    }
+    else
+    {
+        log_->print("Invalid button %d for %s\n", pos, rqst.url().c_str());
+        return false;
+    }
 
-        const char *data;
-        u16_t datalen;
-        if (WEB_FILES::get()->get_file("setupbtn.html", data, datalen))
-        {
-            TXT html(data, datalen, 4096);
-            html.substitute("<?label?>", button->label());
-            html.substitute("<?color?>", button->color());
-            html.substitute("<?redirect?>", button->redirect());
-            html.substitute("<?repeat?>", button->repeat());
-            html.substitute("<?swap?>", button->position());
-
-            html.substitute("<?btn?>", pos);
-            while(html.substitute("<?path?>", base_url));
-            html.substitute("<?btncount?>", button->actions().size());
-
-            std::size_t bi = html.find("<?steps?>");
-            html.substitute("<?steps?>", "");
-            std::string action;
-            action.reserve(512);
-            int row = 0;
-            for (auto it = button->actions().cbegin(); it != button->actions().cend(); ++it, ++row)
+    const PageTemplate *tmpl = PageTemplate::get("setupbtn.html");
+    if (tmpl)
+    {
+        ret = tmpl->send(web, client, [button, pos, &base_url](const std::string &tag, PageWriter &out)
             {
-                action = "<tr>";
-                action += "<td><input type=\"text\" name=\"typ\" value=\"" + std::string(it->type()) + "\" /></td>";
-                action += "<td><input type=\"text\" pattern=\"(0x[0-9a-fA-F]+|[0-9]*)\" name=\"add\" value=\"" + std::to_string(it->address()) + "\" /></td>";
-                action += "<td><input type=\"text\" pattern=\"(0x[0-9a-fA-F]+|[0-9]*)\" name=\"val\" value=\"" + std::to_string(it->value()) + "\" /></td>";
-                action += "<td><input type=\"number\" name=\"dly\" value=\"" + std::to_string(it->delay()) + "\" /></td>";
-                action += "<td><button type=\"submit\" name=\"add_row\" value=\"" + std::to_string(row) + "\">+</button></td>";
-                action += "<td><button type=\"button\" onclick=\"load_ir(" + std::to_string(row) + ");\">&lt;-IR</button></td>";
-                action += "</tr>";
-                html.insert(bi, action.c_str());
-                bi += action.length();
-            }
-
-            ret = send_http(web, client, html, close);
-        }
+                if (tag == "label")
+                {
+                    out << button->label();
+                }
+                else if (tag == "color")
+                {
+                    out << button->color();
+                }
+                else if (tag == "redirect")
+                {
+                    out << button->redirect();
+                }
+                else if (tag == "repeat")
+                {
+                    out << button->repeat();
+                }
+                else if (tag == "swap")
+                {
+                    out << button->position();
+                }
+                else if (tag == "btn")
+                {
+                    out << pos;
+                }
+                else if (tag == "path")
+                {
+                    out << base_url;
+                }
+                else if (tag == "btncount")
+                {
+                    out << static_cast<int>(button->actions().size());
+                }
+                else if (tag == "steps")
+                {
+                    int row = 0;
+                    for (auto it = button->actions().cbegin(); it != button->actions().cend(); ++it, ++row)
+                    {
+                        out << "<tr>"
+                            << "<td><input type=\"text\" name=\"typ\" value=\"" << it->type() << "\" /></td>"
+                            << "<td><input type=\"text\" pattern=\"(0x[0-9a-fA-F]+|[0-9]*)\" name=\"add\" value=\"" << it->address() << "\" /></td>"
+                            << "<td><input type=\"text\" pattern=\"(0x[0-9a-fA-F]+|[0-9]*)\" name=\"val\" value=\"" << it->value() << "\" /></td>"
+                            << "<td><input type=\"number\" name=\"dly\" value=\"" << it->delay() << "\" /></td>"
+                            << "<td><button type=\"submit\" name=\"add_row\" value=\"" << row << "\">+</button></td>"
+                            << "<td><button type=\"button\" onclick=\"load_ir(" << row << ");\">&lt;-IR</button></td>"
+                            << "</tr>";
+                    }
+                }
+            });
+        close = !ret;
     }
     return ret;
 }
@@ -208,148 +208,144 @@ bool Remote::setup_btn_post(WEB *web, ClientHandle client, HTTPRequest &rqst, bo
     //rqst.printPostData();
     bool ret = false;
     std::string url = rqst.root();
-    std::smatch match;
-    static std::regex reg("^(.*)/setup(|\\.html)/([0-9]+)$", std::regex_constants::extended);
-    if (std::regex_match(url, match, reg))
-    {
-        std::string base_url = match[1].str();
-        int pos = to_u16(match[3].str());
-        log_->print_debug(1, "POST '%s' button at %d\n", base_url.c_str(), pos);
+    std::string base_url = route_.base(url);
+    int pos = route_.number;
+    log_->print_debug(1, "POST '%s' button at %d\n", base_url.c_str(), pos);
 
-        ret = get_efile(base_url, web, client, rqst, close);
-        if (!ret)
-        {
-            log_->print("Error loading action file for POST %s\n", rqst.url().c_str());
-            //  Return true as get_efile has sent response
-            return true;
-        }
+    ret = get_efile(base_url, web, client, rqst, close);
+    if (!ret)
+    {
+        log_->print("Error loading action file for POST %s\n", rqst.url().c_str());
+        //  Return true as get_efile has sent response
+        return true;
+    }
 
-        const char *value = rqst.postValue("lbl");
-        if (!value) value = "";
-        RemoteFile::Button *button = efile_.getButton(pos);
-        if (button)
+    const char *value = rqst.postValue("lbl");
+    if (!value) value = "";
+    RemoteFile::Button *button = efile_.getButton(pos);
+    if (button)
+    {
+        if (*value == 0)
         {
-            if (*value == 0)
+            if (efile_.deleteButton(pos))
             {
-                if (efile_.deleteButton(pos))
-                {
-                    button = nullptr;
-                }
+                button = nullptr;
             }
         }
-        else
+    }
+    else
+    {
+        if (*value != 0)
         {
-            if (*value != 0)
-            {
-                button = efile_.addButton(pos, value, "", "", 0);
-            }
+            button = efile_.addButton(pos, value, "", "", 0);
         }
-        if (button)
-        {
-            if (value) button->setLabel(value);
+    }
+    if (button)
+    {
+        if (value) button->setLabel(value);
 
-            value = rqst.postValue("bck");
-            if (value) button->setColor(value);
+        value = rqst.postValue("bck");
+        if (value) button->setColor(value);
 
-            value = rqst.postValue("red");
-            if (value) button->setRedirect(value);
+        value = rqst.postValue("red");
+        if (value) button->setRedirect(value);
 
-            value = rqst.postValue("repeat");
-            if (value) button->setRepeat(to_u16(value));
+        value = rqst.postValue("repeat");
+        if (value) button->setRepeat(to_u16(value));
 
-            value = rqst.postValue("swap");
-            if (value)
+        value = rqst.postValue("swap");
+        if (value)
+        {
+            int newpos = to_u16(value);
+            if (newpos != pos && newpos > 0 && newpos <= 100)
             {
-                int newpos = to_u16(value);
-                if (newpos != pos && newpos > 0 && newpos <= 100)
-                {
-                    efile_.changePosition(button, newpos);
-                    pos = newpos;
-                    url = base_url + "/setup/" + std::to_string(pos);
-                }
+                efile_.changePosition(button, newpos);
+                pos = newpos;
+                url = base_url + "/setup/" + std::to_string(pos);
             }
+        }
 
-            std::vector<const char *> typ;
-            std::vector<const char *> add;
-            std::vector<const char *> val;
-            std::vector<const char *> dly;
-            rqst.postArray("typ", typ);
-            rqst.postArray("add", add);
-            rqst.postArray("val", val);
-            rqst.postArray("dly", dly);
-
-            int nn = typ.size();
-            if (add.size() == nn && val.size() == nn && dly.size() == nn)
+        std::vector<const char *> typ;
+        std::vector<const char *> add;
+        std::vector<const char *> val;
+        std::vector<const char *> dly;
+        rqst.postArray("typ", typ);
+        rqst.postArray("add", add);
+        rqst.postArray("val", val);
+        rqst.postArray("dly", dly);
+
+        int nn = typ.size();
+        if (add.size() == nn && val.size() == nn && dly.size() == nn)
+        {
+            int actno = 0;
+            for (int seqno = 0; seqno < nn; seqno++)
             {
-                int actno = 0;
-                for (int seqno = 0; seqno < nn; seqno++)
-                {
-                    const char *type = typ.at(seqno);
-                    int address = to_u16(add.at(seqno));
-                    int value = to_u16(val.at(seqno));
-                    int delay = to_u16(dly.at(seqno));
+                const char *type = typ.at(seqno);
+                int address = to_u16(add.at(seqno));
+                int value = to_u16(val.at(seqno));
+                int delay = to_u16(dly.at(seqno));
 
-                    if (!type || *type == 0)
+                if (!type || *type == 0)
+                {
+                    button->deleteAction(actno);
+                }
+                else
+                {
+                    if (actno < button->actions().size())
                     {
-                        button->deleteAction(actno);
+                        RemoteFile::Button::Action *action = button->action(actno);
+                        action->setType(type);
+                        action->setAddress(address);
+                        action->setValue(value);
+                        action->setDelay(delay);
                     }
                     else
                     {
-                        if (actno < button->actions().size())
-                        {
-                            RemoteFile::Button::Action *action = button->action(actno);
-                            action->setType(type);
-                            action->setAddress(address);
-                            action->setValue(value);
-                            action->setDelay(delay);
-                        }
-                        else
-                        {
-                            button->addAction(type, address, value, delay);
-                        }
-                        actno += 1;
+                        button->addAction(type, address, value, delay);
                     }
+                    actno += 1;
                 }
-
-                while (button->actions().size() > nn)
-                {
-                    button->deleteAction(nn);
-                }
-            }
-            else
-            {
-                log_->print("POST array sizes do not match\n");
             }
 
-            const char *add_row = rqst.postValue("add_row");
-            if (add_row)
+            while (button->actions().size() > nn)
             {
-                int before = to_u16(add_row);
-                if (before >= 0 && before < button->actions().size())
-                {
-                    button->insertAction(before);
-                }
+                button->deleteAction(nn);
             }
         }
-
-        const char *btn = rqst.postValue("button");
-        if (btn && strcmp(btn, "done") == 0)
+        else
         {
-            url = base_url + "/setup";
+            log_->print("POST array sizes do not match\n");
         }
 
-        if (url == rqst.root())
+        const char *add_row = rqst.postValue("add_row");
+        if (add_row)
         {
-            ret = setup_btn_get(web, client, rqst, close);
-        }
-        else
-        {
-            std::string resp("HTTP/1.1 303 OK\r\nLocation: " + url + "\r\n"
-                            "Connection: keep-alive\r\n\r\n");
-            web->send_data(client, resp.c_str(), resp.length());
-            close = false;
-            ret = true;
+            int before = to_u16(add_row);
+            if (before >= 0 && before < button->actions().size())
+            {
+                button->insertAction(before);
+            }
         }
+        button->compile();
+    }
+
+    const char *btn = rqst.postValue("button");
+    if (btn && strcmp(btn, "done") == 0)
+    {
+        url = base_url + "/setup";
+    }
+
+    if (url == rqst.root())
+    {
+        ret = setup_btn_get(web, client, rqst, close);
+    }
+    else
+    {
+        std::string resp("HTTP/1.1 303 OK\r\nLocation: " + url + "\r\n"
+                        "Connection: keep-alive\r\n\r\n");
+        web->send_data(client, resp.c_str(), resp.length());
+        close = false;
+        ret = true;
     }
     return ret;
 }
@@ -362,21 +358,16 @@ bool Remote::setup_ir_get(WEB *web, ClientHandle client, const JSONMap &msgmap)
 
     int row = msgmap.intValue("ir_get");
     std::string url = msgmap.strValue("path");
-    std::smatch match;
-    static std::regex reg("^(.*)/setup(|\\.html)/([0-9]+)$", std::regex_constants::extended);
-    if (std::regex_match(url, match, reg))
-    {
-        std::string base_url = match[1].str();
-        int pos = to_u16(match[3].str().c_str());
-        log_->print_debug(1, "IR_Get '%s' button %d row %d\n", base_url.c_str(), pos, row);
+    std::string base_url = route_.base(url);
+    int pos = route_.number;
+    log_->print_debug(1, "IR_Get '%s' button %d row %d\n", base_url.c_str(), pos, row);
 
-        ret = get_efile(base_url);
-        RemoteFile::Button *btn = efile_.getButton(pos);
-        if (ret)
-        {
-            Command *cmd = new Command(web, client, msgmap, btn);
-            queue_command(cmd);
-        }
+    ret = get_efile(base_url);
+    RemoteFile::Button *btn = efile_.getButton(pos);
+    if (ret)
+    {
+        Command *cmd = new Command(web, client, msgmap, &efile_, btn);
+        queue_command(cmd, web, client, msgmap);
     }
     return ret;
 }
@@ -393,14 +384,21 @@ bool Remote::prompt_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &
         return true;
     }
 
-    const char *data;
-    u16_t datalen;
-    if (WEB_FILES::get()->get_file("editprompt.html", data, datalen))
+    const PageTemplate *tmpl = PageTemplate::get("editprompt.html");
+    if (tmpl)
     {
-        TXT html(data, datalen);
-        html.substitute("<?editurl?>", editurl);
-        html.substitute("<?rqsturl?>", rqsturl);
-        ret = send_http(web, client, html, close);
+        ret = tmpl->send(web, client, [&editurl, &rqsturl](const std::string &tag, PageWriter &out)
+            {
+                if (tag == "editurl")
+                {
+                    out << editurl;
+                }
+                else if (tag == "rqsturl")
+                {
+                    out << rqsturl;
+                }
+            });
+        close = !ret;
     }
     return ret;
 }
@@ -3,37 +3,37 @@
 #include "remote.h"
 #include "irdevice.h"
 #include "command.h"
-#include "txt.h"
-#include "web_files.h"
+#include "irprocessor.h"
+#include "pagetemplate.h"
 #include <stdio.h>
 
 bool Remote::test_get(WEB *web, ClientHandle client, HTTPRequest &rqst, bool &close)
 {
     bool ret = false;
-    const char *data;
-    u16_t datalen;
-    if (WEB_FILES::get()->get_file("test.html", data, datalen))
+    const PageTemplate *tmpl = PageTemplate::get("test.html");
+    if (tmpl)
     {
-        TXT html(data, datalen, 2048);
-
-        std::string type_opts;
         std::vector<std::string> types;
         IR_Device::protocols(types);
-        for (auto it = types.cbegin(); it != types.cend(); ++it)
-        {
-            type_opts += "<option value=\"" + *it + "\">" + *it + "</option>";
-        }
-        html.substitute("<?ir_types?>", type_opts);
-
-        ret = send_http(web, client, html, close);
+        ret = tmpl->send(web, client, [&types](const std::string &tag, PageWriter &out)
+            {
+                if (tag == "ir_types")
+                {
+                    for (auto it = types.cbegin(); it != types.cend(); ++it)
+                    {
+                        out << "<option value=\"" << *it << "\">" << *it << "</option>";
+                    }
+                }
+            });
+        close = !ret;
     }
     return ret;
 }
 
 bool Remote::test_send(WEB *web, ClientHandle client, const JSONMap &msgmap)
 {
-    Command *cmd = new Command(web, client, msgmap, nullptr);
-    queue_command(cmd);
+    Command *cmd = new Command(web, client, msgmap, nullptr, nullptr);
+    queue_command(cmd, web, client, msgmap);
     return true;
 }
 
@@ -42,7 +42,48 @@ bool Remote::test_ir_get(WEB *web, ClientHandle client, const JSONMap &msgmap)
     bool ret = true;
     log_->print_debug(1, "test_ir_get, path = %s\n", msgmap.strValue("path"));
 
-    Command *cmd = new Command(web, client, msgmap, nullptr);
-    queue_command(cmd);
+    Command *cmd = new Command(web, client, msgmap, nullptr, nullptr);
+    queue_command(cmd, web, client, msgmap);
     return ret;
 }
+
+bool Remote::test_sniff(WEB *web, ClientHandle client, const JSONMap &msgmap)
+{
+    sniff_clients_.insert(client);
+    Command *cmd = new Command(web, client, msgmap, nullptr, nullptr);
+    queue_command(cmd, web, client, msgmap);
+    return true;
+}
+
+bool Remote::test_sniff_log(WEB *web, ClientHandle client, const JSONMap &msgmap)
+{
+    std::string resp;
+    sniff_clients_.insert(client);
+    sniff_message(resp);
+    return web->send_message(client, resp);
+}
+
+void Remote::sniff_message(std::string &message)
+{
+    IR_Processor *ir = ir_;
+    if (ir)
+    {
+        ir->getSniffLog(sniff_log_);
+    }
+    const std::vector<IR_Sniffer::Frame> &frames = sniff_log_.frames;
+    bool sniffing = sniff_log_.sniffing;
+    uint32_t now = to_ms_since_boot(get_absolute_time());
+    message = "{\"func\":\"sniff_log\",\"sniff\":\"" + std::string(sniffing ? "1" : "0") + "\",\"frames\":[";
+    const char *sep = "";
+    for (auto it = frames.cbegin(); it != frames.cend(); ++it)
+    {
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%s{\"seq\":%lu,\"age\":%lu,\"time\":%lu,\"address\":%u,\"value\":%u,\"repeats\":%u,\"times\":%u,\"type\":\"",
+                 sep, static_cast<unsigned long>(it->seq), static_cast<unsigned long>(now - it->at),
+                 static_cast<unsigned long>(it->time), it->address, it->value, it->repeats, it->times);
+        message += buf;
+        message += it->type + "\"}";
+        sep = ",";
+    }
+    message += "]}";
+}
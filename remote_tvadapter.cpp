@@ -13,7 +13,7 @@ bool Remote::tvadapter_button(WEB *web, ClientHandle client, const JSONMap &msgm
     const char *action = msgmap.strValue("func", "");
     if (strlen(action) > 7) action += 7;
     get_rfile("/tvadapter.html");
-    int btnpos = rfile_.findButtonPosition(lbl);
+    int btnpos = rfile_->findButtonPosition(lbl);
     if (btnpos != -1)
     {
         log_->print_debug(1, "TV adapter button %s at position %d\n", lbl, btnpos);
@@ -42,7 +42,7 @@ bool Remote::tvadapter_input(WEB *web, ClientHandle client, const JSONMap &msgma
         {
             char lbl[10];
             sprintf(lbl, "Input %d", addrs[ii]);
-            int btnpos = rfile_.findButtonPosition(lbl);
+            int btnpos = rfile_->findButtonPosition(lbl);
             if (btnpos != -1)
             {
                 log_->print_debug(1, "TV adapter button %s at position %d\n", lbl, btnpos);
@@ -11,8 +11,11 @@
 #include <sys/stat.h>
 
 
+uint32_t RemoteFile::generations_ = 0;
+
 void RemoteFile::clear()
 {
+    generation_ = ++generations_;
     filename_.clear();
     title_.clear();
     buttons_.clear();
@@ -22,13 +25,12 @@ void RemoteFile::clear()
     modified_ = false;
 }
 
-bool RemoteFile::loadForURL(const std::string &url)
+bool RemoteFile::loadForURL(const char *url)
 {
-    std::string actfile = urlToAction(url);
-    bool ret = actfile == filename_.str();
+    bool ret = isActionFor(url, filename_.str());
     if (!ret)
     {
-        ret = loadFile(actfile.c_str());
+        ret = loadFile(urlToAction(url).c_str());
     }
     return ret;
 }
@@ -342,11 +344,22 @@ bool RemoteFile::Button::loadFromJSON(const json_t *json)
             }
         }
     }
+    compile();
     modified_ = false;
 
     return ret;
 }
 
+void RemoteFile::Button::compile()
+{
+    plan_.clear();
+    plan_.reserve(actions_.size());
+    for (auto it = actions_.cbegin(); it != actions_.cend(); ++it)
+    {
+        plan_.add(it->type(), it->address(), it->value(), it->delay());
+    }
+}
+
 void RemoteFile::Button::outputJSON(std::ostream &strm) const
 {
     strm << "{\"pos\":" << position() << ","
@@ -373,6 +386,7 @@ void RemoteFile::Button::clear()
     redirect_.clear();
     repeat_ = 0;
     actions_.clear();
+    plan_.clear();
 }
 
 void RemoteFile::Button::clearActions()
@@ -584,6 +598,25 @@ std::string RemoteFile::urlToAction(const std::string &path)
     return ret;
 }
 
+bool RemoteFile::isActionFor(const char *path, const char *file)
+{
+    if (*path == '/') ++path;
+    const char *dot = strrchr(path, '.');
+    size_t len = dot ? dot - path : strlen(path);
+    bool index = len == 0 || (len == 5 && strncmp(path, "index", 5) == 0);
+    bool ret = strncmp(file, "actions", 7) == 0;
+    file += ret ? 7 : 0;
+    if (ret && !index)
+    {
+        ret = *file++ == '_';
+        for (size_t ii = 0; ret && ii < len; ii++)
+        {
+            ret = *file++ == (path[ii] == '/' ? '_' : path[ii]);
+        }
+    }
+    return ret && strcmp(file, ".json") == 0;
+}
+
 std::string RemoteFile::actionToURL(const std::string &file)
 {
     std::size_t i1 = file.find("actions");
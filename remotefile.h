@@ -4,8 +4,11 @@
 #define REMOTFILE_H
 
 #include "jsonstring.h"
+#include "irplan.h"
+#include <atomic>
 #include <string>
 #include <string.h>
+#include <stdint.h>
 #include <list>
 #include <set>
 #include <vector>
@@ -67,6 +70,7 @@ public:
         int                 repeat_;            // Repeat interval (msec)
         int                 position_;          // Position index
         ActionList          actions_;           // Actions to be performed
+        IRPlan              plan_;              // Actions compiled for sending
         bool                modified_;          // Modified flag
 
         void setPosition(int position) { modified_ = position_ != position; position_ = position; }
@@ -99,6 +103,17 @@ public:
         const ActionList &actions() const { return actions_; }
         Action *action(int seqno) { return (seqno >= 0 && seqno < actions_.size()) ? &actions_[seqno] : nullptr; }
 
+        /**
+         * @brief   Get the compiled actions
+         * 
+         * @details Compiled when the button loads. Call compile after editing
+         *          the actions.
+         * 
+         * @return  Compiled plan
+         */
+        const IRPlan &plan() const { return plan_; }
+        void compile();
+
         bool loadFromJSON(const json_t *json);
         void outputJSON(std::ostream &strm) const;
 
@@ -158,6 +173,10 @@ private:
     char                    *data_;             // File data
     size_t                  datasize_;          // Data block size
     bool                    modified_;          // Modified flag
+    uint32_t                generation_;        // Changes each time the file is cleared or reloaded
+    mutable std::atomic<int> pins_;             // Commands referring to the buttons
+
+    static uint32_t         generations_;       // Generation counter
 
     bool load();
     bool loadJSON(const json_t *json);
@@ -166,10 +185,30 @@ private:
     RemoteFile &operator =(const RemoteFile &);
 
 public:
-    RemoteFile() : data_(nullptr), datasize_(0), modified_(false) {}
+    RemoteFile() : data_(nullptr), datasize_(0), modified_(false), generation_(++generations_), pins_(0) {}
     ~RemoteFile() { clear(); }
 
     const char *filename() const { return filename_.str(); }
+    size_t dataSize() const { return datasize_; }
+
+    /**
+     * @brief   Get load generation
+     * 
+     * @details Pointers into the file (buttons, actions) stay valid while this is unchanged
+     * 
+     * @return  Generation number
+     */
+    uint32_t generation() const { return generation_; }
+
+    /**
+     * @brief   Keep the file loaded while a command refers to it
+     * 
+     * @details A cache holding the file does not clear or reload it while
+     *          pinned. Pins are taken and released on either core.
+     */
+    void pin() const { ++pins_; }
+    void unpin() const { --pins_; }
+    bool pinned() const { return pins_ != 0; }
 
     const char *title() const { return title_.str(); }
     void setTitle(const char *title) { modified_ |= strcmp(title_.str(), title) != 0; title_ = title; }
@@ -242,7 +281,7 @@ public:
     bool changePosition(Button *button, int newpos);
 
     void clear();
-    bool loadForURL(const std::string &url);
+    bool loadForURL(const char *url);
     bool loadFile(const char *filename);
     bool loadString(const std::string &data, const char *filename);
     bool loadJSON(const json_t *json, const char *filename);
@@ -273,6 +312,18 @@ public:
      */
     static std::string urlToAction(const std::string &path);
 
+    /**
+     * @brief   Check if an action file is the one for a URL
+     * 
+     * @details Same result as urlToAction(path) == file without building the name
+     * 
+     * @param   path        Path portion of URL
+     * @param   file        Action file name
+     * 
+     * @return  true if file is the action file for path
+     */
+    static bool isActionFor(const char *path, const char *file);
+
     /**
      * @brief   Convert action file to URL
      * 
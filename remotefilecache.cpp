@@ -0,0 +1,280 @@
+//                  *****  RemoteFileCache class implementation  *****
+
+#include "remotefilecache.h"
+#include <stdio.h>
+#include <string.h>
+
+RemoteFileCache::RemoteFileCache(size_t budget) : tick_(0), budget_(budget)
+{
+    for (int ii = 0; ii < PAGE_CACHE_ENTRIES; ii++)
+    {
+        entries_[ii].used = 0;
+        entries_[ii].stale = false;
+    }
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+bool RemoteFileCache::get(const char *url, RemoteFile *&file)
+{
+    bool ret = true;
+    int slot = find(url);
+    if (slot >= 0)
+    {
+        ++stats_.hits;
+        entries_[slot].used = ++tick_;
+    }
+    else
+    {
+        ++stats_.misses;
+        slot = victim();
+        if (slot < 0)
+        {
+            ret = false;
+        }
+        else
+        {
+            if (entries_[slot].used != 0)
+            {
+                ++stats_.evictions;
+                drop(slot);
+            }
+            ret = entries_[slot].file.loadFile(RemoteFile::urlToAction(url).c_str());
+            if (ret)
+            {
+                entries_[slot].used = ++tick_;
+                trim(slot);
+            }
+            else
+            {
+                entries_[slot].file.clear();
+            }
+        }
+    }
+
+    file = slot >= 0 ? &entries_[slot].file : &none_;
+    return ret;
+}
+
+const RemoteFileCache::Page *RemoteFileCache::page(const RemoteFile *file, const std::string &variant) const
+{
+    const Page *ret = nullptr;
+    int slot = find(file);
+    if (slot >= 0 && !entries_[slot].page.header.empty() && entries_[slot].page.variant == variant)
+    {
+        ret = &entries_[slot].page;
+    }
+    return ret;
+}
+
+size_t RemoteFileCache::pageRoom(const RemoteFile *file) const
+{
+    size_t ret = 0;
+    int slot = find(file);
+    if (slot >= 0 && entries_[slot].file.dataSize() < budget_)
+    {
+        ret = budget_ - entries_[slot].file.dataSize();
+    }
+    return ret;
+}
+
+const RemoteFileCache::Page *RemoteFileCache::setPage(const RemoteFile *file, const std::string &variant,
+                                                      const std::string &header, std::string &body)
+{
+    const Page *ret = nullptr;
+    int slot = find(file);
+    if (slot >= 0)
+    {
+        ++stats_.renders;
+        Page &page = entries_[slot].page;
+
+        //  FNV-1a over the body
+        uint32_t hash = 2166136261u;
+        for (auto cp = body.cbegin(); cp != body.cend(); ++cp)
+        {
+            hash = (hash ^ static_cast<uint8_t>(*cp)) * 16777619u;
+        }
+        snprintf(page.etag, sizeof(page.etag), "\"%08lx-%lx\"",
+                 static_cast<unsigned long>(hash), static_cast<unsigned long>(body.length()));
+
+        char length[40];
+        snprintf(length, sizeof(length), "\r\nContent-Length: %u\r\n\r\n", static_cast<unsigned>(body.length()));
+        std::string().swap(page.body);
+        page.header = header;
+        page.header += "\r\nETag: ";
+        page.header += page.etag;
+        page.header += "\r\nCache-Control: no-cache";
+        page.header += length;
+        page.body.swap(body);
+        page.variant = variant;
+        ret = &page;
+
+        trim(slot);
+        if (entries_[slot].page.header.empty())
+        {
+            ret = nullptr;
+        }
+    }
+    return ret;
+}
+
+void RemoteFileCache::invalidate(const char *filename)
+{
+    for (int ii = 0; ii < PAGE_CACHE_ENTRIES; ii++)
+    {
+        if (entries_[ii].used != 0 && !entries_[ii].stale && strcmp(entries_[ii].file.filename(), filename) == 0)
+        {
+            ++stats_.invalidations;
+            release(ii);
+        }
+    }
+}
+
+void RemoteFileCache::invalidateAll()
+{
+    for (int ii = 0; ii < PAGE_CACHE_ENTRIES; ii++)
+    {
+        if (entries_[ii].used != 0 && !entries_[ii].stale)
+        {
+            ++stats_.invalidations;
+            release(ii);
+        }
+    }
+}
+
+void RemoteFileCache::getStats(Stats &stats) const
+{
+    stats = stats_;
+    stats.entries = 0;
+    stats.pages = 0;
+    for (int ii = 0; ii < PAGE_CACHE_ENTRIES; ii++)
+    {
+        stats.entries += entries_[ii].used != 0 ? 1 : 0;
+        stats.pages += entries_[ii].page.header.empty() ? 0 : 1;
+    }
+    stats.bytes = bytes();
+    stats.budget = budget_;
+}
+
+int RemoteFileCache::find(const char *url) const
+{
+    int ret = -1;
+    for (int ii = 0; ret < 0 && ii < PAGE_CACHE_ENTRIES; ii++)
+    {
+        if (entries_[ii].used != 0 && !entries_[ii].stale && RemoteFile::isActionFor(url, entries_[ii].file.filename()))
+        {
+            ret = ii;
+        }
+    }
+    return ret;
+}
+
+int RemoteFileCache::find(const RemoteFile *file) const
+{
+    int ret = -1;
+    for (int ii = 0; ret < 0 && ii < PAGE_CACHE_ENTRIES; ii++)
+    {
+        if (entries_[ii].used != 0 && !entries_[ii].stale && &entries_[ii].file == file)
+        {
+            ret = ii;
+        }
+    }
+    return ret;
+}
+
+int RemoteFileCache::victim() const
+{
+    //  Empty slot if there is one, then a stale one, otherwise least
+    //  recently used. Pinned slots are never chosen.
+    int ret = -1;
+    for (int ii = 0; ii < PAGE_CACHE_ENTRIES; ii++)
+    {
+        const Entry &entry = entries_[ii];
+        if (entry.used == 0 || !entry.file.pinned())
+        {
+            if (ret < 0)
+            {
+                ret = ii;
+            }
+            else
+            {
+                const Entry &best = entries_[ret];
+                int rank = entry.used == 0 ? 0 : (entry.stale ? 1 : 2);
+                int best_rank = best.used == 0 ? 0 : (best.stale ? 1 : 2);
+                if (rank < best_rank || (rank == best_rank && entry.used < best.used))
+                {
+                    ret = ii;
+                }
+            }
+        }
+    }
+    return ret;
+}
+
+void RemoteFileCache::trim(int keep)
+{
+    //  Evict oldest unpinned entries, then the kept entry's page, until
+    //  within budget. Pinned files stay even over budget.
+    while (bytes() > budget_)
+    {
+        int old = -1;
+        for (int ii = 0; ii < PAGE_CACHE_ENTRIES; ii++)
+        {
+            if (ii != keep && entries_[ii].used != 0 && !entries_[ii].file.pinned() &&
+                (old < 0 || entries_[ii].used < entries_[old].used))
+            {
+                old = ii;
+            }
+        }
+        if (old >= 0)
+        {
+            ++stats_.evictions;
+            drop(old);
+        }
+        else
+        {
+            std::string().swap(entries_[keep].page.header);
+            std::string().swap(entries_[keep].page.body);
+            break;
+        }
+    }
+}
+
+void RemoteFileCache::release(int slot)
+{
+    if (entries_[slot].file.pinned())
+    {
+        //  Cleared when found unpinned by victim or trim
+        Entry &entry = entries_[slot];
+        entry.stale = true;
+        std::string().swap(entry.page.header);
+        std::string().swap(entry.page.body);
+    }
+    else
+    {
+        drop(slot);
+    }
+}
+
+void RemoteFileCache::drop(int slot)
+{
+    Entry &entry = entries_[slot];
+    entry.file.clear();
+    std::string().swap(entry.page.header);
+    std::string().swap(entry.page.body);
+    entry.page.variant.clear();
+    entry.used = 0;
+    entry.stale = false;
+}
+
+size_t RemoteFileCache::bytes() const
+{
+    size_t ret = 0;
+    for (int ii = 0; ii < PAGE_CACHE_ENTRIES; ii++)
+    {
+        if (entries_[ii].used != 0)
+        {
+            ret += entries_[ii].file.dataSize() + entries_[ii].page.header.capacity() + entries_[ii].page.body.capacity();
+        }
+    }
+    return ret;
+}
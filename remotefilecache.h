@@ -0,0 +1,149 @@
+//                  *****  RemoteFileCache class  *****
+
+#ifndef REMOTEFILECACHE_H
+#define REMOTEFILECACHE_H
+
+#include "remotefile.h"
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef PAGE_CACHE_ENTRIES
+#define PAGE_CACHE_ENTRIES  6               // Maximum cached pages
+#endif
+#ifndef PAGE_CACHE_BUDGET
+#define PAGE_CACHE_BUDGET   (40 * 1024)     // Default byte budget (files and rendered pages)
+#endif
+
+/**
+ * @brief   Cache of parsed action files
+ * 
+ * @details Entries are fixed RemoteFile slots that are cleared, never freed,
+ *          when evicted. An entry pinned by a Command (RemoteFile::pin) is
+ *          neither evicted nor reloaded: a pinned entry that is invalidated
+ *          is only marked stale, and cleared once the last pin goes. The
+ *          cache goes over its budget rather than evict a pinned entry.
+ *          Each entry can also hold the rendered HTTP response for the page
+ *          with its ETag.
+ */
+class RemoteFileCache
+{
+public:
+    struct Stats
+    {
+        uint32_t        hits;               // Lookups served from cache
+        uint32_t        misses;             // Lookups that loaded the file
+        uint32_t        evictions;          // Entries evicted for space
+        uint32_t        invalidations;      // Entries dropped by invalidate
+        uint32_t        renders;            // Pages rendered
+        uint32_t        not_modified;       // 304 responses sent
+        int             entries;            // Entries in use
+        int             pages;              // Entries with a rendered page
+        size_t          bytes;              // File and page bytes held
+        size_t          budget;             // Byte budget
+    };
+
+    struct Page
+    {
+        std::string     header;             // HTTP response header (empty if no page)
+        std::string     body;               // Response body
+        std::string     variant;            // Render input not in the file (back URL)
+        char            etag[20];           // Quoted strong ETag
+    };
+
+private:
+    struct Entry
+    {
+        RemoteFile      file;               // Parsed action file
+        Page            page;               // Rendered page (header empty if none)
+        uint32_t        used;               // Last use tick (0 if empty)
+        bool            stale;              // Invalidated while pinned (not found by URL)
+    };
+    Entry               entries_[PAGE_CACHE_ENTRIES];   // Cache entries
+    uint32_t            tick_;              // Use counter
+    size_t              budget_;            // File byte budget
+    RemoteFile          none_;              // Empty file, returned when every slot is pinned
+    Stats               stats_;             // Statistics
+
+    int find(const char *url) const;
+    int find(const RemoteFile *file) const;
+    int victim() const;
+    void drop(int slot);
+    void release(int slot);
+    void trim(int keep);
+    size_t bytes() const;
+
+public:
+    RemoteFileCache(size_t budget = PAGE_CACHE_BUDGET);
+
+    /**
+     * @brief   Get the parsed action file for a URL
+     * 
+     * @details On a miss the file is loaded into the least recently used slot
+     *          and other entries are evicted, oldest first, until the cache
+     *          is within its byte budget. The newest entry and pinned
+     *          entries are always kept.
+     * 
+     * @param   url     Path portion of URL
+     * @param   file    Set to the file (empty if not loaded)
+     * 
+     * @return  true if the file is loaded (false if every slot is pinned)
+     */
+    bool get(const char *url, RemoteFile *&file);
+
+    /**
+     * @brief   Drop a cached file after it has been rewritten
+     * 
+     * @param   filename    Action file name
+     */
+    void invalidate(const char *filename);
+
+    /**
+     * @brief   Drop all cached files
+     */
+    void invalidateAll();
+
+    /**
+     * @brief   Get the rendered page for a cached file
+     * 
+     * @param   file    File returned by get
+     * @param   variant Render input not held in the file
+     * 
+     * @return  Pointer to page or null if not rendered for this variant
+     */
+    const Page *page(const RemoteFile *file, const std::string &variant) const;
+
+    /**
+     * @brief   Get the largest page body that can be stored for a file
+     * 
+     * @details The file itself counts against the budget, the other
+     *          entries can be evicted
+     * 
+     * @param   file    File returned by get
+     * 
+     * @return  Byte limit (0 if the file is not cached)
+     */
+    size_t pageRoom(const RemoteFile *file) const;
+
+    /**
+     * @brief   Store the rendered page for a cached file
+     * 
+     * @details Adds strong ETag, Cache-Control and Content-Length headers,
+     *          the ETag being a hash of the body. The page is not kept if the
+     *          file is not cached or the page does not fit the budget.
+     * 
+     * @param   file    File returned by get
+     * @param   variant Render input not held in the file
+     * @param   header  Header lines without Content-Length or the closing blank line
+     * @param   body    Page body, taken by the cache (left empty)
+     * 
+     * @return  Pointer to stored page or null if not kept
+     */
+    const Page *setPage(const RemoteFile *file, const std::string &variant, const std::string &header, std::string &body);
+
+    void notModified() { ++stats_.not_modified; }
+    void setBudget(size_t budget) { budget_ = budget; }
+    void getStats(Stats &stats) const;
+};
+
+#endif
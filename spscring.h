@@ -0,0 +1,87 @@
+//                  *****  SPSCRing class  *****
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+#include <atomic>
+#include <stdint.h>
+
+/**
+ * @brief   Lock-free single producer, single consumer ring
+ * 
+ * @details One core (or context) adds, the other removes. Each index is
+ *          written by one side only, so loads and stores with acquire and
+ *          release ordering are enough; no compare-and-swap is needed,
+ *          which the Cortex-M0+ does not have.
+ * 
+ * @tparam  T   Element type (copied in and out)
+ * @tparam  N   Capacity, a power of two
+ */
+template <typename T, int N>
+class SPSCRing
+{
+    static_assert(N > 0 && (N & (N - 1)) == 0, "SPSCRing capacity must be a power of two");
+
+private:
+    T                       ring_[N];       // Elements
+    std::atomic<uint32_t>   head_;          // Next to remove (written by the consumer)
+    std::atomic<uint32_t>   tail_;          // Next to add (written by the producer)
+
+public:
+    SPSCRing() : head_(0), tail_(0) {}
+
+    /**
+     * @brief   Add an element (producer)
+     * 
+     * @return  false if the ring is full
+     */
+    bool push(const T &item)
+    {
+        bool ret = false;
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) < N)
+        {
+            ring_[tail & (N - 1)] = item;
+            tail_.store(tail + 1, std::memory_order_release);
+            ret = true;
+        }
+        return ret;
+    }
+
+    /**
+     * @brief   Remove the oldest element (consumer)
+     * 
+     * @return  false if the ring is empty
+     */
+    bool pop(T &item)
+    {
+        bool ret = peek(item);
+        if (ret)
+        {
+            head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+        return ret;
+    }
+
+    /**
+     * @brief   Get the oldest element without removing it (consumer)
+     * 
+     * @return  false if the ring is empty
+     */
+    bool peek(T &item) const
+    {
+        bool ret = false;
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head != tail_.load(std::memory_order_acquire))
+        {
+            item = ring_[head & (N - 1)];
+            ret = true;
+        }
+        return ret;
+    }
+
+    int level() const { return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire); }
+    static int capacity() { return N; }
+};
+
+#endif
@@ -0,0 +1,79 @@
+//                  *****  URLPattern class implementation  *****
+
+#include "urlpattern.h"
+#include <string.h>
+
+bool URLPattern::match(const char *path, size_t len, Match &match) const
+{
+    bool ret = false;
+    match.base_len = 0;
+    match.number = -1;
+    if (!any_prefix_)
+    {
+        ret = matchAt(path, len, 0, match);
+    }
+    else
+    {
+        //  Longest base first, as the greedy (.*) did
+        for (size_t pos = len >= anchor_len_ ? len - anchor_len_ + 1 : 0; !ret && pos-- > 0; )
+        {
+            if (memcmp(path + pos, pattern_, anchor_len_) == 0)
+            {
+                ret = matchAt(path, len, pos, match);
+                if (ret)
+                {
+                    match.base_len = pos;
+                }
+            }
+        }
+    }
+    return ret;
+}
+
+bool URLPattern::matchAt(const char *path, size_t len, size_t pos, Match &match) const
+{
+    const char *pat = pattern_;
+    while (*pat)
+    {
+        if (*pat == '*')
+        {
+            return true;
+        }
+        else if (*pat == '[')
+        {
+            const char *end = strchr(pat, ']');
+            size_t ol = end - pat - 1;
+            if (pos + ol <= len && memcmp(path + pos, pat + 1, ol) == 0)
+            {
+                pos += ol;
+            }
+            pat = end + 1;
+        }
+        else if (*pat == '#')
+        {
+            size_t start = pos;
+            int number = 0;
+            while (pos < len && path[pos] >= '0' && path[pos] <= '9')
+            {
+                number = number < 100000 ? number * 10 + (path[pos] - '0') : number;
+                ++pos;
+            }
+            if (pos == start)
+            {
+                return false;
+            }
+            match.number = number;
+            ++pat;
+        }
+        else
+        {
+            if (pos >= len || path[pos] != *pat)
+            {
+                return false;
+            }
+            ++pos;
+            ++pat;
+        }
+    }
+    return pos == len;
+}
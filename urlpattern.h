@@ -0,0 +1,63 @@
+//                  *****  URLPattern class  *****
+
+#ifndef URLPATTERN_H
+#define URLPATTERN_H
+
+#include <string>
+#include <stddef.h>
+
+/**
+ * @brief   Precompiled URL path pattern
+ * 
+ * @details Replaces the std::regex URL tables. Pattern syntax:
+ *              *       At start: any prefix, captured as the base URL
+ *                      At end: any suffix
+ *              [text]  Optional literal text
+ *              #       One or more digits, captured as a number
+ *          Anything else must match exactly. The pattern is analyzed at
+ *          compile time so matching is a few compares with no allocation.
+ */
+class URLPattern
+{
+public:
+    struct Match
+    {
+        size_t          base_len;           // Length of the leading * capture
+        int             number;             // Value of # capture (-1 if none)
+
+        std::string base(const std::string &path) const { return path.substr(0, base_len); }
+    };
+
+private:
+    const char          *pattern_;          // Pattern following any leading *
+    bool                any_prefix_;        // Pattern starts with *
+    size_t              anchor_len_;        // Length of literal text following leading *
+
+    bool matchAt(const char *path, size_t len, size_t pos, Match &match) const;
+
+public:
+    constexpr URLPattern(const char *pattern)
+     : pattern_(pattern[0] == '*' ? pattern + 1 : pattern), any_prefix_(pattern[0] == '*'), anchor_len_(0)
+    {
+        while (pattern_[anchor_len_] != 0 && pattern_[anchor_len_] != '[' &&
+               pattern_[anchor_len_] != '#' && pattern_[anchor_len_] != '*')
+        {
+            ++anchor_len_;
+        }
+    }
+
+    /**
+     * @brief   Match a URL path
+     * 
+     * @param   path    Path to match
+     * @param   len     Length of path
+     * @param   match   Structure to receive captures
+     * 
+     * @return  true if the entire path matches
+     */
+    bool match(const char *path, size_t len, Match &match) const;
+    bool match(const std::string &path, Match &match) const { return this->match(path.c_str(), path.length(), match); }
+    bool match(const std::string &path) const { Match m; return this->match(path.c_str(), path.length(), m); }
+};
+
+#endif
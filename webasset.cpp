@@ -0,0 +1,157 @@
+//                  *****  WebAsset class implementation  *****
+
+#include "webasset.h"
+#include "web_files.h"
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+
+std::map<std::string, WebAsset *> WebAsset::assets_;
+
+const WebAsset *WebAsset::get(const std::string &name)
+{
+    WebAsset *ret = nullptr;
+    auto it = assets_.find(name);
+    if (it != assets_.end())
+    {
+        ret = it->second;
+    }
+    else
+    {
+        const char *data;
+        u16_t datalen;
+        std::string header;
+        const char *body;
+        size_t len;
+        if (WEB_FILES::get()->get_file(name, data, datalen) && split(data, datalen, header, body, len))
+        {
+            bool immutable = isFingerprinted(name);
+            ret = new WebAsset();
+            ret->plain_.body = body;
+            ret->plain_.len = len;
+            makeHeader(ret->plain_, header, nullptr, immutable);
+
+            ret->gzip_.body = nullptr;
+            ret->gzip_.len = 0;
+            std::string gzheader;
+            if (WEB_FILES::get()->get_file(name + ".gz", data, datalen)
+                && split(data, datalen, gzheader, body, len) && len < ret->plain_.len)
+            {
+                //  The header (Content-Type) of the original applies to both
+                ret->gzip_.body = body;
+                ret->gzip_.len = len;
+                makeHeader(ret->gzip_, header, "gzip", immutable);
+                makeHeader(ret->plain_, header, "", immutable);
+            }
+            assets_[name] = ret;
+        }
+    }
+    return ret;
+}
+
+bool WebAsset::split(const char *data, size_t datalen, std::string &header, const char *&body, size_t &len)
+{
+    bool ret = false;
+    header.clear();
+    for (const char *ptr = data; ptr + 4 <= data + datalen; ptr++)
+    {
+        if (memcmp(ptr, "\r\n\r\n", 4) == 0)
+        {
+            //  Keep the header lines except Content-Length
+            const char *line = data;
+            while (line < ptr + 2)
+            {
+                const char *eol = strstr(line, "\r\n");
+                if (strncasecmp(line, "Content-Length:", 15) != 0)
+                {
+                    header.append(line, eol - line + 2);
+                }
+                line = eol + 2;
+            }
+            body = ptr + 4;
+            len = data + datalen - body;
+            ret = true;
+            break;
+        }
+    }
+    return ret;
+}
+
+void WebAsset::makeHeader(Variant &var, const std::string &header, const char *encoding, bool immutable)
+{
+    var.header = header;
+    if (immutable)
+    {
+        var.header += "Cache-Control: public, max-age=31536000, immutable\r\n";
+    }
+    if (encoding != nullptr)
+    {
+        if (*encoding != 0)
+        {
+            var.header += "Content-Encoding: ";
+            var.header += encoding;
+            var.header += "\r\n";
+        }
+        var.header += "Vary: Accept-Encoding\r\n";
+    }
+    var.header += "Content-Length: " + std::to_string(var.len) + "\r\n\r\n";
+}
+
+bool WebAsset::isFingerprinted(const std::string &name)
+{
+    bool ret = false;
+    size_t ext = name.rfind('.');
+    if (ext != std::string::npos && ext > 9 && name[ext - 9] == '.')
+    {
+        ret = true;
+        for (size_t ii = ext - 8; ii < ext; ii++)
+        {
+            if (!isxdigit(name[ii]))
+            {
+                ret = false;
+            }
+        }
+    }
+    return ret;
+}
+
+bool WebAsset::accepts(const std::string &accept, const char *coding)
+{
+    bool ret = false;
+    size_t cl = strlen(coding);
+    size_t pos = 0;
+    while (!ret && pos < accept.length())
+    {
+        size_t end = accept.find(',', pos);
+        if (end == std::string::npos) end = accept.length();
+        while (pos < end && isspace(accept[pos])) pos++;
+        if (end - pos >= cl && strncasecmp(accept.c_str() + pos, coding, cl) == 0
+            && (pos + cl == end || accept[pos + cl] == ';' || isspace(accept[pos + cl])))
+        {
+            //  Refused only by an explicit q=0 (q=0, q=0.0, ...)
+            size_t q = accept.find("q=", pos + cl);
+            ret = true;
+            if (q < end)
+            {
+                ret = false;
+                for (const char *qp = accept.c_str() + q + 2; qp < accept.c_str() + end && !isspace(*qp); qp++)
+                {
+                    if (*qp >= '1' && *qp <= '9')
+                    {
+                        ret = true;
+                    }
+                }
+            }
+        }
+        pos = end + 1;
+    }
+    return ret;
+}
+
+bool WebAsset::send(WEB *web, ClientHandle client, bool gzip) const
+{
+    const Variant &var = gzip && hasGzip() ? gzip_ : plain_;
+    bool ret = web->send_data(client, var.header.c_str(), var.header.length());
+    ret = ret && web->send_data(client, var.body, var.len, WEB::STAT);
+    return ret;
+}
@@ -0,0 +1,83 @@
+//                  *****  WebAsset class  *****
+
+#ifndef WEBASSET_H
+#define WEBASSET_H
+
+#include "web.h"
+#include <map>
+#include <string>
+#include <stddef.h>
+
+/**
+ * @brief   Static web resource
+ * 
+ * @details Serves a WEB_FILES resource as is. If the build stored a gzip
+ *          variant (<name>.gz) that is smaller it is sent instead to clients
+ *          that accept gzip. The resource data is sent with WEB::STAT; only
+ *          the header is built here, once per asset. A fingerprinted name
+ *          (<name>.<hash>.<ext>, see WEB_HASH in CMakeLists.txt) never
+ *          changes content, so it is sent as immutable for a year.
+ */
+class WebAsset
+{
+private:
+    struct Variant
+    {
+        std::string     header;             // Complete HTTP header
+        const char      *body;              // Body (in the resource data)
+        size_t          len;                // Body length
+    };
+
+    Variant             plain_;             // Uncompressed resource
+    Variant             gzip_;              // Gzip variant (body null if none)
+
+    static std::map<std::string, WebAsset *> assets_;   // Loaded assets
+
+    WebAsset() {}
+    static bool split(const char *data, size_t datalen, std::string &header, const char *&body, size_t &len);
+    static void makeHeader(Variant &var, const std::string &header, const char *encoding, bool immutable);
+
+public:
+    /**
+     * @brief   Get an asset
+     * 
+     * @param   name    WEB_FILES resource name
+     * 
+     * @return  Asset or nullptr if the resource does not exist
+     */
+    static const WebAsset *get(const std::string &name);
+
+    /**
+     * @brief   Check Accept-Encoding for a content coding
+     * 
+     * @param   accept  Accept-Encoding header value
+     * @param   coding  Content coding ("gzip")
+     * 
+     * @return  true if the coding is listed and not refused with q=0
+     */
+    static bool accepts(const std::string &accept, const char *coding);
+
+    /**
+     * @brief   Check for a fingerprinted name
+     * 
+     * @param   name    Resource name
+     * 
+     * @return  true if name has the form <name>.<8 hex digits>.<ext>
+     */
+    static bool isFingerprinted(const std::string &name);
+
+    bool hasGzip() const { return gzip_.body != nullptr; }
+
+    /**
+     * @brief   Send the asset
+     * 
+     * @param   web     WEB object
+     * @param   client  Client handle
+     * @param   gzip    true if the client accepts gzip
+     * 
+     * @return  true if successful
+     */
+    bool send(WEB *web, ClientHandle client, bool gzip) const;
+};
+
+#endif